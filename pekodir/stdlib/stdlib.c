@@ -1,30 +1,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
-
-double floor(double x) {
-    long double xcopy=x<0?x*-1:x;
-    unsigned int zeros=0;
-    long double n=1;
-    for(n=1;xcopy>n*10;n*=10,++zeros);
-    for(xcopy-=n;zeros!=-1;xcopy-=n)
-        if(xcopy<0)
-        {
-            xcopy+=n;
-            n/=10;
-            --zeros;
-        }
-    xcopy+=n;
-    return x<0?(xcopy==0?x:x-(1-xcopy)):(x-xcopy);
-}
-
-double ceil(double num) {
-    int inum = (int)num;
-    if (num < 0 || num == (float)inum) {
-        return inum;
-    }
-    return inum + 1;
-}
+#include <math.h>
+#if defined(_WIN32) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#include <immintrin.h>
+#endif
 
 char *addstr(char *strg1, char *strg2) {
     int size = strlen(strg1) + strlen(strg2); 
@@ -85,4 +66,344 @@ double inputnum(char* q) {
     printf("%s", q);
     scanf(" %m[^\n]", &string);
     return strtod(string, 0);
-}
\ No newline at end of file
+}
+// A strview is a pointer into a string and a length, it isn't null terminated
+typedef struct strview {
+    char *ptr;
+    long long len;
+} strview;
+
+char *viewstr(char *ptr, long long len) {
+    char *str = (char *)malloc(len + 1);
+    memcpy(str, ptr, len);
+    str[len] = 0;
+    return str;
+}
+
+double printview(char *ptr, long long len) {
+    printf("%.*s\n", (int)len, ptr);
+    return 1.0;
+}
+
+int cmpview(char *a, long long a_len, char *b, long long b_len) {
+    if(a_len != b_len) {
+        return 1;
+    }
+    return memcmp(a, b, a_len);
+}
+
+long long findview(char *text, long long text_len, char *part, long long part_len) {
+    for(long long i = 0; i + part_len <= text_len; i++) {
+        if(!memcmp(text + i, part, part_len)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// The pieces point into text, only the array of views is allocated
+strview *splitview(char *text, long long text_len, char *sep, long long sep_len, long long *count) {
+    long long pieces = 1;
+    for(long long i = 0; sep_len && i + sep_len <= text_len; i++) {
+        if(!memcmp(text + i, sep, sep_len)) {
+            pieces++;
+            i += sep_len - 1;
+        }
+    }
+
+    strview *views = (strview *)malloc(pieces * sizeof(strview));
+    long long start = 0, n = 0;
+    for(long long i = 0; sep_len && i + sep_len <= text_len; i++) {
+        if(!memcmp(text + i, sep, sep_len)) {
+            views[n].ptr = text + start;
+            views[n++].len = i - start;
+            start = i + sep_len;
+            i += sep_len - 1;
+        }
+    }
+    views[n].ptr = text + start;
+    views[n++].len = text_len - start;
+
+    *count = n;
+    return views;
+}
+
+unsigned long long hashstr(char *str, unsigned long long seed) {
+    // FNV-1a, must stay in sync with ASTS::hashStr which picks the seeds of match statements
+    unsigned long long hash = 14695981039346656037ULL ^ seed;
+    while(*str) {
+        hash ^= (unsigned char)*str++;
+        hash *= 1099511628211ULL;
+    }
+    return hash ^ (hash >> 32);
+}
+
+// Tables for @memo functions. Arguments and results are passed as 64 bit words: numbers as the bits of the double,
+// strings as the pointer and bools as 0 or 1. kinds has one character per argument ('n', 's' or 'b')
+#define MEMO_THREADSAFE 1
+#define MEMO_STATS      2
+
+typedef struct memo_entry {
+    unsigned long long hash;
+    unsigned long long *args;
+    unsigned long long result;
+    struct memo_entry *next_in_bucket;
+    struct memo_entry *newer, *older; // the least recently used entry is evicted first
+} memo_entry;
+
+typedef struct memo_table {
+    char *name;
+    char *kinds;
+    int nargs;
+    int flags;
+    long long capacity, count, nbuckets;
+    memo_entry **buckets;
+    memo_entry *newest, *oldest;
+    unsigned long long hits, misses, evictions;
+    char lock;
+    struct memo_table *next_table;
+} memo_table;
+
+static memo_table *memo_tables = 0;
+static char memo_tables_lock = 0;
+
+static void memo_lock(char *lock) {
+    while(__atomic_test_and_set(lock, __ATOMIC_ACQUIRE));
+}
+
+static void memo_unlock(char *lock) {
+    __atomic_clear(lock, __ATOMIC_RELEASE);
+}
+
+static void memo_dump_stats(void) {
+    for(memo_table *t = memo_tables; t; t = t->next_table) {
+        unsigned long long calls = t->hits + t->misses;
+        printf("memo %s: %llu calls, %llu hits (%.1f%%), %llu evictions, %lld/%lld entries\n", t->name, calls, t->hits, calls ? 100.0 * t->hits / calls : 0.0, t->evictions, t->count, t->capacity);
+    }
+}
+
+memo_table *memo_open(memo_table **slot, char *name, long long capacity, char *kinds, int flags) {
+    memo_table *t = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    if(t) {
+        return t;
+    }
+
+    memo_lock(&memo_tables_lock);
+    t = *slot;
+    if(!t) {
+        t = calloc(1, sizeof(memo_table));
+        t->name = name;
+        t->kinds = kinds;
+        t->nargs = strlen(kinds);
+        t->flags = flags;
+        t->capacity = capacity;
+        t->nbuckets = 1;
+        while(t->nbuckets < capacity) {
+            t->nbuckets *= 2;
+        }
+        t->buckets = calloc(t->nbuckets, sizeof(memo_entry *));
+        if(!t->buckets) {
+            fprintf(stderr, "memo %s: not enough memory for %lld entries\n", name, capacity);
+            abort();
+        }
+
+        if((flags & MEMO_STATS) && !memo_tables) {
+            atexit(memo_dump_stats);
+        }
+        t->next_table = memo_tables;
+        memo_tables = t;
+
+        __atomic_store_n(slot, t, __ATOMIC_RELEASE);
+    }
+    memo_unlock(&memo_tables_lock);
+
+    return t;
+}
+
+static unsigned long long memo_hash(memo_table *t, unsigned long long *args) {
+    unsigned long long hash = 14695981039346656037ULL;
+    for(int i = 0; i < t->nargs; i++) {
+        if(t->kinds[i] == 's') {
+            hash = hashstr((char *)args[i], hash);
+        } else {
+            hash = (hash ^ args[i]) * 1099511628211ULL;
+            hash ^= hash >> 29;
+        }
+    }
+    return hash;
+}
+
+static memo_entry *memo_find(memo_table *t, unsigned long long hash, unsigned long long *args) {
+    for(memo_entry *e = t->buckets[hash & (t->nbuckets - 1)]; e; e = e->next_in_bucket) {
+        if(e->hash != hash) {
+            continue;
+        }
+
+        int same = 1;
+        for(int i = 0; i < t->nargs && same; i++) {
+            same = t->kinds[i] == 's' ? !strcmp((char *)e->args[i], (char *)args[i]) : e->args[i] == args[i];
+        }
+        if(same) {
+            return e;
+        }
+    }
+    return 0;
+}
+
+static void memo_unlink(memo_table *t, memo_entry *e) {
+    if(e->newer) e->newer->older = e->older; else t->newest = e->older;
+    if(e->older) e->older->newer = e->newer; else t->oldest = e->newer;
+}
+
+static void memo_push_newest(memo_table *t, memo_entry *e) {
+    e->newer = 0;
+    e->older = t->newest;
+    if(t->newest) t->newest->newer = e; else t->oldest = e;
+    t->newest = e;
+}
+
+int memo_lookup(memo_table *t, unsigned long long *args, unsigned long long *result) {
+    if(t->flags & MEMO_THREADSAFE) memo_lock(&t->lock);
+
+    memo_entry *e = memo_find(t, memo_hash(t, args), args);
+    if(e) {
+        memo_unlink(t, e);
+        memo_push_newest(t, e);
+        *result = e->result;
+        t->hits++;
+    } else {
+        t->misses++;
+    }
+
+    if(t->flags & MEMO_THREADSAFE) memo_unlock(&t->lock);
+    return e != 0;
+}
+
+void memo_insert(memo_table *t, unsigned long long *args, unsigned long long result) {
+    if(t->flags & MEMO_THREADSAFE) memo_lock(&t->lock);
+
+    unsigned long long hash = memo_hash(t, args);
+    memo_entry *e = memo_find(t, hash, args);
+
+    // Another thread computed the same call first
+    if(e) {
+        if(t->flags & MEMO_THREADSAFE) memo_unlock(&t->lock);
+        return;
+    }
+
+    if(t->count == t->capacity) {
+        memo_entry *old = t->oldest;
+        memo_unlink(t, old);
+
+        memo_entry **link = &t->buckets[old->hash & (t->nbuckets - 1)];
+        while(*link != old) {
+            link = &(*link)->next_in_bucket;
+        }
+        *link = old->next_in_bucket;
+
+        for(int i = 0; i < t->nargs; i++) {
+            if(t->kinds[i] == 's') free((char *)old->args[i]);
+        }
+        free(old->args);
+        free(old);
+        t->count--;
+        t->evictions++;
+    }
+
+    // Strings are copied so the key can't change under the table
+    e = malloc(sizeof(memo_entry));
+    e->hash = hash;
+    e->result = result;
+    e->args = malloc(sizeof(unsigned long long) * (t->nargs ? t->nargs : 1));
+    for(int i = 0; i < t->nargs; i++) {
+        e->args[i] = t->kinds[i] == 's' ? (unsigned long long)strdup((char *)args[i]) : args[i];
+    }
+
+    e->next_in_bucket = t->buckets[hash & (t->nbuckets - 1)];
+    t->buckets[hash & (t->nbuckets - 1)] = e;
+    memo_push_newest(t, e);
+    t->count++;
+
+    if(t->flags & MEMO_THREADSAFE) memo_unlock(&t->lock);
+}
+
+// With --alloc-stats the program's mallocs and reallocs go through these, so it prints how many buffers it allocated.
+// A realloc only counts when it's given null, since that's when it makes a new buffer
+static unsigned long long alloc_stats_count = 0;
+
+static void alloc_stats_dump(void) {
+    printf("allocations: %llu\n", alloc_stats_count);
+}
+
+void alloc_stats_open(void) {
+    atexit(alloc_stats_dump);
+}
+
+void *alloc_stats_malloc(size_t size) {
+    __atomic_add_fetch(&alloc_stats_count, 1, __ATOMIC_RELAXED);
+    return malloc(size);
+}
+
+void *alloc_stats_realloc(void *ptr, size_t size) {
+    if(!ptr) {
+        __atomic_add_fetch(&alloc_stats_count, 1, __ATOMIC_RELAXED);
+    }
+    return realloc(ptr, size);
+}
+
+#if defined(_WIN32) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+// The registers the os saves on a context switch, only read once cpuid says the os has turned xgetbv on
+#if defined(__clang__) || defined(__GNUC__)
+__attribute__((target("xsave")))
+#endif
+static unsigned long long os_saved_state(void) {
+    return _xgetbv(0);
+}
+#endif
+
+// For the resolvers of @multiversion functions, feature is the index of the name in ASTS::multiversion_features.
+// It runs before the program's relocations are done, so it can't call into other libraries
+int cpu_supports(int feature) {
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(_WIN32)
+    __builtin_cpu_init();
+    switch(feature) {
+        case 0: return __builtin_cpu_supports("avx");
+        case 1: return __builtin_cpu_supports("avx2");
+        case 2: return __builtin_cpu_supports("fma");
+        case 3: return __builtin_cpu_supports("bmi2");
+        case 4: return __builtin_cpu_supports("avx512f");
+        case 5: return __builtin_cpu_supports("avx512bw");
+        case 6: return __builtin_cpu_supports("avx512dq");
+        case 7: return __builtin_cpu_supports("avx512vl");
+    }
+#elif defined(_WIN32) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+    // There's no __builtin_cpu_supports for windows, so the feature bits are read with cpuid. The avx registers only
+    // count when the os saves them too, which xgetbv shows
+    int info[4], ext[4] = {0, 0, 0, 0};
+    __cpuid(info, 0);
+    int max_leaf = info[0];
+    __cpuid(info, 1);
+    if(max_leaf >= 7) {
+        __cpuidex(ext, 7, 0);
+    }
+
+    unsigned long long xcr0 = 0;
+    if(info[2] & (1 << 27)) {
+        xcr0 = os_saved_state();
+    }
+    int avx_saved = (xcr0 & 0x6) == 0x6;
+    int avx512_saved = (xcr0 & 0xe6) == 0xe6;
+
+    switch(feature) {
+        case 0: return avx_saved && (info[2] & (1 << 28));
+        case 1: return avx_saved && (ext[1] & (1 << 5));
+        case 2: return avx_saved && (info[2] & (1 << 12));
+        case 3: return (ext[1] & (1 << 8)) != 0;
+        case 4: return avx512_saved && (ext[1] & (1 << 16));
+        case 5: return avx512_saved && (ext[1] & (1 << 30));
+        case 6: return avx512_saved && (ext[1] & (1 << 17));
+        case 7: return avx512_saved && (ext[1] & (1u << 31));
+    }
+#endif
+    return 0;
+}
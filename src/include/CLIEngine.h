@@ -42,6 +42,44 @@ namespace CLIEngine {
         return flags;
     }
 
+    /**
+     * @brief Checks for a flag without a value, ex: --layout-report. These are read from argv because the lexer splits them on "-"
+     * 
+     * @param argc 
+     * @param argv 
+     * @param flag 
+     * @return true 
+     * @return false 
+     */
+    bool hasFlag(int argc, char *argv[], std::string flag) {
+        for(int i = 1; i < argc; i++) {
+            if(flag == argv[i]) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Gets the value of a flag written as flag=value, ex: -mattr=+avx2,+fma. Like hasFlag this reads argv, since the value can have "-" and "," in it
+     * 
+     * @param argc 
+     * @param argv 
+     * @param flag 
+     * @return std::string empty if the flag isn't given
+     */
+    std::string getFlagValue(int argc, char *argv[], std::string flag) {
+        for(int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if(arg.rfind(flag + "=", 0) == 0) {
+                return arg.substr(flag.size() + 1);
+            }
+        }
+
+        return "";
+    }
+
     std::vector<std::string> getIdentifiers(std::vector<PekoLexingEngine::token> input) {
         std::vector<std::string> identifiers;
 
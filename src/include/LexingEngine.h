@@ -27,19 +27,41 @@ namespace PekoLexingEngine {
         new_tk          = 18,
         object_tk       = 19,
         accessor_tk     = 20,
+        for_tk          = 21,
+        in_tk           = 22,
+        not_equal_tk    = 23,
+        less_equal_tk   = 24,
+        greater_equal_tk= 25,
+        not_tk          = 26,
+        bool_tk         = 27,
+        true_tk         = 28,
+        false_tk        = 29,
+        match_tk        = 30,
+        export_tk       = 31,
+        range_tk        = 32,
+        const_tk        = 33,
     };
 
     // Used to save the value and type of a variable
     struct token {
         std::string value;
         int         type;
+        int         line = 0; // where the token starts in its file, 0 for tokens the compiler made up
+        int         col  = 0;
+        int         file = 0; // the index of its file in source_files
     };
 
-    // Lexes a string into a list of tokens
-    std::vector<token> lex_str(std::string peko) {
+    std::vector<std::string> source_files; // the files the program was lexed from, the first is the one being compiled
+
+    // Lexes a string into a list of tokens, first_line is the line the string starts at in its file
+    std::vector<token> lex_str(std::string peko, int file = 0, int first_line = 1) {
         int index_in_string = 0;
         std::vector<token> tokenized;
 
+        int line = first_line;
+        int line_start = 0; // the index the current line starts at
+        int counted = 0; // how far into the string the lines have been counted
+
         // Loop through the string
         while(index_in_string < peko.size()) {
             // Skip spaces
@@ -49,6 +71,17 @@ namespace PekoLexingEngine {
                     if(index_in_string < peko.size()-1) index_in_string++;
                 }
             }
+
+            // Count the lines up to the token, comments and strings can span lines too
+            for(; counted < index_in_string; counted++) {
+                if(peko.at(counted) == '\n') {
+                    line++;
+                    line_start = counted + 1;
+                }
+            }
+
+            int tok_col = index_in_string - line_start + 1;
+            int first_tok = tokenized.size();
             
             if(isalpha(peko.at(index_in_string)) || peko.at(index_in_string) == '_') {
                 std::string identifier = "";
@@ -64,10 +97,24 @@ namespace PekoLexingEngine {
                     tokenized.push_back((token){identifier, let_tk});
                 } else if(identifier == "fn") {
                     tokenized.push_back((token){identifier, fn_tk});
-                } else if(identifier == "number") {
-                    tokenized.push_back((token){identifier, number_tk});
+                } else if(identifier == "number" || identifier == "f32" || identifier == "i32" || identifier == "i16" || identifier == "i8" || identifier == "u8" || identifier == "vec2" || identifier == "vec4" || identifier == "vec8") {
+                    // A number type followed by a ( converts a value to it, ex: f32(x), which is called like a function
+                    int next = index_in_string;
+                    while(next < peko.size() && peko.at(next) == ' ') {
+                        next++;
+                    }
+
+                    tokenized.push_back((token){identifier, next < peko.size() && peko.at(next) == '(' ? identifier_tk : number_tk});
                 } else if(identifier == "string") {
                     tokenized.push_back((token){identifier, string_tk});
+                } else if(identifier == "bool") {
+                    tokenized.push_back((token){identifier, bool_tk});
+                } else if(identifier == "true") {
+                    tokenized.push_back((token){identifier, true_tk});
+                } else if(identifier == "false") {
+                    tokenized.push_back((token){identifier, false_tk});
+                } else if(identifier == "not") {
+                    tokenized.push_back((token){identifier, not_tk});
                 } else if(identifier == "return") {
                     tokenized.push_back((token){identifier, return_tk});
                 } else if(identifier == "void") {
@@ -86,6 +133,16 @@ namespace PekoLexingEngine {
                     tokenized.push_back((token){identifier, new_tk});
                 } else if(identifier == "object") {
                     tokenized.push_back((token){identifier, object_tk});
+                } else if(identifier == "match") {
+                    tokenized.push_back((token){identifier, match_tk});
+                } else if(identifier == "export") {
+                    tokenized.push_back((token){identifier, export_tk});
+                } else if(identifier == "const") {
+                    tokenized.push_back((token){identifier, const_tk});
+                } else if(identifier == "for") {
+                    tokenized.push_back((token){identifier, for_tk});
+                } else if(identifier == "in") {
+                    tokenized.push_back((token){identifier, in_tk});
                 } else {
                     tokenized.push_back((token){identifier, identifier_tk});
                 }
@@ -108,7 +165,7 @@ namespace PekoLexingEngine {
 
 
                     if(index_in_string < peko.size()) index_in_string++;
-                } while(isdigit(peko.at(index_in_string)) || (peko.at(index_in_string) == '.' && !is_dec));
+                } while(isdigit(peko.at(index_in_string)) || (peko.at(index_in_string) == '.' && !is_dec && peko.at(index_in_string+1) != '.'));
 
                 index_in_string--;
 
@@ -155,12 +212,30 @@ namespace PekoLexingEngine {
             } else if(peko.at(index_in_string) == '=' && peko.at(index_in_string+1) == '=') {
                 index_in_string++;
                 tokenized.push_back((token){"==", equal_to_tk});
+            } else if(peko.at(index_in_string) == '!' && peko.at(index_in_string+1) == '=') {
+                index_in_string++;
+                tokenized.push_back((token){"!=", not_equal_tk});
+            } else if(peko.at(index_in_string) == '<' && peko.at(index_in_string+1) == '=') {
+                index_in_string++;
+                tokenized.push_back((token){"<=", less_equal_tk});
+            } else if(peko.at(index_in_string) == '>' && peko.at(index_in_string+1) == '=') {
+                index_in_string++;
+                tokenized.push_back((token){">=", greater_equal_tk});
+            } else if(peko.at(index_in_string) == '.' && peko.at(index_in_string+1) == '.') {
+                index_in_string++;
+                tokenized.push_back((token){"..", range_tk});
             } else if(peko.at(index_in_string) == '.') {
                 tokenized.push_back((token){".", accessor_tk});
             } else if(!isspace(peko.at(index_in_string))) {
                 tokenized.push_back((token){std::string(1, peko.at(index_in_string)), unknown_tk});
             }
 
+            for(int i = first_tok; i < tokenized.size(); i++) {
+                tokenized[i].line = line;
+                tokenized[i].col = tok_col;
+                tokenized[i].file = file;
+            }
+
             if(index_in_string < peko.size()-1) {index_in_string++;} else if(index_in_string >= peko.size()-1) {break;}
         }
 
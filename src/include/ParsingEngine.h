@@ -13,17 +13,23 @@ namespace PekoParsingEngine {
     int             get_prec(char op);
     bool            isop(char op);
     bool            isunop(char op);
+    std::vector<ASTS::attribute> parse_attributes();
 
     // Parsing of primitive types: strings and numbers
     std::unique_ptr<ASTS::ExpAST> parse_number();
     std::unique_ptr<ASTS::ExpAST> parse_string();
+    std::unique_ptr<ASTS::ExpAST> parse_bool();
 
     // Base parsing for expressions
+    std::unique_ptr<ASTS::ExpAST> located(std::unique_ptr<ASTS::ExpAST> ast, const PekoLexingEngine::token &tok);
     std::unique_ptr<ASTS::ExpAST> primary_parse();
+    std::unique_ptr<ASTS::ExpAST> primary_parse_node();
     std::unique_ptr<ASTS::ExpAST> secondary_parse();
+    std::unique_ptr<ASTS::ExpAST> secondary_parse_node();
     std::unique_ptr<ASTS::ExpAST> parse_rhs_binop(int exp_prec, std::unique_ptr<ASTS::ExpAST> LHS);
     std::unique_ptr<ASTS::ExpAST> parse_expr();
     std::unique_ptr<ASTS::ExpAST> parse_paren_expr();
+    std::unique_ptr<ASTS::ExpAST> parse_not_expr();
  
     // Basic parsing for more advanced expressions (ex: return statements, variable declarations)
     std::unique_ptr<ASTS::ExpAST> parse_return();
@@ -31,6 +37,9 @@ namespace PekoParsingEngine {
     std::unique_ptr<ASTS::ExpAST> parse_identifier();
     std::unique_ptr<ASTS::ExpAST> parse_if_expr(bool in_function);
     std::unique_ptr<ASTS::ExpAST> parse_loop_expr();
+    std::unique_ptr<ASTS::ExpAST> parse_for_expr();
+    std::unique_ptr<ASTS::ExpAST> parse_match_expr();
+    std::vector<ASTS::attribute> take_loop_hints(std::string keyword);
 
     // Parsing for functions
     std::vector<std::unique_ptr<ASTS::ExpAST>>  parse_block(); // parses a block of code that is encased in a {}
@@ -43,6 +52,7 @@ namespace PekoParsingEngine {
 
     std::unique_ptr<ASTS::ExpAST>               parse_array_acc();
     std::unique_ptr<ASTS::ExpAST>               parse_array_lit();
+    std::unique_ptr<ASTS::ExpAST>               parse_slice();
     
 
     // Different types for functions and variables
@@ -51,12 +61,17 @@ namespace PekoParsingEngine {
         string_ty,
         custom_ty,
         void_ty,
-        array_ty
+        array_ty,
+        bool_ty
     };
 
     std::vector<PekoLexingEngine::token> toks;
     int index_in_overall_tokens = 0; // the index that is used throughout the whole parser, and indicates the current token index
     bool inObject = false;
+    std::vector<ASTS::attribute> pending_attributes; // attributes written in front of the declaration being parsed
+    std::map<std::string, std::map<std::string, int>> field_uses; // how often each field of each object type is accessed, counted when the first object is parsed
+    bool field_uses_counted = false;
+    std::vector<std::map<std::string, bool>> scopes = {{}}; // the names declared in each block the parser is in, and whether they're const. The innermost one is the one a name refers to
 
     // A helper class that makes parsing much easier
     class PekoParser {
@@ -79,7 +94,10 @@ namespace PekoParsingEngine {
                     cur_tok.type == PekoLexingEngine::let_tk        || 
                     cur_tok.type == PekoLexingEngine::identifier_tk || 
                     cur_tok.type == PekoLexingEngine::new_line_tk   ||
-                    cur_tok.type == PekoLexingEngine::object_tk
+                    cur_tok.type == PekoLexingEngine::object_tk     ||
+                    cur_tok.type == PekoLexingEngine::export_tk     ||
+                    cur_tok.type == PekoLexingEngine::const_tk      ||
+                    cur_tok.value == "@"
                 )
             ) {
                 parsed_pekoscript.push_back(std::move(primary_parse()));
@@ -136,6 +154,45 @@ namespace PekoParsingEngine {
             ErrorHandler::cur_line++;
             index_in_overall_tokens++;
         }
+
+        // The copies of generics have no newlines, so the line is taken from the token when it has one
+        if(get_cur_tok().line) {
+            ErrorHandler::cur_line = get_cur_tok().line;
+        }
+    }
+
+    /**
+     * @brief Parses the attributes in front of a declaration, ex: @cold or @unroll(4)
+     * 
+     * @return std::vector<ASTS::attribute> 
+     */
+    std::vector<ASTS::attribute> parse_attributes() {
+        std::vector<ASTS::attribute> attributes;
+
+        while(get_cur_tok().value == "@") {
+            increase_index(); // eat the "@"
+
+            ASTS::attribute attr;
+            attr.name = get_cur_tok().value;
+            increase_index();
+
+            if(get_cur_tok().value == "(") {
+                increase_index();
+
+                while(get_cur_tok().value != ")" && index_in_overall_tokens < toks.size()-1) {
+                    if(get_cur_tok().value != ",") {
+                        attr.args.push_back(get_cur_tok().value);
+                    }
+                    increase_index();
+                }
+
+                increase_index(); // eat the ")"
+            }
+
+            attributes.push_back(attr);
+        }
+
+        return attributes;
     }
 
     /**
@@ -164,6 +221,31 @@ namespace PekoParsingEngine {
         }
     }
 
+    /**
+     * @brief Returns the precedence of a token, including the word and multi-character operators
+     * 
+     * @param tok the token that may be an operator
+     * @return int 
+     */
+    int get_tok_prec(PekoLexingEngine::token tok) {
+        switch(tok.type) {
+        case PekoLexingEngine::and_tk:
+            // "and" and "or" tokens have a precedence of 5
+            return 5;
+        case PekoLexingEngine::equal_to_tk:
+        case PekoLexingEngine::not_equal_tk:
+        case PekoLexingEngine::less_equal_tk:
+        case PekoLexingEngine::greater_equal_tk:
+            // "==" tokens as all other comparison operators have a precedence of 10 
+            return 10;
+        case PekoLexingEngine::range_tk:
+            // ".." ends the start of a slice, ex: s[i+1..j]
+            return -1;
+        default:
+            return get_prec(tok.value.at(0));
+        }
+    }
+
     /**
      * @brief Returns true if the provided character is an operator
      * 
@@ -227,6 +309,23 @@ namespace PekoParsingEngine {
      // ++++++++++ BASIC/PRIMARY PARSING ++++++++++ //
     // +++++++++++++++++++++++++++++++++++++++++++ //
 
+    /**
+     * @brief Gives an AST the position of the token it starts at, unless it already has one. The debug info made with -g uses it
+     * 
+     * @param ast 
+     * @param tok 
+     * @return std::unique_ptr<ASTS::ExpAST> 
+     */
+    std::unique_ptr<ASTS::ExpAST> located(std::unique_ptr<ASTS::ExpAST> ast, const PekoLexingEngine::token &tok) {
+        if(ast && !ast->line && tok.line) {
+            ast->line = tok.line;
+            ast->col  = tok.col;
+            ast->file = tok.file;
+        }
+
+        return ast;
+    }
+
     /**
      * @brief Looks at the current token and parses itself and its following tokens into an AST
      * 
@@ -234,6 +333,11 @@ namespace PekoParsingEngine {
      * @return std::unique_ptr<ASTS::ExpAST> 
      */
     std::unique_ptr<ASTS::ExpAST> primary_parse() {
+        auto start = get_cur_tok();
+        return located(primary_parse_node(), start);
+    }
+
+    std::unique_ptr<ASTS::ExpAST> primary_parse_node() {
         PekoLexingEngine::token cur_tok = get_cur_tok(); // store the current token in a more easy to use variable
 
         if(get_cur_tok().value == "[") {
@@ -242,9 +346,23 @@ namespace PekoParsingEngine {
             return parse_identifier();
             
         } else if(cur_tok.type == PekoLexingEngine::identifier_tk && toks.at(index_in_overall_tokens+1).value == "[") {
-            return parse_array_acc();
+            auto arr_acc = parse_array_acc();
+
+            // An array access can start a longer expression too, ex: v[0] * 2
+            if(arr_acc && get_tok_prec(get_cur_tok()) > 0) {
+                return parse_rhs_binop(0, std::move(arr_acc));
+            }
+
+            return arr_acc;
         } else if(cur_tok.type == PekoLexingEngine::identifier_tk && toks.at(index_in_overall_tokens+1).type == PekoLexingEngine::accessor_tk) {            
-            return parse_object_access();
+            auto obj_acc = parse_object_access();
+
+            // An object access can start a longer expression, ex: a.x + 1
+            if(obj_acc && get_tok_prec(get_cur_tok()) > 0) {
+                return parse_rhs_binop(0, std::move(obj_acc));
+            }
+
+            return obj_acc;
 
         // Parse numbers if the following token is not an operator
         } else if(cur_tok.type == PekoLexingEngine::num_tk && !isop(toks.at(index_in_overall_tokens+1).value.at(0)) && !iscomp(toks.at(index_in_overall_tokens+1).value)) {
@@ -266,6 +384,38 @@ namespace PekoParsingEngine {
         } else if(cur_tok.type == PekoLexingEngine::fn_tk) {
             return parse_function();
 
+        // Parse an exported function, which keeps external linkage in whole program mode
+        } else if(cur_tok.type == PekoLexingEngine::export_tk) {
+            increase_index(); // eat 'export'
+
+            if(get_cur_tok().type != PekoLexingEngine::fn_tk) {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m expected a function after export: \n" + std::to_string(ErrorHandler::cur_line) + "| " + "export \033[;0;31m" + get_cur_tok().value + "\033[0;0m");
+                return nullptr;
+            }
+
+            auto fn = parse_function();
+            if(auto *fn_ast = dynamic_cast<ASTS::FunctionExpAST*>(fn.get())) {
+                fn_ast->getProto()->exported = true;
+            }
+
+            return fn;
+
+        // Parse a const declaration, which is a variable that can't be assigned to again
+        } else if(cur_tok.type == PekoLexingEngine::const_tk && toks.at(index_in_overall_tokens+1).type != PekoLexingEngine::fn_tk) {
+            return parse_variable();
+
+        // Parse a const fn, which the compiler runs when it's called with constant arguments
+        } else if(cur_tok.type == PekoLexingEngine::const_tk) {
+            increase_index(); // eat 'const'
+
+            auto fn = parse_function();
+            if(auto fn_ast = dynamic_cast<ASTS::FunctionExpAST*>(fn.get())) {
+                fn_ast->getProto()->const_fn = true;
+                ASTS::const_fns[fn_ast->getProto()->getName()] = fn_ast;
+            }
+
+            return fn;
+
         // Parse a string literal if the following token is not an operator
         } else if(cur_tok.type == PekoLexingEngine::string_lit_tk && !isop(toks.at(index_in_overall_tokens+1).value.at(0)) && !iscomp(toks.at(index_in_overall_tokens+1).value)) {
             return parse_string();
@@ -278,6 +428,19 @@ namespace PekoParsingEngine {
         } else if(cur_tok.type == PekoLexingEngine::loop_tk) {
             return parse_loop_expr();
 
+        // Parse a for in statement
+        } else if(cur_tok.type == PekoLexingEngine::for_tk) {
+            return parse_for_expr();
+
+        // Parse a match statement
+        } else if(cur_tok.type == PekoLexingEngine::match_tk) {
+            return parse_match_expr();
+
+        // Parse the attributes of the declaration that follows them
+        } else if(cur_tok.value == "@") {
+            pending_attributes = parse_attributes();
+            return primary_parse();
+
         // Parse a class declaration
         } else if(isunop(get_cur_tok().value.at(0))) {
             toks.insert(toks.begin() + index_in_overall_tokens, (PekoLexingEngine::token){"0", PekoLexingEngine::num_tk});
@@ -298,10 +461,17 @@ namespace PekoParsingEngine {
      * @return std::unique_ptr<ASTS::ExpAST> 
      */
     std::unique_ptr<ASTS::ExpAST> secondary_parse() {
+        auto start = get_cur_tok();
+        return located(secondary_parse_node(), start);
+    }
+
+    std::unique_ptr<ASTS::ExpAST> secondary_parse_node() {
         auto cur_tok = get_cur_tok(); // save the current token in a easier to use form
 
         if(cur_tok.type == PekoLexingEngine::identifier_tk && toks.at(index_in_overall_tokens+1).value == "[") {
             return parse_array_acc();
+        } else if(cur_tok.type == PekoLexingEngine::identifier_tk && toks.at(index_in_overall_tokens+1).type == PekoLexingEngine::accessor_tk) {
+            return parse_object_access();
         } else if(cur_tok.type == PekoLexingEngine::identifier_tk) {
             return parse_identifier();
 
@@ -321,6 +491,14 @@ namespace PekoParsingEngine {
         } else if(cur_tok.type == PekoLexingEngine::string_lit_tk) {
             return parse_string();
 
+        // Parse a bool literal
+        } else if(cur_tok.type == PekoLexingEngine::true_tk || cur_tok.type == PekoLexingEngine::false_tk) {
+            return parse_bool();
+
+        // Parse a not expression
+        } else if(cur_tok.type == PekoLexingEngine::not_tk) {
+            return parse_not_expr();
+
         } else if(isunop(get_cur_tok().value.at(0))) {
             toks.insert(toks.begin() + index_in_overall_tokens, (PekoLexingEngine::token){"0", PekoLexingEngine::num_tk});
             return secondary_parse();
@@ -344,6 +522,19 @@ namespace PekoParsingEngine {
         return std::move(string_to_ast);
     }
 
+    /**
+     * @brief Takes a true or false literal and converts it to an ast
+     * 
+     * @param toks 
+     * @return std::unique_ptr<ASTS::ExpAST> 
+     */
+    std::unique_ptr<ASTS::ExpAST> parse_bool() {
+        auto bool_to_ast = std::make_unique<ASTS::BoolExpAST>(get_cur_tok().type == PekoLexingEngine::true_tk);
+
+        increase_index(); // "eat" the bools value from the parser
+        return std::move(bool_to_ast);
+    }
+
     /**
      * @brief Takes a number literal and converts it to an ast
      * 
@@ -367,15 +558,7 @@ namespace PekoParsingEngine {
     std::unique_ptr<ASTS::ExpAST> parse_rhs_binop(int exp_prec, std::unique_ptr<ASTS::ExpAST> LHS) {
         while(true) {
             // Get the precedence of the current token/operator
-            int tok_prec = 0;
-            if(get_cur_tok().type != PekoLexingEngine::and_tk && get_cur_tok().type != PekoLexingEngine::or_tk && get_cur_tok().type != PekoLexingEngine::equal_to_tk)
-                tok_prec = get_prec(get_cur_tok().value.at(0));
-            else if(get_cur_tok().type == PekoLexingEngine::and_tk || get_cur_tok().type == PekoLexingEngine::or_tk)
-                // "and" and "or" tokens have a precedence of 5
-                tok_prec = 5;
-            else if(get_cur_tok().type == PekoLexingEngine::equal_to_tk)
-                // "==" tokens as all other comparison operators have a precedence of 10 
-                tok_prec = 10;
+            int tok_prec = get_tok_prec(get_cur_tok());
 
             if(tok_prec < exp_prec) {
                 return LHS;
@@ -397,13 +580,7 @@ namespace PekoParsingEngine {
             }
 
             // Get the precedence of the next operator
-            int new_prec = 0;
-            if(get_cur_tok().type != PekoLexingEngine::and_tk && get_cur_tok().type != PekoLexingEngine::or_tk && get_cur_tok().type != PekoLexingEngine::equal_to_tk)
-                new_prec = get_prec(get_cur_tok().value.at(0));
-            else if(get_cur_tok().type == PekoLexingEngine::and_tk || get_cur_tok().type == PekoLexingEngine::or_tk)
-                new_prec = 5;
-            else if(get_cur_tok().type == PekoLexingEngine::equal_to_tk)
-                new_prec = 10;
+            int new_prec = get_tok_prec(get_cur_tok());
 
             // Parse the next part if the new token has a higher precedence than the original token
             if(tok_prec < new_prec) {
@@ -474,6 +651,28 @@ namespace PekoParsingEngine {
         return std::move(V);
     }
 
+    /**
+     * @brief Parses a not expression, which applies to the whole comparison that follows it (not a == b is not (a == b))
+     * 
+     * @param toks 
+     * @return std::unique_ptr<ASTS::ExpAST> 
+     */
+    std::unique_ptr<ASTS::ExpAST> parse_not_expr() {
+        increase_index(); // eat the not token
+
+        auto operand = secondary_parse();
+
+        if(ErrorHandler::isErr()) {
+            ErrorHandler::preverr = true;
+            operand = std::make_unique<ASTS::BoolExpAST>(false);
+        }
+
+        // Take every operator that binds tighter than "and" and "or"
+        operand = parse_rhs_binop(get_tok_prec((PekoLexingEngine::token){"and", PekoLexingEngine::and_tk}) + 1, std::move(operand));
+
+        return std::make_unique<ASTS::UnaryExpAST>("not", std::move(operand));
+    }
+
       // ++++++++++++++++++++++++++++++++++++++ //
      // ++++++++++ ADVANCED PARSING ++++++++++ //
     // ++++++++++++++++++++++++++++++++++++++ //
@@ -485,6 +684,18 @@ namespace PekoParsingEngine {
      * @return std::unique_ptr<ASTS::ExpAST> 
      */
     std::unique_ptr<ASTS::ExpAST> parse_return() {
+        auto attributes = pending_attributes;
+        pending_attributes.clear();
+
+        bool must_tail = false;
+        for(auto &attr : attributes) {
+            if(attr.name == "tailcall") {
+                must_tail = true;
+            } else {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m unknown return attribute: \n" + std::to_string(ErrorHandler::cur_line) + "| " + "\033[;0;31m@" + attr.name + "\033[0;0m return");
+            }
+        }
+
         increase_index(); // "eat" the return token
 
         // Get the value of the return'
@@ -497,31 +708,153 @@ namespace PekoParsingEngine {
 
         // create the AST for the return statement
         auto return_statement = std::make_unique<ASTS::ReturnExpAST>(std::move(return_value));
+        return_statement->must_tail = must_tail;
             
         return std::move(return_statement);
     }
 
+    /**
+     * @brief Checks that an attribute argument or array size is a whole number from 1 to max. std::stoi throws when the
+     * number doesn't fit, so the digits are added up here and it stops before they go past max
+     * 
+     * @param text 
+     * @param max the largest number allowed
+     * @return true if text is a whole number from 1 to max
+     */
+    bool whole_number_in(const std::string &text, long long max) {
+        if(text.empty() || text.find_first_not_of("0123456789") != std::string::npos) {
+            return false;
+        }
+
+        long long value = 0;
+        for(char digit : text) {
+            if(value > (max - (digit - '0')) / 10) {
+                return false;
+            }
+            value = value * 10 + (digit - '0');
+        }
+
+        return value >= 1;
+    }
+
+    /**
+     * @brief Reports an error for a fixed size array size that isn't a whole number from 1 to INT32_MAX, ex: number[0]
+     * 
+     * @param size 
+     */
+    void check_fixed_size(const std::string &size) {
+        if(!whole_number_in(size, INT32_MAX)) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m expected an array size from 1 to " + std::to_string(INT32_MAX) + ": [" + size + "]");
+        }
+    }
+
+    /**
+     * @brief Adds the sizes after the type at the current token to it when it is a fixed size array, ex: number[4].
+     * The current token is left on the last ]
+     * 
+     * @param type 
+     */
+    void parse_fixed_dims(std::pair<int, std::string> &type) {
+        while(
+            toks.at(index_in_overall_tokens+1).value == "[" &&
+            toks.at(index_in_overall_tokens+2).type == PekoLexingEngine::num_tk &&
+            toks.at(index_in_overall_tokens+3).value == "]"
+        ) {
+            check_fixed_size(toks.at(index_in_overall_tokens+2).value);
+            type = {array_ty, type.second + " " + toks.at(index_in_overall_tokens+2).value};
+            increase_index(); // eat the type or ]
+            increase_index(); // eat the [
+            increase_index(); // eat the size
+        }
+    }
+
+    /**
+     * @brief Turns the type at the current token into a slice if it is followed by [..], ex: number[..], or is a strview.
+     * The current token is left on the last token of the type
+     * 
+     * @param type 
+     */
+    void parse_slice_dim(std::pair<int, std::string> &type) {
+        if(type.first == custom_ty && type.second == "strview") {
+            type = {array_ty, "u8 .."};
+        } else if(
+            toks.at(index_in_overall_tokens+1).value == "[" &&
+            toks.at(index_in_overall_tokens+2).type == PekoLexingEngine::range_tk &&
+            toks.at(index_in_overall_tokens+3).value == "]"
+        ) {
+            type = {array_ty, type.second + " .."};
+            increase_index(); // eat the type
+            increase_index(); // eat the [
+            increase_index(); // eat the ..
+        }
+    }
+
     std::pair<int, std::string> parse_type() {
         std::pair<int, std::string> type;
+
+        // soa Type[] stores the fields of the objects in columns
+        std::string layout = "";
+        if(get_cur_tok().value == "soa" && toks.at(index_in_overall_tokens+1).type == PekoLexingEngine::identifier_tk && toks.at(index_in_overall_tokens+2).value == "[") {
+            layout = ".soa";
+            increase_index();
+        }
+
         if(toks.at(index_in_overall_tokens+1).value == "["){
-            std::string tname = get_cur_tok().value;
+            std::string tname = get_cur_tok().value + layout;
+            std::string written = get_cur_tok().value; // the type as it is in the code, for errors
+            bool fixed = false, growable = false, slice = false;
             increase_index();
             while(get_cur_tok().value == "[") {
-                tname += " +";
                 increase_index();
+
+                // A size makes the array fixed, ex: number[4] is stored as the 4 numbers instead of a pointer to them
+                if(get_cur_tok().type == PekoLexingEngine::num_tk) {
+                    check_fixed_size(get_cur_tok().value);
+                    tname += " " + get_cur_tok().value;
+                    written += "[" + get_cur_tok().value + "]";
+                    fixed = true;
+                    increase_index();
+                // A range makes a slice, which points into memory owned by something else, ex: number[..]
+                } else if(get_cur_tok().type == PekoLexingEngine::range_tk) {
+                    tname += " ..";
+                    written += "[..]";
+                    slice = true;
+                    increase_index();
+                } else {
+                    tname += " +";
+                    written += "[]";
+                    growable = true;
+                }
+
                 if(get_cur_tok().value == "]") {
                     increase_index();
                 } else {
                     return type;
                 }
             }
+
+            if(fixed && (growable || !layout.empty())) {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m an array type can't have both fixed sizes and growable dimensions or be soa: " + written);
+            }
+
+            if(slice && (fixed || growable || !layout.empty() || tname.find(" ..") != tname.rfind(" "))) {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m a slice type only has the one [..] dimension: " + written);
+            }
+
             type = {array_ty, tname};
         } else if(get_cur_tok().type == PekoLexingEngine::number_tk) {
-            type = {number_ty, "number"};
+            type = {number_ty, get_cur_tok().value};
             increase_index();
         } else if(get_cur_tok().type == PekoLexingEngine::string_tk) {
             type = {string_ty, "string"};
             increase_index();
+        } else if(get_cur_tok().type == PekoLexingEngine::bool_tk) {
+            type = {bool_ty, "bool"};
+            increase_index();
+        } else if(get_cur_tok().type == PekoLexingEngine::identifier_tk && get_cur_tok().value == "strview") {
+            // A strview is a slice of the bytes of a string
+            type = {array_ty, "u8 .."};
+            increase_index();
         } else if(get_cur_tok().type == PekoLexingEngine::identifier_tk) {
             type = {custom_ty, get_cur_tok().value};
             increase_index();
@@ -538,7 +871,8 @@ namespace PekoParsingEngine {
     std::string cur_var_name = "";
     std::unique_ptr<ASTS::ExpAST> parse_variable() {
         cur_var_name = "";
-        increase_index(); // eat the let token
+        bool is_const = get_cur_tok().type == PekoLexingEngine::const_tk;
+        increase_index(); // eat the let or const token
 
         // Save the variables name
         std::string var_name = "";
@@ -583,6 +917,8 @@ namespace PekoParsingEngine {
                 var_value = std::make_unique<ASTS::NumberExpAST>(0.0);
             } else if(type.first == string_ty) {
                 var_value = std::make_unique<ASTS::StringExpAST>("");
+            } else if(type.first == bool_ty) {
+                var_value = std::make_unique<ASTS::BoolExpAST>(false);
             }
         
         // If the declaration does set the initial value
@@ -605,13 +941,33 @@ namespace PekoParsingEngine {
             ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m expected ';' or '=': \n" + std::to_string(ErrorHandler::cur_line) + "| " +  toks.at(x-1).value + " " + toks.at(x).value + "\n" + spaces + "\033[;0;31m;|=^\033[0;0m");
         }
 
+        // A const has to be given its value where it's declared
+        if(is_const && !var_value) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m a const needs a value: \n" + std::to_string(ErrorHandler::cur_line) + "| " + "const \033[;0;31m" + var_name + "\033[0;0m");
+        }
+
+        scopes.back()[var_name] = is_const;
+
         // Create the variable AST
         auto variable_ptr = std::make_unique<ASTS::VariableExpAST>(var_name, type, std::move(var_value));
+        variable_ptr->is_const = is_const;
         cur_var_name = "";
 
         return std::move(variable_ptr);
     }
 
+    /**
+     * @brief Prints an error when a const is assigned to, ex: const limit: number = 10; limit = 11;
+     * 
+     * @param name 
+     */
+    void check_not_const(const std::string &name) {
+        auto scope = std::find_if(scopes.rbegin(), scopes.rend(), [&](const std::map<std::string, bool> &names) { return names.count(name); });
+        if(scope != scopes.rend() && scope->at(name)) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m can't assign to a const: \n" + std::to_string(ErrorHandler::cur_line) + "| " + "\033[;0;31m" + name + "\033[0;0m = ...");
+        }
+    }
+
     /**
      * @brief Parse an identifier to eithernumber_ty a variable re-assignment, variable reference, or a function call
      * 
@@ -642,6 +998,8 @@ namespace PekoParsingEngine {
             ) 
             && toks.at(index_in_overall_tokens+1).value == "="
         ) {
+            check_not_const(identifier);
+
             // skip the assignment tokens after saving the op
             std::string op = get_cur_tok().value;
             increase_index(); 
@@ -666,6 +1024,7 @@ namespace PekoParsingEngine {
 
         // Otherwise we create a variable re-assignment
         } else if(get_cur_tok().value == "=" && !inObject) {
+            check_not_const(identifier);
             increase_index();
             return std::make_unique<ASTS::VariableExpAST>(identifier, std::pair<int, std::string>({-1, "redec"}), std::move(primary_parse()));
         } else if(get_cur_tok().value == "=" && inObject) {
@@ -788,6 +1147,31 @@ namespace PekoParsingEngine {
         return std::move(iff);
     }
 
+    /**
+     * @brief Takes the attributes in front of a loop or for statement and checks that they are loop hints with a valid count
+     * 
+     * @param keyword the statement the hints are on, for errors
+     * @return std::vector<ASTS::attribute> 
+     */
+    std::vector<ASTS::attribute> take_loop_hints(std::string keyword) {
+        auto hints = pending_attributes;
+        pending_attributes.clear();
+
+        for(auto &hint : hints) {
+            bool counted = hint.name == "unroll" || hint.name == "vectorize" || hint.name == "interleave";
+
+            if(!counted && hint.name != "independent") {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m unknown loop attribute: \n" + std::to_string(ErrorHandler::cur_line) + "| " + "\033[;0;31m@" + hint.name + "\033[0;0m " + keyword);
+            } else if(counted && (hint.args.size() != 1 || !whole_number_in(hint.args[0], INT32_MAX))) {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m expected a whole number from 1 to " + std::to_string(INT32_MAX) + ": \n" + std::to_string(ErrorHandler::cur_line) + "| " + "\033[;0;31m@" + hint.name + "(...)\033[0;0m " + keyword);
+            } else if(!counted && !hint.args.empty()) {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m @independent doesn't take arguments: \n" + std::to_string(ErrorHandler::cur_line) + "| " + "\033[;0;31m@" + hint.name + "(...)\033[0;0m " + keyword);
+            }
+        }
+
+        return hints;
+    }
+
     /**
      * @brief Parses a loop expression into an AST
      * 
@@ -795,6 +1179,7 @@ namespace PekoParsingEngine {
      * @return std::unique_ptr<ASTS::ExpAST> 
      */
     std::unique_ptr<ASTS::ExpAST> parse_loop_expr() {
+        auto hints = take_loop_hints("loop");
         increase_index(); // eat the loop token
 
         auto condition = parse_paren_expr(); // parse the condition
@@ -806,7 +1191,125 @@ namespace PekoParsingEngine {
         increase_index(); // eat the "}"
         auto cont      = parse_block(); // get the code after the for loop
 
-        return std::make_unique<ASTS::LoopExpAST>(std::move(condition), std::move(for_body), std::move(cont));
+        auto loop = std::make_unique<ASTS::LoopExpAST>(std::move(condition), std::move(for_body), std::move(cont));
+        loop->hints = hints;
+
+        return loop;
+    }
+
+    /**
+     * @brief Parses a for in expression (for x in collection {...}) into an AST
+     * 
+     * @param toks 
+     * @return std::unique_ptr<ASTS::ExpAST> 
+     */
+    std::unique_ptr<ASTS::ExpAST> parse_for_expr() {
+        auto hints = take_loop_hints("for");
+        increase_index(); // eat the for token
+
+        // Save the name the elements will be bound to
+        std::string elem_name = "";
+        if(get_cur_tok().type == PekoLexingEngine::identifier_tk) {
+            elem_name = get_cur_tok().value;
+        } else {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m expected identifier: \n" + std::to_string(ErrorHandler::cur_line) + "| " +  "for \033[;0;31m" + get_cur_tok().value + "\033[0;0m in ...");
+            elem_name = "fail";
+        }
+
+        increase_index(); // eat the identifier
+
+        if(get_cur_tok().type == PekoLexingEngine::in_tk) {
+            increase_index(); // eat the in token
+        } else {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m expected 'in': \n" + std::to_string(ErrorHandler::cur_line) + "| " +  "for " + elem_name + " \033[;0;31m" + get_cur_tok().value + "\033[0;0m...");
+        }
+
+        auto collection = primary_parse(); // parse the collection that will be iterated over
+        if(ErrorHandler::isErr()) {
+            collection = std::make_unique<ASTS::NumberExpAST>(0);
+        }
+
+        scopes.push_back({{elem_name, false}});
+        auto for_body  = parse_block(); // parse the code to be ran for every element
+        scopes.pop_back();
+        increase_index(); // eat the "}"
+        auto cont      = parse_block(); // get the code after the for loop
+
+        auto for_loop = std::make_unique<ASTS::ForExpAST>(elem_name, std::move(collection), std::move(for_body), std::move(cont));
+        for_loop->hints = hints;
+
+        return for_loop;
+    }
+
+    /**
+     * @brief Parses a match statement into an AST
+     * match(value) {
+     *     1, 2 { ... }
+     *     "name" { ... }
+     *     else { ... }
+     * }
+     * 
+     * @param toks 
+     * @return std::unique_ptr<ASTS::ExpAST> 
+     */
+    std::unique_ptr<ASTS::ExpAST> parse_match_expr() {
+        increase_index(); // eat the match token
+
+        auto subject = parse_paren_expr(); // parse the value being matched
+        if(ErrorHandler::isErr()) {
+            subject = std::make_unique<ASTS::NumberExpAST>(0);
+        }
+
+        if(get_cur_tok().value == "{") {
+            increase_index(); // eat the "{"
+        } else {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m expected '{': \n" + std::to_string(ErrorHandler::cur_line) + "| " +  "match(...) \033[;0;31m" + get_cur_tok().value + "\033[0;0m");
+            return nullptr;
+        }
+
+        std::vector<ASTS::match_case> cases;
+        std::vector<std::unique_ptr<ASTS::ExpAST>> els = {};
+
+        while(get_cur_tok().value != "}" && index_in_overall_tokens < toks.size()-1) {
+            // parse the default case
+            if(get_cur_tok().type == PekoLexingEngine::else_tk) {
+                increase_index();
+                els = parse_block();
+                increase_index(); // eat the "}"
+                continue;
+            }
+
+            // parse the literals of the case
+            ASTS::match_case cur_case;
+            while(get_cur_tok().value != "{") {
+                if(get_cur_tok().value == "-" && toks.at(index_in_overall_tokens+1).type == PekoLexingEngine::num_tk) {
+                    increase_index();
+                    cur_case.values.push_back(std::make_unique<ASTS::NumberExpAST>(-stod(get_cur_tok().value)));
+                    increase_index();
+                } else if(get_cur_tok().type == PekoLexingEngine::num_tk) {
+                    cur_case.values.push_back(parse_number());
+                } else if(get_cur_tok().type == PekoLexingEngine::string_lit_tk) {
+                    cur_case.values.push_back(parse_string());
+                } else {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m expected a number or string literal: \n" + std::to_string(ErrorHandler::cur_line) + "| " +  "match(...) {... \033[;0;31m" + get_cur_tok().value + "\033[0;0m");
+                    return nullptr;
+                }
+
+                if(get_cur_tok().value == ",") {
+                    increase_index(); // continue if ','
+                }
+            }
+
+            cur_case.body = parse_block();
+            increase_index(); // eat the "}"
+
+            cases.push_back(std::move(cur_case));
+        }
+
+        increase_index(); // eat the "}"
+        auto cont = parse_block(); // get the code after the match statement
+
+        return std::make_unique<ASTS::MatchExpAST>(std::move(subject), std::move(cases), std::move(els), std::move(cont));
     }
 
       // ++++++++++++++++++++++++++++++++++++++ //
@@ -824,6 +1327,9 @@ namespace PekoParsingEngine {
         
         if(get_cur_tok().value == "{")
             increase_index(); // eat the "{"
+
+        // What's declared in the block ends with it
+        scopes.push_back({});
         
         while(index_in_overall_tokens < toks.size() && get_cur_tok().value != "}") {
             if(get_cur_tok().value == ";" || get_cur_tok().value == "\n" || get_cur_tok().value == ")")
@@ -841,6 +1347,8 @@ namespace PekoParsingEngine {
             if(get_cur_tok().value == "}")
                 break;
         }
+
+        scopes.pop_back();
         
         return block;
     }
@@ -885,11 +1393,29 @@ namespace PekoParsingEngine {
         }
         
         std::vector<std::pair<std::string, std::pair<int, std::string>>> proto_args;
+        std::set<std::string> noalias_args;
+        std::set<std::string> const_args;
 
         // Parse the arguments
         while(get_cur_tok().value != ")") {
             std::pair<std::string, std::pair<int, std::string>> cur_arg;
 
+            // Arguments can be marked @noalias when nothing else the function sees points at the same memory
+            auto arg_attrs = parse_attributes();
+            for(auto &attr : arg_attrs) {
+                if(attr.name == "noalias" && get_cur_tok().type == PekoLexingEngine::identifier_tk) {
+                    noalias_args.insert(get_cur_tok().value);
+                } else {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m unknown argument attribute: \n" + std::to_string(ErrorHandler::cur_line) + "| " +  "fn " + proto_name + "(...\033[;0;31m@" + attr.name + "\033[0;0m " + get_cur_tok().value + "...)");
+                }
+            }
+
+            // A const argument can't be assigned to, and an object or array passed as one is only read
+            if(get_cur_tok().type == PekoLexingEngine::const_tk) {
+                increase_index(); // eat 'const'
+                const_args.insert(get_cur_tok().value);
+            }
+
             // the argument name should be an identifer
             if(get_cur_tok().type == PekoLexingEngine::identifier_tk) { 
                 cur_arg.first = get_cur_tok().value; // set the arguments name to the current tokens value
@@ -921,9 +1447,11 @@ namespace PekoParsingEngine {
 
             // The next token should be a type
             if(get_cur_tok().type == PekoLexingEngine::number_tk) {
-                cur_arg.second = {number_ty, "number"};
+                cur_arg.second = {number_ty, get_cur_tok().value};
             } else if(get_cur_tok().type == PekoLexingEngine::string_tk) {
                 cur_arg.second = {string_ty, "string"};
+            } else if(get_cur_tok().type == PekoLexingEngine::bool_tk) {
+                cur_arg.second = {bool_ty, "bool"};
             } else if(get_cur_tok().type == PekoLexingEngine::identifier_tk) {
                 cur_arg.second = {custom_ty, get_cur_tok().value};
 
@@ -934,6 +1462,15 @@ namespace PekoParsingEngine {
                 ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m expected a type: \n" + std::to_string(ErrorHandler::cur_line) + "| " +  "fn " + proto_name + "(..." + cur_arg.first + ": \033[0;31m" + toks.at(x).value + "\033[0;0m...)");
             }
 
+            parse_fixed_dims(cur_arg.second);
+            parse_slice_dim(cur_arg.second);
+
+            // Only objects, strings and fixed size arrays are passed as pointers, slices are passed as their pointer and length
+            bool is_slice = cur_arg.second.second.size() > 3 && cur_arg.second.second.substr(cur_arg.second.second.size() - 3) == " ..";
+            if(noalias_args.count(cur_arg.first) && ((cur_arg.second.first != custom_ty && cur_arg.second.first != string_ty && cur_arg.second.first != array_ty) || is_slice)) {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m @noalias can only be used on objects, strings and fixed size arrays: \n" + std::to_string(ErrorHandler::cur_line) + "| " +  "fn " + proto_name + "(...\033[;0;31m@noalias " + cur_arg.first + ": " + cur_arg.second.second + "\033[0;0m...)");
+            }
+
             // add the current argument to the list of args for this prototype
             proto_args.push_back(std::move(cur_arg));
 
@@ -979,9 +1516,11 @@ namespace PekoParsingEngine {
 
         // Store the type of the function
         if(get_cur_tok().type == PekoLexingEngine::number_tk) {
-            proto_type = {number_ty, "number"};
+            proto_type = {number_ty, get_cur_tok().value};
         } else if(get_cur_tok().type == PekoLexingEngine::string_tk) {
             proto_type = {string_ty, "string"};
+        } else if(get_cur_tok().type == PekoLexingEngine::bool_tk) {
+            proto_type = {bool_ty, "bool"};
         } else if(get_cur_tok().type == PekoLexingEngine::identifier_tk) {
             proto_type = {custom_ty, get_cur_tok().value};
         } else if(get_cur_tok().type == PekoLexingEngine::void_tk) {
@@ -993,9 +1532,14 @@ namespace PekoParsingEngine {
             
             ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m expected type: \n" + std::to_string(ErrorHandler::cur_line) + "| " +  "fn " + proto_name + "(...): " + "\033[;0;31m" + toks.at(x).value + "\033[0;0m");
         }
+
+        // A function can return a slice of memory it was given, ex: fn field(line: strview): strview
+        parse_slice_dim(proto_type);
         
         // create the AST for the prototype
         auto proto = std::make_unique<ASTS::ProtoAST>(proto_name, proto_args, proto_type);
+        proto->noalias_args = noalias_args;
+        proto->const_args = const_args;
         
         return proto;
     }
@@ -1007,12 +1551,54 @@ namespace PekoParsingEngine {
      * @return std::unique_ptr<ASTS::ExpAST> 
      */
     std::unique_ptr<ASTS::ExpAST> parse_function() {
+        auto attributes = pending_attributes;
+        pending_attributes.clear();
+
         std::unique_ptr<ASTS::ProtoAST> fn_proto = parse_proto(); // parse the functions prototype
 
         if(!fn_proto) {
             fn_proto = std::make_unique<ASTS::ProtoAST>("failed", (std::vector<std::pair<std::string, std::pair<int, std::string>>>){}, (std::pair<int, std::string>){void_ty, "void"});
         }
 
+        std::set<std::string> known = {"inline", "noinline", "hot", "cold", "pure", "memo", "fastmath", "multiversion"};
+        std::set<std::string> fast_math_flags = {"fast", "reassoc", "contract", "nnan", "ninf", "nsz", "arcp", "afn"};
+        std::set<std::string> names;
+        for(auto &attr : attributes) {
+            if(!known.count(attr.name)) {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m unknown function attribute: \n" + std::to_string(ErrorHandler::cur_line) + "| " + "\033[;0;31m@" + attr.name + "\033[0;0m fn " + fn_proto->getName());
+            }
+
+            // @memo(capacity, threadsafe), both are optional
+            for(auto &arg : attr.args) {
+                if(attr.name == "memo" && arg != "threadsafe" && !whole_number_in(arg, ASTS::max_memo_capacity)) {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m expected a capacity from 1 to " + std::to_string(ASTS::max_memo_capacity) + " or threadsafe: \n" + std::to_string(ErrorHandler::cur_line) + "| " + "@memo(\033[;0;31m" + arg + "\033[0;0m) fn " + fn_proto->getName());
+                }
+
+                // @fastmath(reassoc, contract, ...) names the flags llvm gets
+                // @multiversion(avx2, avx512f) names the cpu features there are copies for
+                if(attr.name == "multiversion" && std::find(ASTS::multiversion_features.begin(), ASTS::multiversion_features.end(), arg) == ASTS::multiversion_features.end()) {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m unknown cpu feature, expected avx, avx2, fma, bmi2, avx512f, avx512bw, avx512dq or avx512vl: \n" + std::to_string(ErrorHandler::cur_line) + "| " + "@multiversion(\033[;0;31m" + arg + "\033[0;0m) fn " + fn_proto->getName());
+                }
+
+                if(attr.name == "fastmath" && !fast_math_flags.count(arg)) {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m unknown fast math flag, expected fast, reassoc, contract, nnan, ninf, nsz, arcp or afn: \n" + std::to_string(ErrorHandler::cur_line) + "| " + "@fastmath(\033[;0;31m" + arg + "\033[0;0m) fn " + fn_proto->getName());
+                }
+            }
+
+            if(attr.name == "multiversion" && attr.args.empty()) {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m @multiversion needs the cpu features to make copies for, ex: @multiversion(avx2, avx512f): \n" + std::to_string(ErrorHandler::cur_line) + "| " + "\033[;0;31m@multiversion\033[0;0m fn " + fn_proto->getName());
+            }
+
+            names.insert(attr.name);
+        }
+
+        // These pairs ask llvm for opposite things
+        if((names.count("inline") && names.count("noinline")) || (names.count("hot") && names.count("cold"))) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m conflicting function attributes: \n" + std::to_string(ErrorHandler::cur_line) + "| " + "fn " + fn_proto->getName());
+        }
+
+        fn_proto->attributes = attributes;
+
         increase_index(); // eat the type token
 
         // print an error if the current token is not a "{"
@@ -1025,7 +1611,14 @@ namespace PekoParsingEngine {
             ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m expected '{': \n" + std::to_string(ErrorHandler::cur_line) + "| " +  "fn " + fn_proto->getName() + "(...)\n" + spaces + "\033[;0;31m{^\033[0;0m");
         }
 
+        // The arguments hide the globals with their names
+        scopes.push_back({});
+        for(auto &arg : fn_proto->getArgs()) {
+            scopes.back()[arg.first] = fn_proto->const_args.count(arg.first);
+        }
+
         std::vector<std::unique_ptr<ASTS::ExpAST>> fn_body = parse_block(); // parse the functions contents
+        scopes.pop_back();
 
         // create the functions AST
         auto fn_ast = std::make_unique<ASTS::FunctionExpAST>(std::move(fn_proto), std::move(fn_body));
@@ -1043,7 +1636,131 @@ namespace PekoParsingEngine {
         std::vector<custom_type_attr> attributes;
     };
 
+    /**
+     * @brief Gets the object type an expression ending at a token is, ex: p.pos for the token pos when p is a Body with a pos: Vec.
+     * Arrays give the type of their elements
+     * 
+     * @param end the index of the last token of the expression, an identifier or the ] of an index
+     * @param var_types the object type of the variables declared so far
+     * @param field_types the object type of the fields of every object
+     * @param this_type the object whose method the expression is in
+     * @return std::string "" if the type isn't known
+     */
+    std::string expr_object_type(int end, std::map<std::string, std::string> &var_types, std::map<std::string, std::map<std::string, std::string>> &field_types, const std::string &this_type) {
+        if(end <= 0) {
+            return "";
+        }
+
+        // An index into an array is the type of the array's elements
+        if(toks.at(end).value == "]") {
+            int depth = 0;
+            for(int i = end; i > 0; i--) {
+                depth += toks.at(i).value == "]" ? 1 : toks.at(i).value == "[" ? -1 : 0;
+                if(depth == 0) {
+                    return expr_object_type(i - 1, var_types, field_types, this_type);
+                }
+            }
+            return "";
+        }
+
+        if(toks.at(end).type != PekoLexingEngine::identifier_tk) {
+            return "";
+        }
+
+        if(toks.at(end-1).type == PekoLexingEngine::accessor_tk) {
+            std::string owner = expr_object_type(end - 2, var_types, field_types, this_type);
+            return owner.empty() || !field_types[owner].count(toks.at(end).value) ? "" : field_types[owner][toks.at(end).value];
+        } else if(toks.at(end).value == "this") {
+            return this_type;
+        }
+
+        return var_types.count(toks.at(end).value) ? var_types[toks.at(end).value] : "";
+    }
+
+    /**
+     * @brief Counts how often each field of each object type is accessed in the program, ex: p.x where p is a Point counts x for Point.
+     * The type of what is in front of the . is taken from the variables, arguments and fields declared with an object type, this in
+     * a method and the element of a for loop. Accesses whose type isn't known from those, like on what a call returns, aren't counted
+     */
+    void count_field_uses() {
+        // The object type each field and variable is declared with, ex: pos: Vec or ps: soa Particle[]
+        std::map<std::string, std::map<std::string, std::string>> field_types;
+        std::map<std::string, std::string> var_types;
+        auto declared_type = [&](int colon) {
+            int t = colon + 1;
+            if(t + 1 < toks.size() && toks.at(t).value == "soa" && toks.at(t+1).type == PekoLexingEngine::identifier_tk) {
+                t++;
+            }
+            return t < toks.size() && toks.at(t).type == PekoLexingEngine::identifier_tk ? toks.at(t).value : "";
+        };
+
+        // The fields are declared straight inside the object's braces, everything deeper is in its methods
+        for(int pass = 0; pass < 2; pass++) {
+            std::string cur_object = "";
+            int depth = 0, object_depth = -1, parens = 0;
+
+            for(int i = 0; i + 1 < toks.size(); i++) {
+                auto &tok = toks.at(i);
+                if(tok.type == PekoLexingEngine::object_tk && toks.at(i+1).type == PekoLexingEngine::identifier_tk) {
+                    cur_object = toks.at(i+1).value;
+                    object_depth = depth;
+                    var_types.clear();
+                } else if(tok.type == PekoLexingEngine::fn_tk) {
+                    var_types.clear();
+                } else if(tok.value == "{") {
+                    depth++;
+                } else if(tok.value == "}") {
+                    depth--;
+                    if(depth == object_depth) {
+                        cur_object = "";
+                        object_depth = -1;
+                    }
+                } else if(tok.value == "(") {
+                    parens++;
+                } else if(tok.value == ")") {
+                    parens--;
+                } else if(tok.value == ":" && i > 0 && toks.at(i-1).type == PekoLexingEngine::identifier_tk) {
+                    std::string type = declared_type(i);
+                    if(!cur_object.empty() && depth == object_depth + 1 && parens == 0) {
+                        field_types[cur_object][toks.at(i-1).value] = type;
+                    } else if(!type.empty()) {
+                        var_types[toks.at(i-1).value] = type;
+                    } else {
+                        var_types.erase(toks.at(i-1).value);
+                    }
+                } else if(tok.type == PekoLexingEngine::for_tk && i + 3 < toks.size() && toks.at(i+2).type == PekoLexingEngine::in_tk) {
+                    // The element is the type of what is iterated over, the collection ends before the {
+                    int open = i + 3;
+                    while(open < toks.size() && toks.at(open).value != "{") {
+                        open++;
+                    }
+                    std::string type = expr_object_type(open - 1, var_types, field_types, cur_object);
+                    if(!type.empty()) {
+                        var_types[toks.at(i+1).value] = type;
+                    }
+                } else if(pass == 1 && tok.type == PekoLexingEngine::accessor_tk && toks.at(i+1).type == PekoLexingEngine::identifier_tk) {
+                    std::string type = expr_object_type(i - 1, var_types, field_types, cur_object);
+                    if(!type.empty()) {
+                        field_uses[type][toks.at(i+1).value]++;
+                    }
+                }
+            }
+        }
+
+        field_uses_counted = true;
+    }
+
     std::unique_ptr<ASTS::ExpAST> parse_object() {
+        auto attributes = pending_attributes;
+        pending_attributes.clear();
+
+        for(auto &attr : attributes) {
+            if(attr.name != "soa") {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m unknown object attribute: \n" + std::to_string(ErrorHandler::cur_line) + "| " + "\033[;0;31m@" + attr.name + "\033[0;0m object");
+                return nullptr;
+            }
+        }
+
         increase_index();
         if(get_cur_tok().type != PekoLexingEngine::identifier_tk) {
             return nullptr;
@@ -1059,19 +1776,31 @@ namespace PekoParsingEngine {
     
         increase_index();
 
-        if(get_cur_tok().type != PekoLexingEngine::identifier_tk) {
+        if(get_cur_tok().type != PekoLexingEngine::identifier_tk && get_cur_tok().value != "@") {
             return nullptr;
         }
 
 
         std::vector<std::pair<std::string, std::pair<int, std::string>>> object_attributes;
+        std::set<std::string> cold_fields;
 
-        while(get_cur_tok().type == PekoLexingEngine::identifier_tk) {
+        while(get_cur_tok().type == PekoLexingEngine::identifier_tk || get_cur_tok().value == "@") {
             std::string id_name;
             std::pair<int, std::string> type;
 
+            auto field_attrs = parse_attributes();
+
             id_name = get_cur_tok().value;
 
+            for(auto &attr : field_attrs) {
+                if(attr.name == "cold") {
+                    cold_fields.insert(id_name);
+                } else {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m unknown field attribute: \n" + std::to_string(ErrorHandler::cur_line) + "| " + "\033[;0;31m@" + attr.name + "\033[0;0m " + id_name);
+                    return nullptr;
+                }
+            }
+
             increase_index();
 
             if(get_cur_tok().value != ":") {
@@ -1082,15 +1811,19 @@ namespace PekoParsingEngine {
 
             if(get_cur_tok().type == PekoLexingEngine::number_tk) {
                 type.first = 0;
-                type.second = "number";
+                type.second = get_cur_tok().value;
             } else if(get_cur_tok().type == PekoLexingEngine::string_tk) {
                 type.first = 1;
                 type.second = "string";
+            } else if(get_cur_tok().type == PekoLexingEngine::bool_tk) {
+                type.first = bool_ty;
+                type.second = "bool";
             } else if(get_cur_tok().type == PekoLexingEngine::identifier_tk) {
                 type.first = 2;
                 type.second = get_cur_tok().value;
             }
 
+            parse_fixed_dims(type);
             object_attributes.push_back({id_name, type});
             increase_index();
             if(get_cur_tok().value == ",") {
@@ -1105,6 +1838,7 @@ namespace PekoParsingEngine {
         std::vector<std::unique_ptr<ASTS::FunctionExpAST>> functions;
         while(get_cur_tok().type == PekoLexingEngine::identifier_tk && get_cur_tok().type == PekoLexingEngine::identifier_tk && toks.at(index_in_overall_tokens+1).value == "(") {
             std::string fn_name = object_name + "." + get_cur_tok().value;
+            auto fn_tok = get_cur_tok();
             std::vector<std::pair<std::string, std::pair<int, std::string>>> args;
 
             increase_index();
@@ -1128,11 +1862,14 @@ namespace PekoParsingEngine {
                     increase_index();
 
                     if(get_cur_tok().type == PekoLexingEngine::number_tk) {
-                        type.second = "number";
+                        type.second = get_cur_tok().value;
                         type.first = 0;
                     } else if(get_cur_tok().type == PekoLexingEngine::string_tk) {
                         type.second = "string";
                         type.first = 1;
+                    } else if(get_cur_tok().type == PekoLexingEngine::bool_tk) {
+                        type.second = "bool";
+                        type.first = bool_ty;
                     } else if(get_cur_tok().type == PekoLexingEngine::identifier_tk) {
                         type.second = get_cur_tok().value;
                         type.first = 2;
@@ -1159,11 +1896,14 @@ namespace PekoParsingEngine {
             std::pair<int, std::string> type;
 
             if(get_cur_tok().type == PekoLexingEngine::number_tk) {
-                type.second = "number";
+                type.second = get_cur_tok().value;
                 type.first = 0;
             } else if(get_cur_tok().type == PekoLexingEngine::string_tk) {
                 type.second = "string";
                 type.first = 1;
+            } else if(get_cur_tok().type == PekoLexingEngine::bool_tk) {
+                type.second = "bool";
+                type.first = bool_ty;
             } else if(get_cur_tok().type == PekoLexingEngine::identifier_tk) {
                 type.second = get_cur_tok().value;
                 type.first = 2;
@@ -1180,17 +1920,31 @@ namespace PekoParsingEngine {
                 return nullptr;
             }
 
+            scopes.push_back({});
+            for(auto &arg : args) {
+                scopes.back()[arg.first] = false;
+            }
             auto fn_body = parse_block();
+            scopes.pop_back();
             //args.append()
             auto fn_proto = std::make_unique<ASTS::ProtoAST>(fn_name, args, type);
             auto func = std::make_unique<ASTS::FunctionExpAST>(std::move(fn_proto), std::move(fn_body));
+            func->line = fn_tok.line;
+            func->col  = fn_tok.col;
+            func->file = fn_tok.file;
             functions.push_back(std::move(func));
 
             increase_index();
         }
 
         increase_index();
-        auto returnObject = std::make_unique<ASTS::ObjExpAST>(object_name, object_attributes, std::move(functions));
+
+        // How often each field of this object is accessed in the program, so the layout can put the busiest fields first
+        if(!field_uses_counted) {
+            count_field_uses();
+        }
+
+        auto returnObject = std::make_unique<ASTS::ObjExpAST>(object_name, object_attributes, std::move(functions), cold_fields, field_uses[object_name], attributes);
         return returnObject;
     }
 
@@ -1200,6 +1954,21 @@ namespace PekoParsingEngine {
             return nullptr;
         }
 
+        // A compound assignment to a field, ex: a.x += 1, keeps its operator in the type of the assignment
+        auto next_tok = toks.at(index_in_overall_tokens+1);
+        if(
+            (next_tok.value == "+" || next_tok.value == "-" || next_tok.value == "*" || next_tok.value == "/") &&
+            toks.at(index_in_overall_tokens+2).value == "="
+        ) {
+            std::string field_name = get_cur_tok().value;
+            increase_index(); // eat the field name
+            increase_index(); // eat the operator
+            increase_index(); // eat the "="
+            inObject = false;
+
+            return std::make_unique<ASTS::VariableExpAST>(field_name, (std::pair<int, std::string>){-1, next_tok.value + "="}, parse_expr());
+        }
+
         std::unique_ptr<ASTS::ExpAST> LHS = parse_identifier();
         if(!strcmp(LHS->getType(), "var_ref")) {
             auto lhs_to_varref = dynamic_cast<ASTS::VariableRefExpAST*>(LHS.get());
@@ -1207,11 +1976,12 @@ namespace PekoParsingEngine {
         }
 
         if(get_cur_tok().value == "=") {
+            std::string field_name = toks.at(index_in_overall_tokens-1).value;
             increase_index();
             inObject = false;
             auto varValue = primary_parse();
 
-            return std::make_unique<ASTS::VariableExpAST>(toks[index_in_overall_tokens-3].value, (std::pair<int, std::string>){-1, ""}, std::move(varValue));
+            return std::make_unique<ASTS::VariableExpAST>(field_name, (std::pair<int, std::string>){-1, ""}, std::move(varValue));
         } else if(get_cur_tok().type != PekoLexingEngine::accessor_tk) {
             return LHS;
         } else {
@@ -1229,6 +1999,20 @@ namespace PekoParsingEngine {
     }
 
     std::unique_ptr<ASTS::ExpAST> parse_array_acc() {
+        // A range in the brackets takes a slice instead of an element, ex: line[0..4]
+        if(get_cur_tok().type == PekoLexingEngine::identifier_tk) {
+            int depth = 0;
+            for(int i = index_in_overall_tokens + 1; i < toks.size(); i++) {
+                if(toks.at(i).value == "[") {
+                    depth++;
+                } else if(toks.at(i).value == "]" && --depth == 0) {
+                    break;
+                } else if(toks.at(i).type == PekoLexingEngine::range_tk && depth == 1) {
+                    return parse_slice();
+                }
+            }
+        }
+
         inObject = true; 
         std::unique_ptr<ASTS::ExpAST> LHS;
         
@@ -1274,9 +2058,48 @@ namespace PekoParsingEngine {
 
         inObject = false;
 
+        // Accessing a field of an element, ex: points[0].x
+        if(get_cur_tok().type == PekoLexingEngine::accessor_tk) {
+            increase_index();
+            auto field = parse_object_access();
+            inObject = false;
+
+            return std::make_unique<ASTS::ObjectAccAST>(std::make_unique<ASTS::ArrayAccAST>(std::move(LHS), std::move(RHS)), std::move(field));
+        }
+
         return std::make_unique<ASTS::ArrayAccAST>(std::move(LHS), std::move(RHS));
     }
 
+    /**
+     * @brief Parses a slice of a string or an array, ex: line[4..], the start and end can be left out
+     * 
+     * @return std::unique_ptr<ASTS::ExpAST> 
+     */
+    std::unique_ptr<ASTS::ExpAST> parse_slice() {
+        std::string name = get_cur_tok().value;
+        increase_index(); // eat the name
+        increase_index(); // eat the [
+
+        std::unique_ptr<ASTS::ExpAST> start, end;
+        if(get_cur_tok().type != PekoLexingEngine::range_tk) {
+            start = parse_expr();
+        }
+
+        increase_index(); // eat the ..
+
+        if(get_cur_tok().value != "]") {
+            end = parse_expr();
+        }
+
+        if(get_cur_tok().value != "]") {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(ErrorHandler::cur_line) + " \033[0;31merror:\033[0;0m expected ']': \n" + std::to_string(ErrorHandler::cur_line) + "| " + name + "[...\033[;0;31m" + get_cur_tok().value + "\033[0;0m");
+            return nullptr;
+        }
+
+        increase_index(); // eat the ]
+        return std::make_unique<ASTS::SliceAST>(name, std::move(start), std::move(end));
+    }
+
     std::unique_ptr<ASTS::ExpAST> parse_array_lit() {
         increase_index();
 
@@ -1292,4 +2115,256 @@ namespace PekoParsingEngine {
         increase_index();
         return std::make_unique<ASTS::ArrayLitAST>(std::move(elements));
     }
+
+      // ++++++++++++++++++++++++++++++++++++++++++++++ //
+     // +++++++++++++++++ GENERICS +++++++++++++++++++ //
+    // ++++++++++++++++++++++++++++++++++++++++++++++ //
+
+    // A generic function or object, kept as tokens until it is used with concrete types
+    struct generic_decl {
+        std::vector<std::string> params; // ex: T
+        std::vector<PekoLexingEngine::token> tokens; // the declaration without its type parameters
+        int name_index; // where the name is in tokens
+    };
+
+    std::map<std::string, generic_decl> generics;
+    std::set<std::string> instantiated_generics; // mangled names, ex: Stack$number$ for Stack<number>, that were already generated
+
+    void collapse_generic_uses(std::vector<PekoLexingEngine::token> &item, std::vector<PekoLexingEngine::token> &out, int depth);
+
+    /**
+     * @brief Generates the tokens of a generic with the type arguments put in for its parameters.
+     * Generics the copy uses are generated first, so everything it needs is declared before it
+     * 
+     * @param mangled the name of the copy, ex: max$number$ for max<number>
+     * @param decl 
+     * @param args the tokens of each type argument, ex: number [ ] for number[]
+     * @param out where the tokens are added
+     * @param depth how many generics are being generated for the one that was used in the code, so recursive generics stop
+     */
+    void instantiate_generic(std::string mangled, generic_decl &decl, std::vector<std::vector<PekoLexingEngine::token>> args, std::vector<PekoLexingEngine::token> &out, int depth) {
+        std::vector<PekoLexingEngine::token> copy;
+        for(int t = 0; t < decl.tokens.size(); t++) {
+            auto tok = decl.tokens[t];
+            if(t == decl.name_index) {
+                tok.value = mangled;
+            }
+
+            auto param = std::find(decl.params.begin(), decl.params.end(), tok.value);
+            if(tok.type != PekoLexingEngine::identifier_tk || param == decl.params.end()) {
+                copy.push_back(tok);
+                continue;
+            }
+
+            // The type takes the place of the parameter, so errors and debug info point at the generic's own line
+            for(auto arg_tok : args[param - decl.params.begin()]) {
+                arg_tok.line = tok.line;
+                arg_tok.col = tok.col;
+                arg_tok.file = tok.file;
+                copy.push_back(arg_tok);
+            }
+        }
+
+        collapse_generic_uses(copy, out, depth + 1);
+        out.insert(out.end(), copy.begin(), copy.end());
+    }
+
+    /**
+     * @brief Replaces every use of a generic in item, ex: Stack < number >, with a single identifier token holding the mangled name,
+     * and generates the generic for those types into out if it hasn't been yet
+     * 
+     * @param item 
+     * @param out 
+     * @param depth 
+     */
+    void collapse_generic_uses(std::vector<PekoLexingEngine::token> &item, std::vector<PekoLexingEngine::token> &out, int depth) {
+        if(depth > 64) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m generics are nested more than 64 deep, a generic probably uses itself with a bigger type");
+            return;
+        }
+
+        // Uses inside type arguments are collapsed first, so go again until nothing changes
+        bool changed = true;
+        while(changed) {
+            changed = false;
+
+            for(int i = 0; i + 3 < item.size(); i++) {
+                if(item[i].type != PekoLexingEngine::identifier_tk || !generics.count(item[i].value) || item[i+1].value != "<") {
+                    continue;
+                }
+
+                // The type arguments are types separated by commas, each a type name with any number of [], [N] or [..] after it.
+                // Generics in them are collapsed on an earlier pass, so until then this use is skipped
+                std::vector<std::vector<PekoLexingEngine::token>> args;
+                int end = i + 2;
+                while(end < item.size()) {
+                    auto t = item[end].type;
+                    if(t != PekoLexingEngine::identifier_tk && t != PekoLexingEngine::number_tk && t != PekoLexingEngine::string_tk && t != PekoLexingEngine::bool_tk) {
+                        break;
+                    }
+
+                    std::vector<PekoLexingEngine::token> arg = {item[end++]};
+                    while(end + 1 < item.size() && item[end].value == "[") {
+                        if(item[end+1].value == "]") {
+                            arg.insert(arg.end(), item.begin() + end, item.begin() + end + 2);
+                            end += 2;
+                        } else if(end + 2 < item.size() && (item[end+1].type == PekoLexingEngine::num_tk || item[end+1].type == PekoLexingEngine::range_tk) && item[end+2].value == "]") {
+                            arg.insert(arg.end(), item.begin() + end, item.begin() + end + 3);
+                            end += 3;
+                        } else {
+                            break;
+                        }
+                    }
+                    args.push_back(arg);
+
+                    if(end >= item.size() || item[end].value != ",") {
+                        break;
+                    }
+                    end++;
+                }
+
+                if(end >= item.size() || item[end].value != ">") {
+                    continue;
+                }
+
+                auto &decl = generics[item[i].value];
+                if(args.size() != decl.params.size()) {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m " + item[i].value + " takes " + std::to_string(decl.params.size()) + " type arguments but " + std::to_string(args.size()) + " were given");
+                    return;
+                }
+
+                // < and , can't be in a symbol for the assembler, the $ at the end keeps Stack<Pair<a,b>> apart from Stack<Pair,a,b>.
+                // The brackets of array types are kept, ex: Box$number[4]$, llvm quotes the name
+                std::string mangled = item[i].value + "$";
+                for(auto &arg : args) {
+                    for(auto &arg_tok : arg) {
+                        mangled += arg_tok.value;
+                    }
+                    mangled += "$";
+                }
+
+                item.erase(item.begin() + i + 1, item.begin() + end + 1);
+                item[i].value = mangled;
+                changed = true;
+
+                // Every module sees the same generics, so one copy per set of types serves all of them
+                if(instantiated_generics.insert(mangled).second) {
+                    instantiate_generic(mangled, decl, args, out, depth);
+                }
+            }
+        }
+
+        // A use left over has something in its type arguments that isn't a type
+        for(int i = 0; i + 1 < item.size(); i++) {
+            if(item[i].type == PekoLexingEngine::identifier_tk && generics.count(item[i].value) && item[i+1].value == "<") {
+                std::string written = item[i].value + "<";
+                for(int t = i + 2; t < item.size() && t < i + 12 && item[t].value != ">" && item[t].type != PekoLexingEngine::new_line_tk; t++) {
+                    written += item[t].value + (item[t].value == "," ? " " : "");
+                }
+                ASTS::PrintERR(ErrorHandler::cur_file_path + ":" + std::to_string(item[i].line) + " \033[0;31merror:\033[0;0m the type arguments of a generic are types with any number of [], [N] or [..] after them, ex: Box<number[4]>: \n" + std::to_string(item[i].line) + "| \033[;0;31m" + written + "...>\033[0;0m");
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Monomorphizes generics: declarations like fn max<T>(...) or object Stack<T> {...} are taken out of the tokens,
+     * and a copy with the types put in is added in front of the first declaration that uses it with those types
+     * 
+     * @param toks all of the tokens, with the imported modules
+     * @return std::vector<PekoLexingEngine::token> 
+     */
+    std::vector<PekoLexingEngine::token> instantiate_generics(std::vector<PekoLexingEngine::token> toks) {
+        // Split the tokens into top level declarations, each one ends with a } or ; outside of any braces
+        std::vector<std::vector<PekoLexingEngine::token>> items = {{}};
+        int braces = 0;
+        for(auto &tok : toks) {
+            items.back().push_back(tok);
+
+            if(tok.value == "{") {
+                braces++;
+            } else if(tok.value == "}") {
+                braces--;
+            }
+
+            if(braces == 0 && (tok.value == "}" || tok.value == ";")) {
+                items.push_back({});
+            }
+        }
+
+        for(auto &item : items) {
+            // Skip to the name of the declaration, past newlines, attributes and export
+            int i = 0;
+            while(i < item.size() && (item[i].type == PekoLexingEngine::new_line_tk || item[i].value == "@" || item[i].type == PekoLexingEngine::export_tk || item[i].type == PekoLexingEngine::const_tk)) {
+                if(item[i].value == "@") {
+                    i += 2;
+                    if(i < item.size() && item[i].value == "(") {
+                        while(i < item.size() && item[i].value != ")") {
+                            i++;
+                        }
+                        i++;
+                    }
+                } else {
+                    i++;
+                }
+            }
+
+            if(i + 2 >= item.size() || (item[i].type != PekoLexingEngine::fn_tk && item[i].type != PekoLexingEngine::object_tk) || item[i+2].value != "<") {
+                continue;
+            }
+
+            generic_decl decl;
+            std::string name = item[i+1].value;
+
+            int end = i + 3;
+            while(end < item.size() && item[end].value != ">") {
+                if(item[end].value != ",") {
+                    decl.params.push_back(item[end].value);
+                }
+                end++;
+            }
+
+            // Newlines are left behind so line numbers in errors stay right
+            std::vector<PekoLexingEngine::token> newlines;
+            for(int t = 0; t < item.size(); t++) {
+                if(item[t].type == PekoLexingEngine::new_line_tk) {
+                    newlines.push_back(item[t]);
+                } else if(t < i + 2 || t > end) {
+                    if(t == i + 1) {
+                        decl.name_index = decl.tokens.size();
+                    }
+                    decl.tokens.push_back(item[t]);
+                }
+            }
+
+            // The same module imported twice declares the generic twice
+            if(generics.count(name)) {
+                bool same = generics[name].tokens.size() == decl.tokens.size();
+                for(int t = 0; same && t < decl.tokens.size(); t++) {
+                    same = generics[name].tokens[t].value == decl.tokens[t].value;
+                }
+
+                if(!same) {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m generic " + name + " is declared twice");
+                }
+            }
+
+            generics[name] = decl;
+            item = newlines;
+        }
+
+        std::vector<PekoLexingEngine::token> out;
+        for(auto &item : items) {
+            collapse_generic_uses(item, out, 0);
+            out.insert(out.end(), item.begin(), item.end());
+        }
+
+        // The parser can't start on a newline, which happens when the file starts with a generic
+        while(!out.empty() && out.front().type == PekoLexingEngine::new_line_tk) {
+            out.erase(out.begin());
+            ErrorHandler::cur_line++;
+        }
+
+        return out;
+    }
 }
\ No newline at end of file
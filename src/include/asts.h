@@ -1,14 +1,18 @@
 #ifndef ASTS_H
 #define ASTS_H
 #include <cctype>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <map>
+#include <set>
+#include <sstream>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 #include <iostream>
+#include <functional>
 
 #include "ParsingEngine.h"
 
@@ -18,7 +22,9 @@
 #include <llvm/IR/GlobalVariable.h>
 #include <llvm/ADT/STLExtras.h>
 #include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/CFG.h>
 #include <llvm/IR/Constants.h>
+#include <llvm/IR/DIBuilder.h>
 #include <llvm/IR/DerivedTypes.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/IRBuilder.h>
@@ -27,10 +33,14 @@
 #include <llvm/IR/Verifier.h>
 #include <llvm/IR/Instruction.h>
 #include <llvm/IR/Instructions.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/Transforms/Utils/Local.h>
+#include <llvm/Transforms/Utils/Cloning.h>
 #include <llvm/Support/TargetRegistry.h>
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/Host.h>
+#include <llvm/Support/Path.h>
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Target/TargetMachine.h>
@@ -100,6 +110,13 @@ namespace ASTS {
 
         // The irgen function is the function that will be found in all asts and generates the llvm ir
         virtual llvm::Value *irgen() = 0;
+
+        bool is_unsigned = false; // set by irgen when the value it gave is a u8, since llvm integers don't keep their sign
+
+        // Where the expression starts in the peko source, line is 0 when the parser didn't give it a position
+        int line = 0;
+        int col  = 0;
+        int file = 0;
     };
 
     std::unique_ptr<ASTS::ExpAST> PrintERR(std::string err_msg) {
@@ -135,6 +152,19 @@ namespace ASTS {
         llvm::Value *irgen();
     };
 
+    // A simple ast for storing a true or false
+    class BoolExpAST : public ExpAST {
+        bool value;
+
+    public:
+        BoolExpAST(bool V) 
+            : value(V) {}
+        
+        bool getVal() { return value; }
+        char *getType();
+        llvm::Value *irgen();
+    };
+
     // An ast for referencing a variable
     class VariableRefExpAST : public ExpAST {
         std::string var_name;
@@ -155,6 +185,8 @@ namespace ASTS {
         std::unique_ptr<ExpAST>     var_value;
 
     public:
+        bool is_const = false; // declared with const, so it's never assigned to again
+
         VariableExpAST(std::string v_name, std::pair<int, std::string> v_type, std::unique_ptr<ExpAST> val)
             : var_name(v_name), var_type(std::move(v_type)), var_value(std::move(val)) {}
 
@@ -162,6 +194,7 @@ namespace ASTS {
         std::string getName() { return var_name; }
         ExpAST *getVAST() { return var_value.get(); }
         std::string getVarType() { return var_type.second; }
+        int getVarKind() { return var_type.first; }
         llvm::Value *irgen();
     };
 
@@ -174,6 +207,20 @@ namespace ASTS {
         BinaryExpAST(std::string op, std::unique_ptr<ExpAST> lhs, std::unique_ptr<ExpAST> rhs)
             : op(op), LHS(std::move(lhs)), RHS(std::move(rhs)) {}
 
+        char *getType();
+        llvm::Value *shortCircuitGen();
+        llvm::Value *irgen();
+    };
+
+    // Stores an operator that only has one operand (ex: not)
+    class UnaryExpAST : public ExpAST {
+    public:
+        std::string op;
+        std::unique_ptr<ExpAST> operand;
+
+        UnaryExpAST(std::string op, std::unique_ptr<ExpAST> operand)
+            : op(op), operand(std::move(operand)) {}
+
         char *getType();
         llvm::Value *irgen();
     };
@@ -185,6 +232,8 @@ namespace ASTS {
     public:
         std::vector<std::unique_ptr<ExpAST>> args;
         std::vector<llvm::Value *> argsv_extra;
+        llvm::Value *sret_dest = nullptr; // where a returned object is written
+        llvm::CallInst *last_call = nullptr; // the call made by the last irgen, so a return can mark it as a tail call
 
         CallExpAST(std::string &c, std::vector<std::unique_ptr<ExpAST>> a)
             : callee(c), args(std::move(a)) {}
@@ -196,6 +245,12 @@ namespace ASTS {
         llvm::Value *irgen();
     };
 
+    // An annotation on a declaration, ex: @cold or @unroll(4)
+    struct attribute {
+        std::string name;
+        std::vector<std::string> args;
+    };
+
     // Contains a function prototype
     class ProtoAST : public ExpAST {
         std::string func_name;
@@ -203,6 +258,21 @@ namespace ASTS {
 
     public:
         std::pair<int, std::string> fn_type;
+        bool exported = false; // exported functions keep external linkage and the C calling convention in whole program mode
+        bool const_fn = false; // set by const fn, calls with constant arguments are run while compiling
+        std::vector<attribute> attributes; // ex: @inline or @pure
+        std::set<std::string> noalias_args; // arguments marked @noalias
+        std::set<std::string> const_args; // arguments marked const
+
+        bool hasAttribute(std::string name) {
+            for(auto &attr : attributes) {
+                if(attr.name == name) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
 
         ProtoAST(std::string name, std::vector<std::pair<std::string, std::pair<int, std::string>>> a, std::pair<int, std::string> type)
             : func_name(name), args(std::move(a)), fn_type(type) {}
@@ -217,25 +287,35 @@ namespace ASTS {
         llvm::Function *irgen();
     };
 
+    // Every parsed function by name, so a call can declare a function that is defined further down the file
+    std::map<std::string, ProtoAST *> function_protos;
+
     // Contains a function
     class FunctionExpAST : public ExpAST {
         std::unique_ptr<ProtoAST> Proto;
         std::vector<std::unique_ptr<ExpAST>> Body;
     public:
          FunctionExpAST(std::unique_ptr<ProtoAST> proto, std::vector<std::unique_ptr<ExpAST>> body)
-            : Proto(std::move(proto)), Body(std::move(body)) {}
+            : Proto(std::move(proto)), Body(std::move(body)) {
+            function_protos[Proto->getName()] = Proto.get();
+        }
 
         ProtoAST *getProto() { return Proto.get(); }
         void setProto(std::unique_ptr<ProtoAST> new_proto) { Proto = std::move(new_proto); }
         std::vector<std::unique_ptr<ExpAST>> getBody() { return std::move(Body); }
+        std::vector<std::unique_ptr<ExpAST>> &getStatements() { return Body; }
         char *getType();
         llvm::Function *irgen();
     };
 
+    // Every const fn by name, so the compiler can run their bodies
+    std::map<std::string, FunctionExpAST *> const_fns;
+
     // Store a returns value
     class ReturnExpAST : public ExpAST {
     public:
         std::unique_ptr<ExpAST> Ret_value;
+        bool must_tail = false; // set by @tailcall, the returned call has to be a musttail call
 
         ReturnExpAST(std::unique_ptr<ExpAST> ret_value)
             : Ret_value(std::move(ret_value)) {}
@@ -258,6 +338,10 @@ namespace ASTS {
 
         char *getType();
         ExpAST* getCondition() { return condition.get(); }
+        std::vector<std::unique_ptr<ExpAST>> &getIfBody() { return body; }
+        std::vector<std::unique_ptr<IfExpAST>> &getElseIfs() { return els_if; }
+        std::vector<std::unique_ptr<ExpAST>> &getElse() { return els; }
+        std::vector<std::unique_ptr<ExpAST>> &getThen() { return then; }
         llvm::Value *irgen();
     };
 
@@ -267,23 +351,71 @@ namespace ASTS {
         std::vector<std::unique_ptr<ExpAST>> body, cont;
 
     public:
+        std::vector<attribute> hints; // ex: @unroll(4)
+
         LoopExpAST(std::unique_ptr<ExpAST> cond, std::vector<std::unique_ptr<ExpAST>> bod, std::vector<std::unique_ptr<ExpAST>> con)
             : condition(std::move(cond)), body(std::move(bod)), cont(std::move(con)) {}
         
         char *getType();
+        ExpAST *getCondition() { return condition.get(); }
+        std::vector<std::unique_ptr<ExpAST>> &getLoopBody() { return body; }
+        std::vector<std::unique_ptr<ExpAST>> &getCont() { return cont; }
         std::vector<std::unique_ptr<ExpAST>> getBody() { return std::move(body); }
         std::vector<std::unique_ptr<ExpAST>> getAfter() { return std::move(cont); }
         llvm::Value *irgen();
     };
 
+    // Stores a for in expression that walks over every element of an array or every byte of a string
+    class ForExpAST : public ExpAST {
+        std::string elem_name;
+        std::unique_ptr<ExpAST> collection;
+        std::vector<std::unique_ptr<ExpAST>> body, cont;
+
+        void soaLoop(llvm::Value *coll, llvm::Value *header);
+
+    public:
+        std::vector<attribute> hints; // ex: @unroll(4)
+
+        ForExpAST(std::string e_name, std::unique_ptr<ExpAST> coll, std::vector<std::unique_ptr<ExpAST>> bod, std::vector<std::unique_ptr<ExpAST>> con)
+            : elem_name(e_name), collection(std::move(coll)), body(std::move(bod)), cont(std::move(con)) {}
+
+        char *getType();
+        std::string getElemName() { return elem_name; }
+        llvm::Value *irgen();
+    };
+
+    struct match_case {
+        std::vector<std::unique_ptr<ExpAST>> values;
+        std::vector<std::unique_ptr<ExpAST>> body;
+    };
+
+    class MatchExpAST : public ExpAST {
+        std::unique_ptr<ExpAST> subject;
+        std::vector<match_case> cases;
+        std::vector<std::unique_ptr<ExpAST>> els, cont;
+
+        llvm::Value *numberSwitch(llvm::Value *val, std::vector<llvm::BasicBlock*> case_blocks, llvm::BasicBlock *default_block);
+        llvm::Value *stringSwitch(llvm::Value *val, std::vector<llvm::BasicBlock*> case_blocks, llvm::BasicBlock *default_block);
+
+    public:
+        MatchExpAST(std::unique_ptr<ExpAST> subj, std::vector<match_case> cas, std::vector<std::unique_ptr<ExpAST>> el, std::vector<std::unique_ptr<ExpAST>> con)
+            : subject(std::move(subj)), cases(std::move(cas)), els(std::move(el)), cont(std::move(con)) {}
+
+        char *getType();
+        llvm::Value *irgen();
+    };
+
     class ObjExpAST : public ExpAST {
         std::string object_name;
         std::vector<std::pair<std::string, std::pair<int, std::string>>> object_attributes;
         std::vector<std::unique_ptr<ASTS::FunctionExpAST>> functions;
+        std::set<std::string> cold_fields; // fields that are kept out of line
+        std::map<std::string, int> field_uses; // how many times each field name is accessed in the program
+        std::vector<attribute> attributes;
 
     public:
-        ObjExpAST(std::string object_name, std::vector<std::pair<std::string, std::pair<int, std::string>>> object_attributes, std::vector<std::unique_ptr<ASTS::FunctionExpAST>> functions)
-            : object_name(object_name), object_attributes(object_attributes), functions(std::move(functions)) {}
+        ObjExpAST(std::string object_name, std::vector<std::pair<std::string, std::pair<int, std::string>>> object_attributes, std::vector<std::unique_ptr<ASTS::FunctionExpAST>> functions, std::set<std::string> cold_fields, std::map<std::string, int> field_uses, std::vector<attribute> attributes)
+            : object_name(object_name), object_attributes(object_attributes), functions(std::move(functions)), cold_fields(cold_fields), field_uses(field_uses), attributes(attributes) {}
         
         char *getType();
         llvm::Value *irgen();
@@ -316,6 +448,8 @@ namespace ASTS {
 
     class ArrayAccAST : public ExpAST {
         std::unique_ptr<ExpAST> LHS, RHS;
+        llvm::Value *last_arr = nullptr; // the array that holds the accessed element
+        int last_index = 0;
 
     public:
         ArrayAccAST(std::unique_ptr<ExpAST> LHS, std::unique_ptr<ExpAST> RHS)
@@ -323,6 +457,7 @@ namespace ASTS {
         
         char *getType();
         llvm::Value *irgen();
+        void writeBack(llvm::Value *elem);
         ExpAST *GetLHS() { return LHS.get(); }
         ExpAST *GetRHS() { return RHS.get(); }
     };
@@ -338,6 +473,24 @@ namespace ASTS {
         llvm::Value *irgen();
         ExpAST *getElement(int i) { return elements.at(i).get(); }
         int getSize() { return elements.size(); }
+
+        llvm::Type *elem_type = nullptr; // the element type of the array being declared, so number literals can become ex: f32s
+        llvm::Constant *const_val = nullptr; // the {T*, i64} of the read only copy, set by irgen when every element is a constant
+    };
+
+    class SliceAST : public ExpAST {
+        std::string var_name;
+        std::unique_ptr<ExpAST> start, end; // nullptr when left out, ex: line[4..]
+
+    public:
+        SliceAST(std::string var_name, std::unique_ptr<ExpAST> start, std::unique_ptr<ExpAST> end)
+            : var_name(var_name), start(std::move(start)), end(std::move(end)) {}
+        
+        char *getType();
+        llvm::Value *irgen();
+        std::string getVarName() { return var_name; }
+
+        std::string peko_type = ""; // the type of the slice once it is generated, ex: u8 .. for a slice of a string
     };
     
 
@@ -346,12 +499,16 @@ namespace ASTS {
  
     char *StringExpAST::getType()       { return (char *)"string"; }
 
+    char *BoolExpAST::getType()         { return (char *)"bool"; }
+
     char *VariableRefExpAST::getType()  { return (char *)"var_ref"; }
 
     char *VariableExpAST::getType()     { return (char *)"variable"; }
 
     char *BinaryExpAST::getType()       { return (char *)"binary"; }
 
+    char *UnaryExpAST::getType()        { return (char *)"unary"; }
+
     char *CallExpAST::getType()         { return (char *)"call"; }
 
     char *ProtoAST::getType()           { return (char *)"prototype"; }
@@ -364,6 +521,9 @@ namespace ASTS {
 
     char *LoopExpAST::getType()         { return (char *)"loop"; }
 
+    char *ForExpAST::getType()          { return (char *)"for"; }
+    char *MatchExpAST::getType()        { return (char *)"match"; }
+
     char *ObjExpAST::getType()          { return (char *)"object"; }
 
     char *IdHolder::getType()           { return (char *)"id"; }
@@ -374,6 +534,8 @@ namespace ASTS {
 
     char *ArrayLitAST::getType()       { return (char *)"arr_lit"; }
 
+    char *SliceAST::getType()          { return (char *)"slice"; }
+
       // ++++++++++++++++++++++++++++++++++++++++ //
      // ++++++++++ LLVM IR GENERATION ++++++++++ //
     // ++++++++++++++++++++++++++++++++++++++++ //
@@ -383,7 +545,8 @@ namespace ASTS {
         string_ty,
         custom_ty,
         void_ty,
-        array_ty
+        array_ty,
+        bool_ty
     };
 
     // A structure for storing an llvm value and its type
@@ -391,6 +554,8 @@ namespace ASTS {
         llvm::Value *val;
         llvm::Type  *type;
         bool        global;
+        std::string peko_type; // the declared type when it matters, ex: u8, or u8 + for an array of them
+        bool is_value = false; // a const number, string or bool, val is the value itself instead of where it's stored
     };
 
     struct global_llvm_var { 
@@ -404,6 +569,11 @@ namespace ASTS {
         llvm::Type* struct_ty;
         llvm::Type* struct_ptr_ty;
         std::map<std::string, int> type_name_map;
+        std::map<std::string, int> cold_name_map; // the index of each @cold field in cold_ty
+        llvm::StructType *cold_ty = nullptr; // the out of line block of the @cold fields
+        int cold_index = -1; // the index of the pointer to the cold block
+        llvm::StructType *soa_ty = nullptr; // set when arrays of the object store each field in its own column
+        std::map<std::string, std::string> field_types; // the peko type of each field, ex: u8
     };
 
     // Initialize all llvm components
@@ -414,12 +584,38 @@ namespace ASTS {
     static std::map<std::string, llvm_var> GlobalNamedValues;
     static std::map<std::string, class_type> allocatedObjects;
     static std::map<std::string, class_type> allocatedArrays;
-    static std::map<std::string, std::vector<int>> ArraySizes;
+    std::vector<std::string> object_order; // object names in the order they were declared, for the layout report
+    std::map<llvm::Type *, std::string> soa_types; // the element type of struct of arrays arrays, and the object it stores
     std::vector<ExpAST *> global_expressions;
     std::vector<global_llvm_var> global_vars;
+    std::map<std::string, llvm::Function *> lazy_globals; // globals set up on first use, and the function that sets them up
     llvm::BasicBlock *Cur_BB;
     llvm::Value *RetVal = nullptr;
     bool inVarExp = false;
+    bool whole_program = false; // set by --whole-program, only main and exported functions are visible outside the module
+    bool memo_stats = false; // set by --memo-stats, @memo tables print their hit rates when the program exits
+    const long long max_memo_capacity = 1LL << 32; // @memo tables allocate a bucket per entry up front, 8 bytes each, so bigger ones can't be allocated
+    bool alloc_stats = false; // set by --alloc-stats, the program prints how many buffers its code allocated when it exits
+    bool loop_remarks = false; // set by --loop-remarks, loop hints that can't be honored are explained on stderr
+    bool fast_math = false; // set by -ffast-math, every function gets the fast math flags a @fastmath function gets
+    std::string target_cpu = ""; // set by -march or -mcpu, empty for the default cpu of the target
+    std::string target_features = ""; // set by -march=native or -mattr, ex: +avx2,+fma
+    std::vector<std::string> multiversion_features = {"avx", "avx2", "fma", "bmi2", "avx512f", "avx512bw", "avx512dq", "avx512vl"}; // in the order cpu_supports in the stdlib numbers them
+    std::vector<std::pair<llvm::Function *, std::vector<std::string>>> multiversion_fns; // @multiversion functions and the features they get a copy for
+    bool debug_info = false; // set by -g, the module gets dwarf debug info so debuggers and profilers can show the peko lines
+    std::unique_ptr<llvm::DIBuilder> DBuilder;
+    llvm::DICompileUnit *DbgCU = nullptr;
+    std::vector<llvm::DIFile *> DbgFiles; // the debug info file for each of the source files the lexer read
+    std::map<std::string, llvm::DIType *> DbgTypes; // the debug info types made so far, by their peko type
+    std::vector<std::pair<llvm::CallInst *, uint64_t>> arr_lit_mallocs; // the buffers of array literals in the program, with their length
+
+    // An array literal whose elements are all constants, it is copied out of the read only global unless nothing writes to the copy
+    struct const_arr_lit {
+        llvm::Instruction *data; // the pointer to the copy
+        llvm::Constant *global_data; // the pointer to the elements of the global
+        std::vector<llvm::Instruction *> init; // the instructions that fill the copy
+    };
+    std::vector<const_arr_lit> const_arr_lits;
 
     /**
      * @brief Declares all of the stdlib functions to be called
@@ -463,7 +659,11 @@ namespace ASTS {
         cmpstrargs.push_back(llvm::Type::getInt8PtrTy(TheContext));
         cmpstrargs.push_back(llvm::Type::getInt8PtrTy(TheContext));
         llvm::FunctionType *cmpstrType = llvm::FunctionType::get(Builder.getDoubleTy(), cmpstrargs, true);
-        llvm::Function::Create(cmpstrType, llvm::Function::ExternalLinkage, "cmpstr", TheModule.get());
+        llvm::Function::Create(cmpstrType, llvm::Function::ExternalLinkage, "cmpstr", TheModule.get())->addFnAttr(llvm::Attribute::ReadOnly);
+
+        // For comparing strings without converting the result to a number
+        llvm::FunctionType *strcmpType = llvm::FunctionType::get(Builder.getInt32Ty(), cmpstrargs, false);
+        llvm::Function::Create(strcmpType, llvm::Function::ExternalLinkage, "strcmp", TheModule.get())->addFnAttr(llvm::Attribute::ReadOnly);
 
         // For multiplying a string by a number
         std::vector<llvm::Type *> mulargs;
@@ -477,8 +677,47 @@ namespace ASTS {
         modargs.push_back(llvm::Type::getDoubleTy(TheContext));
         modargs.push_back(llvm::Type::getDoubleTy(TheContext));
         llvm::FunctionType *modnumType = llvm::FunctionType::get(Builder.getDoubleTy(), modargs, true);
-        llvm::Function::Create(modnumType, llvm::Function::ExternalLinkage, "modnum", TheModule.get());
-
+        llvm::Function::Create(modnumType, llvm::Function::ExternalLinkage, "modnum", TheModule.get())->addFnAttr(llvm::Attribute::ReadNone);
+
+        // For getting the length of a string
+        std::vector<llvm::Type *> strlenargs;
+        strlenargs.push_back(llvm::Type::getInt8PtrTy(TheContext));
+        llvm::FunctionType *strlenType = llvm::FunctionType::get(Builder.getInt64Ty(), strlenargs, false);
+        llvm::Function::Create(strlenType, llvm::Function::ExternalLinkage, "strlen", TheModule.get())->addFnAttr(llvm::Attribute::ReadOnly);
+
+        // For growing the buffer of an array
+        std::vector<llvm::Type *> reallocargs;
+        reallocargs.push_back(llvm::Type::getInt8PtrTy(TheContext));
+        reallocargs.push_back(llvm::Type::getInt64Ty(TheContext));
+        llvm::FunctionType *reallocType = llvm::FunctionType::get(Builder.getInt8PtrTy(), reallocargs, false);
+        llvm::Function::Create(reallocType, llvm::Function::ExternalLinkage, "realloc", TheModule.get());
+
+        // For hashing the value of a match statement on strings
+        std::vector<llvm::Type *> hashargs;
+        hashargs.push_back(llvm::Type::getInt8PtrTy(TheContext));
+        hashargs.push_back(llvm::Type::getInt64Ty(TheContext));
+        llvm::FunctionType *hashType = llvm::FunctionType::get(Builder.getInt64Ty(), hashargs, false);
+        llvm::Function::Create(hashType, llvm::Function::ExternalLinkage, "hashstr", TheModule.get())->addFnAttr(llvm::Attribute::ReadOnly);
+
+        // For the tables of @memo functions
+        auto i64ptr = llvm::Type::getInt64PtrTy(TheContext);
+        llvm::FunctionType *memoOpenType = llvm::FunctionType::get(Builder.getInt8PtrTy(), {Builder.getInt8PtrTy()->getPointerTo(), Builder.getInt8PtrTy(), Builder.getInt64Ty(), Builder.getInt8PtrTy(), Builder.getInt32Ty()}, false);
+        llvm::Function::Create(memoOpenType, llvm::Function::ExternalLinkage, "memo_open", TheModule.get());
+        llvm::FunctionType *memoLookupType = llvm::FunctionType::get(Builder.getInt32Ty(), {Builder.getInt8PtrTy(), i64ptr, i64ptr}, false);
+        llvm::Function::Create(memoLookupType, llvm::Function::ExternalLinkage, "memo_lookup", TheModule.get());
+        llvm::FunctionType *memoInsertType = llvm::FunctionType::get(Builder.getVoidTy(), {Builder.getInt8PtrTy(), i64ptr, Builder.getInt64Ty()}, false);
+        llvm::Function::Create(memoInsertType, llvm::Function::ExternalLinkage, "memo_insert", TheModule.get());
+
+        // For strviews, which are a pointer into a string and a length instead of a null terminated string
+        auto i8ptr = Builder.getInt8PtrTy();
+        llvm::Function::Create(llvm::FunctionType::get(i8ptr, {i8ptr, Builder.getInt64Ty()}, false), llvm::Function::ExternalLinkage, "viewstr", TheModule.get());
+        llvm::Function::Create(llvm::FunctionType::get(Builder.getDoubleTy(), {i8ptr, Builder.getInt64Ty()}, false), llvm::Function::ExternalLinkage, "printview", TheModule.get());
+        llvm::Function::Create(llvm::FunctionType::get(Builder.getInt32Ty(), {i8ptr, Builder.getInt64Ty(), i8ptr, Builder.getInt64Ty()}, false), llvm::Function::ExternalLinkage, "cmpview", TheModule.get())->addFnAttr(llvm::Attribute::ReadOnly);
+        llvm::Function::Create(llvm::FunctionType::get(Builder.getInt64Ty(), {i8ptr, Builder.getInt64Ty(), i8ptr, Builder.getInt64Ty()}, false), llvm::Function::ExternalLinkage, "findview", TheModule.get())->addFnAttr(llvm::Attribute::ReadOnly);
+        llvm::Function::Create(llvm::FunctionType::get(llvm::PointerType::getUnqual(llvm::StructType::get(TheContext, {i8ptr, Builder.getInt64Ty()})), {i8ptr, Builder.getInt64Ty(), i8ptr, Builder.getInt64Ty(), i64ptr}, false), llvm::Function::ExternalLinkage, "splitview", TheModule.get());
+
+        // For picking the copy of a @multiversion function the cpu can run
+        llvm::Function::Create(llvm::FunctionType::get(Builder.getInt32Ty(), {Builder.getInt32Ty()}, false), llvm::Function::ExternalLinkage, "cpu_supports", TheModule.get());
 
         return 1;
     }
@@ -517,6 +756,217 @@ namespace ASTS {
         return "";
     }
 
+    /**
+     * @brief Starts the debug info for -g, a compile unit for the program and a file for each source file
+     * 
+     * @param optimized if the program is compiled with optimizations, debuggers are told the variables may not always be shown
+     */
+    void initDebugInfo(bool optimized) {
+        debug_info = true;
+        DBuilder = std::make_unique<llvm::DIBuilder>(*TheModule);
+
+        for(auto &path : PekoLexingEngine::source_files) {
+            llvm::SmallString<128> abs_path(path);
+            llvm::sys::fs::make_absolute(abs_path);
+            DbgFiles.push_back(DBuilder->createFile(llvm::sys::path::filename(abs_path), llvm::sys::path::parent_path(abs_path)));
+        }
+
+        DbgCU = DBuilder->createCompileUnit(llvm::dwarf::DW_LANG_C, DbgFiles.at(0), "pekoscript", optimized, "", 0);
+
+        TheModule->addModuleFlag(llvm::Module::Warning, "Debug Info Version", llvm::DEBUG_METADATA_VERSION);
+        TheModule->addModuleFlag(llvm::Module::Warning, "Dwarf Version", 4);
+    }
+
+    /**
+     * @brief Gets the debug info type debuggers show a peko type as
+     * 
+     * @param T the llvm type of the values
+     * @param peko_type ex: u8, when it's empty it's worked out from T
+     * @return llvm::DIType* nullptr for the types debuggers aren't told about, like arrays
+     */
+    llvm::DIType *debugType(llvm::Type *T, std::string peko_type) {
+        if(!T) {
+            return nullptr;
+        }
+
+        // Objects are passed around by pointer
+        if(T->isPointerTy() && T != Builder.getInt8PtrTy()) {
+            auto pointee = debugType(T->getPointerElementType(), peko_type);
+            return pointee ? DBuilder->createPointerType(pointee, 64) : nullptr;
+        }
+
+        // The llvm type says what a value is, except for the sign of a u8 and which object a struct is
+        if(!T->isStructTy()) {
+            if(T->isDoubleTy()) {
+                peko_type = "number";
+            } else if(T->isFloatTy()) {
+                peko_type = "f32";
+            } else if(T->isIntegerTy(1)) {
+                peko_type = "bool";
+            } else if(T->isIntegerTy()) {
+                peko_type = peko_type == "u8" ? "u8" : "i" + std::to_string(T->getIntegerBitWidth());
+            } else if(T == Builder.getInt8PtrTy()) {
+                peko_type = "string";
+            } else if(auto vec = llvm::dyn_cast<llvm::FixedVectorType>(T)) {
+                peko_type = "vec" + std::to_string(vec->getNumElements());
+            } else {
+                return nullptr;
+            }
+        } else if(!allocatedObjects.count(peko_type)) {
+            peko_type = getTypeName(T);
+        }
+
+        if(DbgTypes.count(peko_type)) {
+            return DbgTypes[peko_type];
+        }
+        DbgTypes[peko_type] = nullptr; // an object that holds itself is left out instead of recursing
+
+        auto &DL = TheModule->getDataLayout();
+        llvm::DIType *DT = nullptr;
+
+        if(peko_type == "number") {
+            DT = DBuilder->createBasicType("number", 64, llvm::dwarf::DW_ATE_float);
+        } else if(peko_type == "f32") {
+            DT = DBuilder->createBasicType("f32", 32, llvm::dwarf::DW_ATE_float);
+        } else if(peko_type == "i32" || peko_type == "i16" || peko_type == "i8") {
+            DT = DBuilder->createBasicType(peko_type, std::stoi(peko_type.substr(1)), llvm::dwarf::DW_ATE_signed);
+        } else if(peko_type == "u8") {
+            DT = DBuilder->createBasicType("u8", 8, llvm::dwarf::DW_ATE_unsigned_char);
+        } else if(peko_type == "bool") {
+            DT = DBuilder->createBasicType("bool", 8, llvm::dwarf::DW_ATE_boolean);
+        } else if(peko_type == "string") {
+            DT = DBuilder->createPointerType(DBuilder->createBasicType("char", 8, llvm::dwarf::DW_ATE_signed_char), 64, 0, llvm::None, "string");
+        } else if(peko_type == "vec2" || peko_type == "vec4" || peko_type == "vec8") {
+            int lanes = peko_type.back() - '0';
+            llvm::Metadata *range = DBuilder->getOrCreateSubrange(0, lanes);
+            DT = DBuilder->createVectorType(lanes * 64, lanes * 64, debugType(Builder.getDoubleTy(), "number"), DBuilder->getOrCreateArray(range));
+        } else if(allocatedObjects.count(peko_type) && allocatedObjects[peko_type].struct_ty->isStructTy()) {
+            // The fields are shown where the layout put them, the @cold ones are behind the pointer to the cold block
+            auto &obj = allocatedObjects[peko_type];
+            auto ST = llvm::cast<llvm::StructType>(obj.struct_ty);
+            if(ST->isOpaque()) {
+                return nullptr;
+            }
+
+            auto layout = DL.getStructLayout(ST);
+            std::vector<llvm::Metadata *> members;
+            for(auto &field : obj.type_name_map) {
+                if(field.second < 0 || field.second >= ST->getNumElements()) {
+                    continue;
+                }
+
+                auto FT = ST->getElementType(field.second);
+                auto field_type = debugType(FT, obj.field_types.count(field.first) ? obj.field_types[field.first] : "");
+                if(field_type) {
+                    members.push_back(DBuilder->createMemberType(DbgCU, field.first, DbgFiles.at(0), 0, DL.getTypeSizeInBits(FT), DL.getABITypeAlign(FT).value() * 8, layout->getElementOffsetInBits(field.second), llvm::DINode::FlagZero, field_type));
+                }
+            }
+
+            DT = DBuilder->createStructType(DbgCU, peko_type, DbgFiles.at(0), 0, DL.getTypeSizeInBits(ST), DL.getABITypeAlign(ST).value() * 8, llvm::DINode::FlagZero, nullptr, DBuilder->getOrCreateArray(members));
+        }
+
+        DbgTypes[peko_type] = DT;
+        return DT;
+    }
+
+    /**
+     * @brief Gives a function the debug info that ties its code to the peko source, and starts its code at the line it's declared on
+     * 
+     * @param F 
+     * @param Proto 
+     * @param fn where the function is declared
+     */
+    void debugFunction(llvm::Function *F, ProtoAST *Proto, ExpAST *fn) {
+        Builder.SetCurrentDebugLocation(llvm::DebugLoc());
+        if(!debug_info) {
+            return;
+        }
+
+        std::map<std::string, std::string> arg_types;
+        for(auto &arg : Proto->getArgs()) {
+            arg_types[arg.first] = arg.second.second;
+        }
+
+        std::vector<llvm::Metadata *> types = {F->getReturnType()->isVoidTy() ? nullptr : debugType(F->getReturnType(), Proto->fn_type.second)};
+        for(auto &Arg : F->args()) {
+            types.push_back(debugType(Arg.getType(), arg_types[std::string(Arg.getName())]));
+        }
+
+        auto file = DbgFiles.at(fn->file);
+        auto flags = llvm::DISubprogram::SPFlagDefinition;
+        if(F->hasLocalLinkage()) {
+            flags |= llvm::DISubprogram::SPFlagLocalToUnit;
+        }
+        if(DbgCU->isOptimized()) {
+            flags |= llvm::DISubprogram::SPFlagOptimized;
+        }
+
+        auto SP = DBuilder->createFunction(file, Proto->getName(), F->getName(), file, fn->line, DBuilder->createSubroutineType(DBuilder->getOrCreateTypeArray(types)), fn->line, llvm::DINode::FlagPrototyped, flags);
+        F->setSubprogram(SP);
+        Builder.SetCurrentDebugLocation(llvm::DILocation::get(TheContext, fn->line, fn->col, SP));
+    }
+
+    /**
+     * @brief Makes the code generated next belong to the line of a statement
+     * 
+     * @param ast 
+     */
+    void debugLoc(ExpAST *ast) {
+        if(!debug_info || !ast || !ast->line || !Builder.GetInsertBlock()) {
+            return;
+        }
+
+        auto SP = Builder.GetInsertBlock()->getParent()->getSubprogram();
+        if(!SP) {
+            return;
+        }
+
+        // A statement from another file, like a generic that was imported, keeps its own file
+        llvm::DIScope *scope = SP;
+        if(DbgFiles.at(ast->file) != SP->getFile()) {
+            scope = DBuilder->createLexicalBlockFile(SP, DbgFiles.at(ast->file));
+        }
+
+        Builder.SetCurrentDebugLocation(llvm::DILocation::get(TheContext, ast->line, ast->col, scope));
+    }
+
+    /**
+     * @brief Tells debuggers about a variable or argument, by where it's stored or by its value for the ones that aren't stored
+     * 
+     * @param V the alloca of the variable or its value
+     * @param name 
+     * @param T the llvm type of the variable
+     * @param peko_type 
+     * @param line 
+     * @param arg_no the number of the argument counting from 1, 0 for a variable
+     */
+    void debugVariable(llvm::Value *V, const std::string &name, llvm::Type *T, const std::string &peko_type, int line, unsigned arg_no = 0) {
+        if(!debug_info || !V || !Builder.GetInsertBlock()) {
+            return;
+        }
+
+        auto SP = Builder.GetInsertBlock()->getParent()->getSubprogram();
+        auto DT = SP ? debugType(T, peko_type) : nullptr;
+        if(!DT) {
+            return;
+        }
+
+        // Kept even when optimizations leave the variable unused, so it still shows up as optimized out
+        llvm::DILocalVariable *var;
+        if(arg_no) {
+            var = DBuilder->createParameterVariable(SP, name, arg_no, SP->getFile(), line, DT, true);
+        } else {
+            var = DBuilder->createAutoVariable(SP, name, SP->getFile(), line, DT, true);
+        }
+
+        auto loc = llvm::DILocation::get(TheContext, line, 0, SP);
+        if(auto alloca = llvm::dyn_cast<llvm::AllocaInst>(V)) {
+            DBuilder->insertDeclare(alloca, var, DBuilder->createExpression(), loc, alloca->getParent());
+        } else {
+            DBuilder->insertDbgValueIntrinsic(V, var, DBuilder->createExpression(), loc, Builder.GetInsertBlock());
+        }
+    }
+
     /**
      * @brief Gets a Builder.CreateGEP capable index from an int
      * 
@@ -535,164 +985,1389 @@ namespace ASTS {
     llvm::Value *prev_llvm_value = nullptr;
     ExpAST *lhs_buf = nullptr;
     ExpAST *rhs_buf = nullptr;
+    ArrayAccAST *elem_acc_buf = nullptr; // the array access an object access started with, ex: points[0].x
+    llvm::Value *elem_buf = nullptr;
+
+
+    /**
+     * @brief Gets the type of an array with the given element type and depth. Arrays are stored as
+     * their data pointer and their length ({T*, i64}), so arrays of arrays hold the data and length of every row
+     * 
+     * @param type the type of the innermost elements
+     * @param depth how many dimensions the array has
+     * @return llvm::StructType* 
+     */
+    llvm::StructType *getArrType(llvm::Type *type, int depth) {
+        llvm::Type *arr_type = type;
+        for(int i = 0; i < depth; i++) {
+            arr_type = llvm::StructType::get(TheContext, {llvm::PointerType::getUnqual(arr_type), llvm::Type::getInt64Ty(TheContext)});
+        }
 
+        return llvm::cast<llvm::StructType>(arr_type);
+    }
 
     bool isArrType(llvm::Type *t) {
-        std::string type_name; llvm::raw_string_ostream rso(type_name);
-        t->print(rso); type_name = rso.str();
+        auto struct_type = llvm::dyn_cast<llvm::StructType>(t);
 
-        return (type_name.find("***") != std::string::npos);
+        // Objects are named structs, so only the literal {T*, i64} struct is an array
+        return struct_type && struct_type->isLiteral() && struct_type->getNumElements() == 2 &&
+               struct_type->getElementType(0)->isPointerTy() && struct_type->getElementType(1)->isIntegerTy(64);
     }
 
+    llvm::Value *copyColdBlocks(llvm::Value *val);
+    bool isArrayExp(ExpAST *exp);
+    llvm::Value *fuseArrayExp(ExpAST *exp, llvm::Value *fixed_dest);
+
     /**
-     * @brief Resets the previsouly declared variables for the next object access
+     * @brief Arrays of objects and arrays of arrays store their elements by value, so a pointer to one is loaded before being stored
      * 
+     * @param val 
+     * @return llvm::Value* 
      */
-    void resetObjRecVars() {
-        prev_exp_ast = nullptr;
-        prev_llvm_value = nullptr;
-        lhs_buf = nullptr;
-        rhs_buf = nullptr;
+    llvm::Value *loadIfAggregatePtr(llvm::Value *val) {
+        if(val->getType()->isPointerTy() && val->getType()->getPointerElementType()->isStructTy()) {
+            return copyColdBlocks(Builder.CreateLoad(val));
+        }
+
+        return val;
     }
 
-    llvm::Value *getArrElementIndex(int i) {
-        return llvm::ConstantInt::get(llvm::Type::getInt64Ty(TheContext), llvm::APInt(64, i));
+    /**
+     * @brief Gets the llvm type of a number type: number is a double, f32 a float and i32, i16, i8 and u8 are integers of that size
+     * 
+     * @param name 
+     * @return llvm::Type* nullptr if name isn't a number type
+     */
+    llvm::Type *getNumType(const std::string &name) {
+        if(name == "number") {
+            return Builder.getDoubleTy();
+        } else if(name == "f32") {
+            return Builder.getFloatTy();
+        } else if(name == "i32") {
+            return Builder.getInt32Ty();
+        } else if(name == "i16") {
+            return Builder.getInt16Ty();
+        } else if(name == "i8" || name == "u8") {
+            return Builder.getInt8Ty();
+        } else if(name == "vec2" || name == "vec4" || name == "vec8") {
+            return llvm::FixedVectorType::get(Builder.getDoubleTy(), std::stoi(name.substr(3)));
+        }
+
+        return nullptr;
     }
 
-    llvm::Value *inst_arr(llvm::Type *type, int depth) {
-        llvm::Value *previousarr = nullptr;
-        llvm::Type *previoustype = nullptr;
-        llvm::Type *previoustypenoptr = nullptr;
+    bool isNumType(llvm::Type *t) {
+        return t->isDoubleTy() || t->isFloatTy() || t->isIntegerTy(32) || t->isIntegerTy(16) || t->isIntegerTy(8);
+    }
 
-        for(int i = 0; i < depth; i++) {
-            if(previousarr == nullptr) {
-                // instantiate the array
-                auto type_to_alloc = llvm::PointerType::getUnqual(type);
-                auto alloc_arr = Builder.CreateAlloca(type_to_alloc, 0, "");
-                auto size = llvm::ConstantExpr::getSizeOf(type);
-
-                auto malloc = llvm::CallInst::CreateMalloc(
-                    Builder.GetInsertBlock(),
-                    llvm::Type::getInt64Ty(TheContext),
-                    type, 
-                    size, 
-                    nullptr,
-                    nullptr, 
-                    ""
-                );
-                auto bitcast = Builder.Insert(Builder.CreateBitCast(malloc, type_to_alloc));
-                Builder.CreateStore(bitcast, alloc_arr);
-
-                auto load_arr = Builder.CreateLoad(alloc_arr);
-                auto load_elem = Builder.CreateGEP(load_arr, getArrElementIndex(0));
-
-                previousarr = alloc_arr;
-                previoustype = type_to_alloc;
-            } else {
-                // instantiate the array
-                auto type_to_alloc = llvm::PointerType::getUnqual(previoustype);
-                auto alloc_arr = Builder.CreateAlloca(type_to_alloc, 0, "");
-                auto size = llvm::ConstantExpr::getSizeOf(type_to_alloc);
-
-                auto malloc = llvm::CallInst::CreateMalloc(
-                    Builder.GetInsertBlock(),
-                    llvm::Type::getInt64Ty(TheContext),
-                    previoustype, 
-                    size, 
-                    nullptr,
-                    nullptr, 
-                    ""
-                );
-                auto bitcast = Builder.Insert(Builder.CreateBitCast(malloc, type_to_alloc));
-                Builder.CreateStore(bitcast, alloc_arr);
-
-                auto load_arr = Builder.CreateLoad(alloc_arr);
-                auto load_elem = Builder.CreateGEP(load_arr, getArrElementIndex(0));
-
-                Builder.CreateStore(Builder.CreateLoad(previousarr), load_elem);
-                previousarr = alloc_arr;
-                previoustype = type_to_alloc;
-            }
-        } 
+    /**
+     * @brief Gets the name of a number type for errors
+     * 
+     * @param t 
+     * @param is_unsigned 
+     * @return std::string 
+     */
+    std::string numTypeName(llvm::Type *t, bool is_unsigned) {
+        if(t->isDoubleTy()) {
+            return "number";
+        } else if(t->isFloatTy()) {
+            return "f32";
+        } else if(t->isIntegerTy(8)) {
+            return is_unsigned ? "u8" : "i8";
+        }
 
-        return previousarr;
+        return "i" + std::to_string(t->getIntegerBitWidth());
     }
 
-    void setElementAtIndex(llvm::Value *arr, int index, llvm::Value *set) {
-        auto load_arr = Builder.CreateLoad(arr);
+    /**
+     * @brief Converts a number to another number type, which rounds towards 0 when a float becomes an integer.
+     * A float outside of the integer type's range becomes the closest value in it and NaN becomes 0, ex: u8(300.0) is 255
+     * 
+     * @param val 
+     * @param type 
+     * @param from_unsigned if val is a u8
+     * @param to_unsigned if type is a u8
+     * @return llvm::Value* 
+     */
+    llvm::Value *convertNum(llvm::Value *val, llvm::Type *type, bool from_unsigned, bool to_unsigned) {
+        auto from = val->getType();
+
+        if(from->isFloatingPointTy() && type->isFloatingPointTy()) {
+            return Builder.CreateFPCast(val, type, "conv");
+        } else if(from->isFloatingPointTy()) {
+            return Builder.CreateIntrinsic(to_unsigned ? llvm::Intrinsic::fptoui_sat : llvm::Intrinsic::fptosi_sat, {type, from}, {val}, nullptr, "conv");
+        } else if(type->isFloatingPointTy()) {
+            return from_unsigned ? Builder.CreateUIToFP(val, type, "conv") : Builder.CreateSIToFP(val, type, "conv");
+        }
 
-        Builder.CreateStore(set, Builder.CreateGEP(load_arr, getArrElementIndex(index)));
+        return Builder.CreateIntCast(val, type, !from_unsigned, "conv");
     }
 
-    llvm::Value *getElementAtIndex(llvm::Value *arr, int index) {
-        auto load_arr = Builder.CreateLoad(arr);
-        return Builder.CreateGEP(load_arr, getArrElementIndex(index));
+    /**
+     * @brief Returns true if a peko type is a slice, ex: number .. for a number[..]
+     * 
+     * @param peko_type 
+     * @return true 
+     * @return false 
+     */
+    bool isSliceName(const std::string &peko_type) {
+        return peko_type.size() > 3 && peko_type.compare(peko_type.size() - 3, 3, " ..") == 0;
+    }
+
+    /**
+     * @brief Gets the llvm type of a slice, which has the same {T*, i64} layout as a growable array
+     * 
+     * @param type_name ex: number .., or u8 .. for a strview
+     * @return llvm::StructType* nullptr if the type isn't a slice
+     */
+    llvm::StructType *getSliceType(const std::string &type_name) {
+        if(!isSliceName(type_name)) {
+            return nullptr;
+        }
+
+        std::string elem_name = type_name.substr(0, type_name.size() - 3);
+        llvm::Type *elem = getNumType(elem_name);
+        if(elem_name == "string") {
+            elem = llvm::Type::getInt8PtrTy(TheContext);
+        } else if(elem_name == "bool") {
+            elem = llvm::Type::getInt1Ty(TheContext);
+        } else if(!elem && allocatedObjects.count(elem_name)) {
+            elem = allocatedObjects[elem_name].struct_ty;
+        }
+
+        return elem ? getArrType(elem, 1) : nullptr;
     }
 
-    void appElement(llvm::Value *arr, llvm::Value *appendee, int newSize) {
-        auto elem_0 = getElementAtIndex(arr, 0);
-        auto elem_type = elem_0->getType();
-        auto bas_elem_type = Builder.CreateLoad(elem_0)->getType();
-        auto arrbuf = Builder.CreateAlloca(elem_type, 0, "");
-        Builder.CreateStore(Builder.CreateLoad(arr), arrbuf);
-        auto size = Builder.CreateMul(llvm::ConstantExpr::getSizeOf(arr->getType()), llvm::ConstantInt::get(TheContext, llvm::APInt(64, newSize, true)), "");
+    /**
+     * @brief Returns true if a value is a strview or a pointer to one, u8[] arrays have the same layout so they count too
+     * 
+     * @param val 
+     * @return true 
+     * @return false 
+     */
+    bool isStrView(llvm::Value *val) {
+        auto view_type = getArrType(Builder.getInt8Ty(), 1);
+        return val->getType() == view_type || (val->getType()->isPointerTy() && val->getType()->getPointerElementType() == view_type);
+    }
 
-        auto malloc = llvm::CallInst::CreateMalloc(
-            Builder.GetInsertBlock(),
-            llvm::Type::getInt64Ty(TheContext),
-            bas_elem_type, 
-            size, 
-            nullptr,
-            nullptr, 
-            ""
-        );
+    /**
+     * @brief Gets the bytes and length of a string or a strview, the length of a string is found with strlen
+     * 
+     * @param val a string, a strview or a pointer to a strview
+     * @param ptr 
+     * @param len 
+     * @return true 
+     * @return false if val isn't text
+     */
+    bool getTextParts(llvm::Value *val, llvm::Value *&ptr, llvm::Value *&len) {
+        if(val->getType() == llvm::Type::getInt8PtrTy(TheContext)) {
+            ptr = val;
+            len = Builder.CreateCall(TheModule->getFunction("strlen"), {val}, "strlen");
+            return true;
+        }
+
+        if(!isStrView(val)) {
+            return false;
+        }
 
-        auto bitcast = Builder.Insert(Builder.CreateBitCast(malloc, elem_type));
-        Builder.CreateStore(bitcast, arr);
+        val = loadIfAggregatePtr(val);
 
-        Builder.CreateStore(Builder.CreateLoad(arrbuf), arr);
-    
-        Builder.CreateStore(appendee, getElementAtIndex(arr, newSize-1));
+        ptr = Builder.CreateExtractValue(val, 0);
+        len = Builder.CreateExtractValue(val, 1);
+        return true;
     }
 
-    llvm::Value *ObjectAccAST::irgen() {
-        if(!lhs_buf && !prev_llvm_value && !prev_exp_ast && !rhs_buf) {
-            lhs_buf = LHS.get();
-            rhs_buf = RHS.get();
-            auto rb_buf = rhs_buf;
-            auto lb_buf = lhs_buf;
+    /**
+     * @brief Converts between numbers and bools where one is expected but the other was given.
+     * A number is true when it isn't 0, and true and false become 1 and 0.
+     * Number literals become the number type that is expected, other numbers have to be converted with a call like f32(x)
+     * 
+     * @param val 
+     * @param type the type that is expected
+     * @return llvm::Value* 
+     */
+    llvm::Value *castValue(llvm::Value *val, llvm::Type *type) {
+        if(val->getType() == type) {
+            return val;
+        }
 
-            if(!strcmp(lhs_buf->getType(), "id")) {
-                auto lhs_to_id = dynamic_cast<IdHolder*>(lhs_buf);
-                prev_llvm_value = NamedValues[lhs_to_id->getId()].val;
-            } else if(!strcmp(lhs_buf->getType(), "call")) {
-                prev_llvm_value = lhs_buf->irgen();
+        // A number used with a vec is the same in every lane, ex: v * 2.0
+        if(type->isVectorTy() && (isNumType(val->getType()) || val->getType()->isIntegerTy(1))) {
+            return Builder.CreateVectorSplat(llvm::cast<llvm::FixedVectorType>(type)->getNumElements(), castValue(val, type->getScalarType()));
+        }
+
+        // Arrays and slices are passed around as a pointer to them, and a fixed size array becomes a slice of all of it
+        if(isArrType(type) && val->getType()->isPointerTy()) {
+            auto pointee = val->getType()->getPointerElementType();
+            if(pointee == type) {
+                return Builder.CreateLoad(val);
+            } else if(pointee->isArrayTy() && llvm::PointerType::getUnqual(pointee->getArrayElementType()) == type->getStructElementType(0)) {
+                llvm::Value *slice = llvm::UndefValue::get(type);
+                slice = Builder.CreateInsertValue(slice, Builder.CreateInBoundsGEP(val, {Builder.getInt64(0), Builder.getInt64(0)}), 0);
+                return Builder.CreateInsertValue(slice, Builder.getInt64(pointee->getArrayNumElements()), 1);
             }
+        }
 
-            lhs_buf = lb_buf;
-            rhs_buf = rb_buf;
-            
-            prev_exp_ast = lhs_buf;
-            lhs_buf = rhs_buf;
+        // A string is viewed in place where a strview is expected
+        if(type == getArrType(Builder.getInt8Ty(), 1) && val->getType() == llvm::Type::getInt8PtrTy(TheContext)) {
+            llvm::Value *view = llvm::UndefValue::get(type);
+            view = Builder.CreateInsertValue(view, val, 0);
+            return Builder.CreateInsertValue(view, Builder.CreateCall(TheModule->getFunction("strlen"), {val}, "strlen"), 1);
+        }
 
-            return this->irgen();
-        } else if(!strcmp(lhs_buf->getType(), "id")) {
-            // Convert the current lhs (rhs) to and IdHolder ast
-            auto lhs_to_id = dynamic_cast<IdHolder*>(lhs_buf);
+        // A strview isn't null terminated, so it is copied into a new string where one is expected
+        llvm::Value *text_ptr, *text_len;
+        if(type == llvm::Type::getInt8PtrTy(TheContext) && val->getType() != type && getTextParts(val, text_ptr, text_len)) {
+            return Builder.CreateCall(TheModule->getFunction("viewstr"), {text_ptr, text_len}, "viewstr");
+        }
 
-            // Find out the typename of the previous object to get its type name map
-            std::string prev_type_name = getTypeName(prev_llvm_value->getType());
-            
-            if(prev_type_name.empty()) {
-                return nullptr;
+        if(type->isIntegerTy(1)) {
+            if(val->getType()->isFloatingPointTy()) {
+                return Builder.CreateFCmpONE(val, llvm::ConstantFP::get(val->getType(), 0.0), "tobool");
+            } else if(isNumType(val->getType())) {
+                return Builder.CreateICmpNE(val, llvm::ConstantInt::get(val->getType(), 0), "tobool");
+            } else if(val->getType()->isPointerTy()) {
+                return Builder.CreateIsNotNull(val, "tobool");
+            }
+        } else if(isNumType(type) && val->getType()->isIntegerTy(1)) {
+            return type->isFloatingPointTy() ? Builder.CreateUIToFP(val, type, "tonum") : Builder.CreateZExt(val, type, "tonum");
+        } else if(isNumType(type) && isNumType(val->getType())) {
+            auto *lit = llvm::dyn_cast<llvm::ConstantFP>(val);
+            if(!lit || !lit->getType()->isDoubleTy()) {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m expected a " + numTypeName(type, false) + " but got a " + numTypeName(val->getType(), false) + ", convert it with " + numTypeName(type, false) + "(...)");
+                return val;
             }
 
-            int acc_num = allocatedObjects[prev_type_name].type_name_map[lhs_to_id->getId()];
+            // A literal has to fit the integer exactly, either sign is allowed for 8 bits since i8 and u8 look the same here
+            double num = lit->getValueAPF().convertToDouble();
+            if(type->isIntegerTy()) {
+                double max = std::ldexp(1.0, type->getIntegerBitWidth() - (type->isIntegerTy(8) ? 0 : 1));
+                double min = -std::ldexp(1.0, type->getIntegerBitWidth() - 1);
+                if(num != std::trunc(num) || num < min || num >= max) {
+                    std::ostringstream num_str;
+                    num_str << num;
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m " + num_str.str() + " isn't a whole number that fits in " + std::to_string(type->getIntegerBitWidth()) + " bits");
+                    return val;
+                }
 
-            // Create a GEP to get the value out of the previous object
-            auto return_gep = Builder.CreateGEP(prev_llvm_value, getGEPIndex(acc_num));
+                return llvm::ConstantInt::get(type, (uint64_t)(int64_t)num);
+            }
+
+            return llvm::ConstantFP::get(type, num);
+        }
+
+        return val;
+    }
+
+    /**
+     * @brief Does + - * / or % on two numbers of the same type.
+     * Integers divided by 0 give 0 and their remainder is the number divided. The smallest signed integer divided by -1
+     * wraps back to itself, with a remainder of 0
+     * 
+     * @param op 
+     * @param L 
+     * @param R 
+     * @param is_unsigned if the numbers are u8s
+     * @return llvm::Value* nullptr if op isn't arithmetic
+     */
+    llvm::Value *numArith(const std::string &op, llvm::Value *L, llvm::Value *R, bool is_unsigned) {
+        if(L->getType()->isFPOrFPVectorTy()) {
+            if(op == "+") {
+                return Builder.CreateFAdd(L, R, "addtmp");
+            } else if(op == "-") {
+                return Builder.CreateFSub(L, R, "subtmp");
+            } else if(op == "*") {
+                return Builder.CreateFMul(L, R, "multmp");
+            } else if(op == "/") {
+                return Builder.CreateFDiv(L, R, "divtmp");
+            } else if(op == "%") {
+                // modnum works on doubles, so a f32 goes through one
+                auto num_ty = Builder.getDoubleTy();
+                auto rem = Builder.CreateCall(TheModule->getFunction("modnum"), {Builder.CreateFPExt(L, num_ty), Builder.CreateFPExt(R, num_ty)}, "calltmp");
+                return Builder.CreateFPCast(rem, L->getType());
+            }
+        } else {
+            if(op == "+") {
+                return Builder.CreateAdd(L, R, "addtmp");
+            } else if(op == "-") {
+                return Builder.CreateSub(L, R, "subtmp");
+            } else if(op == "*") {
+                return Builder.CreateMul(L, R, "multmp");
+            } else if(op == "/" || op == "%") {
+                // Dividing by 0 or the smallest signed integer by -1 is undefined in LLVM, so those divide by 1 instead and
+                // the results are picked after. A constant divisor that is neither doesn't need it
+                auto const_R = llvm::dyn_cast<llvm::ConstantInt>(R);
+                if(!const_R && llvm::isa<llvm::Constant>(R)) {
+                    const_R = llvm::dyn_cast_or_null<llvm::ConstantInt>(llvm::cast<llvm::Constant>(R)->getSplatValue());
+                }
+                if(const_R && !const_R->isZero() && (is_unsigned || !const_R->isMinusOne())) {
+                    if(op == "/") {
+                        return is_unsigned ? Builder.CreateUDiv(L, R, "divtmp") : Builder.CreateSDiv(L, R, "divtmp");
+                    }
+                    return is_unsigned ? Builder.CreateURem(L, R, "remtmp") : Builder.CreateSRem(L, R, "remtmp");
+                }
+
+                auto by_zero = Builder.CreateICmpEQ(R, llvm::Constant::getNullValue(R->getType()), "byzero");
+                auto bad_div = by_zero;
+                if(!is_unsigned) {
+                    auto int_min = llvm::ConstantInt::get(R->getType(), llvm::APInt::getSignedMinValue(R->getType()->getScalarSizeInBits()));
+                    auto overflows = Builder.CreateAnd(Builder.CreateICmpEQ(L, int_min), Builder.CreateICmpEQ(R, llvm::Constant::getAllOnesValue(R->getType())), "divoverflow");
+                    bad_div = Builder.CreateOr(by_zero, overflows);
+                }
+                auto safe_R = Builder.CreateSelect(bad_div, llvm::ConstantInt::get(R->getType(), 1), R);
+
+                if(op == "/") {
+                    auto div = is_unsigned ? Builder.CreateUDiv(L, safe_R, "divtmp") : Builder.CreateSDiv(L, safe_R, "divtmp");
+                    return Builder.CreateSelect(by_zero, llvm::Constant::getNullValue(L->getType()), div);
+                }
+
+                auto rem = is_unsigned ? Builder.CreateURem(L, safe_R, "remtmp") : Builder.CreateSRem(L, safe_R, "remtmp");
+                return Builder.CreateSelect(by_zero, L, rem);
+            }
+        }
+
+        return nullptr;
+    }
+
+    /**
+     * @brief Gets an i1 that can be branched on from the value of a condition
+     * 
+     * @param val 
+     * @return llvm::Value* 
+     */
+    llvm::Value *toCondition(llvm::Value *val) {
+        return castValue(val, llvm::Type::getInt1Ty(TheContext));
+    }
+
+    /**
+     * @brief Resets the previsouly declared variables for the next object access
+     * 
+     */
+    void resetObjRecVars() {
+        prev_exp_ast = nullptr;
+        prev_llvm_value = nullptr;
+        lhs_buf = nullptr;
+        rhs_buf = nullptr;
+        elem_acc_buf = nullptr;
+        elem_buf = nullptr;
+    }
+
+    llvm::Value *getArrElementIndex(int i) {
+        return llvm::ConstantInt::get(llvm::Type::getInt64Ty(TheContext), llvm::APInt(64, i));
+    }
+
+    /**
+     * @brief Allocates an empty array on the stack
+     * 
+     * @param type the type of the innermost elements
+     * @param depth how many dimensions the array has
+     * @return llvm::Value* a pointer to the {T*, i64} of the array
+     */
+    llvm::Value *inst_arr(llvm::Type *type, int depth) {
+        auto arr_type = getArrType(type, depth);
+        auto alloc_arr = Builder.CreateAlloca(arr_type, 0, "");
+        Builder.CreateStore(llvm::Constant::getNullValue(arr_type), alloc_arr);
+
+        return alloc_arr;
+    }
+
+    /**
+     * @brief Mallocs the buffer of an array
+     * 
+     * @param elem_type 
+     * @param count the amount of elements the buffer can hold
+     * @return llvm::Value* 
+     */
+    llvm::Value *mallocArrData(llvm::Type *elem_type, llvm::Value *count) {
+        auto malloc = llvm::CallInst::CreateMalloc(
+            Builder.GetInsertBlock(),
+            llvm::Type::getInt64Ty(TheContext),
+            elem_type, 
+            llvm::ConstantExpr::getSizeOf(elem_type), 
+            count,
+            nullptr, 
+            ""
+        );
+
+        return Builder.Insert(Builder.CreateBitCast(malloc, llvm::PointerType::getUnqual(elem_type)));
+    }
+
+    /**
+     * @brief Gets the llvm type of a fixed size array, ex: number[4], whose type name is "number 4"
+     * 
+     * @param type_name 
+     * @return llvm::ArrayType* nullptr if the type isn't a fixed size array
+     */
+    llvm::ArrayType *getFixedArrType(const std::string &type_name) {
+        std::vector<std::string> parts;
+        split(type_name, " ", parts);
+
+        if(parts.size() < 2) {
+            return nullptr;
+        }
+
+        llvm::Type *T = getNumType(parts.at(0));
+        if(parts.at(0) == "string") {
+            T = Builder.getInt8PtrTy();
+        } else if(parts.at(0) == "bool") {
+            T = Builder.getInt1Ty();
+        } else if(!T) {
+            T = allocatedObjects[parts.at(0)].struct_ty;
+        }
+
+        // The first size is the outermost, so number[2][3] is 2 arrays of 3 numbers
+        for(int i = parts.size() - 1; i > 0; i--) {
+            if(!isdigit(parts.at(i).at(0)) || !T) {
+                return nullptr;
+            }
+
+            T = llvm::ArrayType::get(T, std::stoull(parts.at(i)));
+        }
+
+        return llvm::cast<llvm::ArrayType>(T);
+    }
+
+    /**
+     * @brief Fills the memory of a fixed size array with a value: nothing zeroes it, a list of values is stored one by one
+     * and missing values are zero, and another array of the same type is copied over with a memcpy
+     * 
+     * @param ptr a pointer to the array
+     * @param value 
+     * @param name the name of the array for errors
+     */
+    void initFixedArr(llvm::Value *ptr, ExpAST *value, const std::string &name) {
+        if(value && isArrayExp(value)) {
+            fuseArrayExp(value, ptr);
+            return;
+        }
+
+        auto arr_type = llvm::cast<llvm::ArrayType>(ptr->getType()->getPointerElementType());
+        auto elem_type = arr_type->getElementType();
+        auto lit = dynamic_cast<ArrayLitAST*>(value);
+        auto &DL = TheModule->getDataLayout();
+
+        if(lit && lit->getSize() > arr_type->getNumElements()) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m " + std::to_string(lit->getSize()) + " values don't fit in " + name + ", which holds " + std::to_string(arr_type->getNumElements()));
+            return;
+        }
+
+        // A row of constants is copied out of a read only global, with the missing values as 0
+        std::vector<llvm::Value *> vals;
+        if(lit && !elem_type->isArrayTy()) {
+            std::vector<llvm::Constant *> const_elems;
+            for(int i = 0; i < lit->getSize(); i++) {
+                auto val = lit->getElement(i)->irgen();
+                if(!val) {
+                    return;
+                }
+
+                vals.push_back(castValue(loadIfAggregatePtr(val), elem_type));
+                if(auto const_elem = llvm::dyn_cast<llvm::Constant>(vals.back())) {
+                    const_elems.push_back(const_elem);
+                }
+            }
+
+            if(const_elems.size() == vals.size() && vals.size() > 0) {
+                const_elems.resize(arr_type->getNumElements(), llvm::Constant::getNullValue(elem_type));
+
+                auto global = new llvm::GlobalVariable(*TheModule, arr_type, true, llvm::GlobalValue::PrivateLinkage, llvm::ConstantArray::get(arr_type, const_elems), "arrlit");
+                global->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+                global->setAlignment(DL.getABITypeAlign(arr_type));
+                Builder.CreateMemCpy(ptr, DL.getABITypeAlign(arr_type), global, DL.getABITypeAlign(arr_type), DL.getTypeAllocSize(arr_type));
+                return;
+            }
+        }
+
+        if(!value || (lit && lit->getSize() < arr_type->getNumElements())) {
+            Builder.CreateStore(llvm::Constant::getNullValue(arr_type), ptr);
+        }
+
+        if(lit) {
+            for(int i = 0; i < lit->getSize(); i++) {
+                auto elem_ptr = Builder.CreateInBoundsGEP(ptr, {Builder.getInt64(0), Builder.getInt64(i)});
+
+                if(elem_type->isArrayTy()) {
+                    initFixedArr(elem_ptr, lit->getElement(i), name);
+                    continue;
+                }
+
+                Builder.CreateStore(vals[i], elem_ptr);
+            }
+        } else if(value) {
+            auto val = value->irgen();
+            if(!val) {
+                return;
+            }
+
+            if(val->getType() != ptr->getType()) {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m only a list of values or an array of the same size can be put in " + name);
+                return;
+            }
+
+            // The array may be copied onto itself, ex: a = a, which memcpy doesn't allow. llvm turns it back into a memcpy when the two can't overlap
+            Builder.CreateMemMove(ptr, DL.getABITypeAlign(arr_type), val, DL.getABITypeAlign(arr_type), DL.getTypeAllocSize(arr_type));
+        }
+    }
+
+    /**
+     * @brief Checks if the block can be reached again after leaving it, which means it's inside of a loop
+     * 
+     * @param BB 
+     * @return true 
+     * @return false 
+     */
+    bool inCycle(llvm::BasicBlock *BB) {
+        std::set<llvm::BasicBlock *> visited;
+        std::vector<llvm::BasicBlock *> worklist(llvm::succ_begin(BB), llvm::succ_end(BB));
+
+        while(!worklist.empty()) {
+            auto *cur = worklist.back();
+            worklist.pop_back();
+
+            if(cur == BB) {
+                return true;
+            }
+
+            if(visited.insert(cur).second) {
+                worklist.insert(worklist.end(), llvm::succ_begin(cur), llvm::succ_end(cur));
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Checks if a function can keep an array or slice argument past the call, or let go of its buffer.
+     * It may read and write the elements, take slices of it, hold it in its own variables and pass it on to
+     * functions that don't keep it either. Returning it, storing it in memory or growing it counts as keeping it
+     * 
+     * @param arg 
+     * @param visiting the arguments being checked, a function passing the array back into itself doesn't keep it by doing so
+     * @return true if the argument can be kept
+     */
+    bool argCaptured(llvm::Argument *arg, std::set<llvm::Argument *> &visiting) {
+        if(!visiting.insert(arg).second) {
+            return false;
+        }
+
+        enum { ptr, aggregate, header };
+        std::set<llvm::Value *> visited;
+        std::vector<std::pair<llvm::Value *, int>> worklist = {{arg, aggregate}};
+
+        while(!worklist.empty()) {
+            auto cur = worklist.back();
+            worklist.pop_back();
+
+            if(!visited.insert(cur.first).second) {
+                continue;
+            }
+
+            for(auto *user : cur.first->users()) {
+                auto *inst = llvm::dyn_cast<llvm::Instruction>(user);
+                if(!inst) {
+                    return true;
+                }
+
+                if(cur.second == ptr) {
+                    if(llvm::isa<llvm::GetElementPtrInst>(inst) || llvm::isa<llvm::BitCastInst>(inst) || llvm::isa<llvm::PHINode>(inst) || llvm::isa<llvm::SelectInst>(inst)) {
+                        worklist.push_back({inst, ptr});
+                    } else if(llvm::isa<llvm::LoadInst>(inst) || llvm::isa<llvm::ICmpInst>(inst) || llvm::isa<llvm::MemIntrinsic>(inst)) {
+                        continue;
+                    } else if(auto *store = llvm::dyn_cast<llvm::StoreInst>(inst)) {
+                        if(store->getValueOperand() == cur.first) {
+                            return true;
+                        }
+                    } else if(auto *insert = llvm::dyn_cast<llvm::InsertValueInst>(inst)) {
+                        // A slice of the argument
+                        if(insert->getInsertedValueOperand() != cur.first || insert->getIndices()[0] != 0) {
+                            return true;
+                        }
+                        worklist.push_back({inst, aggregate});
+                    } else {
+                        return true;
+                    }
+                } else if(cur.second == aggregate) {
+                    if(auto *extract = llvm::dyn_cast<llvm::ExtractValueInst>(inst)) {
+                        if(extract->getIndices()[0] == 0) {
+                            worklist.push_back({inst, ptr});
+                        }
+                    } else if(auto *insert = llvm::dyn_cast<llvm::InsertValueInst>(inst)) {
+                        if(insert->getAggregateOperand() != cur.first) {
+                            return true;
+                        }
+                        worklist.push_back({inst, aggregate});
+                    } else if(auto *store = llvm::dyn_cast<llvm::StoreInst>(inst)) {
+                        auto *alloca = llvm::dyn_cast<llvm::AllocaInst>(store->getPointerOperand());
+                        if(!alloca) {
+                            return true;
+                        }
+                        worklist.push_back({alloca, header});
+                    } else if(auto *call = llvm::dyn_cast<llvm::CallInst>(inst)) {
+                        auto *callee = call->getCalledFunction();
+                        if(!callee || callee->isDeclaration()) {
+                            return true;
+                        }
+
+                        for(unsigned i = 0; i < call->arg_size(); i++) {
+                            if(call->getArgOperand(i) == cur.first && argCaptured(callee->getArg(i), visiting)) {
+                                return true;
+                            }
+                        }
+                    } else {
+                        return true;
+                    }
+                } else {
+                    if(llvm::isa<llvm::LoadInst>(inst)) {
+                        worklist.push_back({inst, aggregate});
+                    } else if(!llvm::isa<llvm::StoreInst>(inst) || llvm::cast<llvm::StoreInst>(inst)->getValueOperand() == cur.first) {
+                        return true;
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Follows every use of an array buffer to see if a pointer to it can outlive the function.
+     * The buffer may be read and written through, grown, held by a single array variable and passed to functions
+     * that don't keep it. Anything else (storing it in memory, putting it in another array or object, passing it
+     * to a function that keeps it or that isn't in the program) counts as escaping
+     * 
+     * @param buffer the malloc of the buffer
+     * @param reallocs gets the calls that grow the buffer
+     * @param calls gets the calls the buffer is passed to
+     * @return true if the buffer escapes
+     */
+    bool arrBufferEscapes(llvm::CallInst *buffer, std::vector<llvm::CallInst *> &reallocs, std::vector<llvm::CallInst *> &calls) {
+        enum { ptr, aggregate, header };
+        std::set<llvm::Value *> visited;
+        std::vector<std::pair<llvm::Value *, int>> worklist = {{buffer, ptr}};
+        llvm::Value *holder = nullptr;
+        bool looped = inCycle(buffer->getParent());
+
+        while(!worklist.empty()) {
+            auto cur = worklist.back();
+            worklist.pop_back();
+
+            if(!visited.insert(cur.first).second) {
+                continue;
+            }
+
+            for(auto *user : cur.first->users()) {
+                auto *inst = llvm::dyn_cast<llvm::Instruction>(user);
+                if(!inst) {
+                    return true;
+                }
+
+                if(cur.second == ptr) {
+                    if(llvm::isa<llvm::GetElementPtrInst>(inst) || llvm::isa<llvm::BitCastInst>(inst)) {
+                        worklist.push_back({inst, ptr});
+                    } else if(llvm::isa<llvm::PHINode>(inst) && !looped) {
+                        // A for loop walks the buffer with a phi, which could see a newer copy of a literal made in a loop
+                        worklist.push_back({inst, ptr});
+                    } else if(llvm::isa<llvm::LoadInst>(inst) || llvm::isa<llvm::ICmpInst>(inst)) {
+                        continue;
+                    } else if(auto *store = llvm::dyn_cast<llvm::StoreInst>(inst)) {
+                        if(store->getValueOperand() == cur.first) {
+                            return true;
+                        }
+                    } else if(auto *insert = llvm::dyn_cast<llvm::InsertValueInst>(inst)) {
+                        if(insert->getInsertedValueOperand() != cur.first || insert->getIndices()[0] != 0) {
+                            return true;
+                        }
+                        worklist.push_back({inst, aggregate});
+                    } else if(llvm::isa<llvm::MemCpyInst>(inst) && llvm::cast<llvm::MemCpyInst>(inst)->getRawDest() == cur.first) {
+                        // Filling the buffer from the read only copy of a constant literal
+                        continue;
+                    } else if(auto *call = llvm::dyn_cast<llvm::CallInst>(inst)) {
+                        if(call->getCalledFunction() != TheModule->getFunction("realloc") || call->getArgOperand(0) != cur.first) {
+                            return true;
+                        }
+                        reallocs.push_back(call);
+                    } else {
+                        return true;
+                    }
+                } else if(cur.second == aggregate) {
+                    if(auto *insert = llvm::dyn_cast<llvm::InsertValueInst>(inst)) {
+                        if(insert->getAggregateOperand() != cur.first) {
+                            return true;
+                        }
+                        // Replacing the data pointer drops the buffer from the array
+                        if(insert->getIndices()[0] != 0) {
+                            worklist.push_back({inst, aggregate});
+                        }
+                    } else if(auto *extract = llvm::dyn_cast<llvm::ExtractValueInst>(inst)) {
+                        if(extract->getIndices()[0] == 0) {
+                            worklist.push_back({inst, ptr});
+                        }
+                    } else if(auto *store = llvm::dyn_cast<llvm::StoreInst>(inst)) {
+                        // Only one array variable may hold the buffer, a copy of the array would share it
+                        auto *alloca = llvm::dyn_cast<llvm::AllocaInst>(store->getPointerOperand());
+                        if(!alloca || (holder && holder != alloca)) {
+                            return true;
+                        }
+                        holder = alloca;
+                        worklist.push_back({alloca, header});
+                    } else if(auto *call = llvm::dyn_cast<llvm::CallInst>(inst)) {
+                        // The callee has to be done with the array when it returns, and a musttail call would throw the frame away first
+                        auto *callee = call->getCalledFunction();
+                        if(!callee || callee->isDeclaration() || call->isMustTailCall()) {
+                            return true;
+                        }
+
+                        for(unsigned i = 0; i < call->arg_size(); i++) {
+                            std::set<llvm::Argument *> visiting;
+                            if(call->getArgOperand(i) == cur.first && argCaptured(callee->getArg(i), visiting)) {
+                                return true;
+                            }
+                        }
+                        calls.push_back(call);
+                    } else {
+                        return true;
+                    }
+                } else {
+                    if(llvm::isa<llvm::LoadInst>(inst)) {
+                        worklist.push_back({inst, aggregate});
+                    } else if(!llvm::isa<llvm::StoreInst>(inst) || llvm::cast<llvm::StoreInst>(inst)->getValueOperand() == cur.first) {
+                        return true;
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Checks if the copy of a constant array literal could be written to or leave the function, through any of the arrays in it
+     * 
+     * @param data the pointer to the copy
+     * @param init the instructions that fill the copy, which are ignored
+     * @return true 
+     * @return false if the copy is only ever read
+     */
+    bool arrLitWritten(llvm::Instruction *data, std::vector<llvm::Instruction *> &init) {
+        enum { ptr, aggregate, header };
+        std::set<llvm::Value *> visited;
+        std::vector<std::pair<llvm::Value *, int>> worklist = {{data, ptr}};
+
+        while(!worklist.empty()) {
+            auto cur = worklist.back();
+            worklist.pop_back();
+
+            if(!visited.insert(cur.first).second) {
+                continue;
+            }
+
+            for(auto *user : cur.first->users()) {
+                auto *inst = llvm::dyn_cast<llvm::Instruction>(user);
+                if(!inst) {
+                    return true;
+                }
+
+                if(std::find(init.begin(), init.end(), inst) != init.end()) {
+                    continue;
+                }
+
+                if(cur.second == ptr) {
+                    if(llvm::isa<llvm::GetElementPtrInst>(inst) || llvm::isa<llvm::BitCastInst>(inst) || llvm::isa<llvm::PHINode>(inst)) {
+                        worklist.push_back({inst, ptr});
+                    } else if(llvm::isa<llvm::LoadInst>(inst)) {
+                        // The rows of a nested literal are read out of it
+                        if(isArrType(inst->getType())) {
+                            worklist.push_back({inst, aggregate});
+                        }
+                    } else if(llvm::isa<llvm::ICmpInst>(inst)) {
+                        continue;
+                    } else if(auto *insert = llvm::dyn_cast<llvm::InsertValueInst>(inst)) {
+                        if(insert->getInsertedValueOperand() != cur.first || insert->getIndices()[0] != 0) {
+                            return true;
+                        }
+                        worklist.push_back({inst, aggregate});
+                    } else {
+                        // Stores, calls and anything else may change the elements
+                        return true;
+                    }
+                } else if(cur.second == aggregate) {
+                    if(auto *extract = llvm::dyn_cast<llvm::ExtractValueInst>(inst)) {
+                        if(extract->getIndices()[0] == 0) {
+                            worklist.push_back({inst, ptr});
+                        }
+                    } else if(auto *insert = llvm::dyn_cast<llvm::InsertValueInst>(inst)) {
+                        if(insert->getAggregateOperand() != cur.first) {
+                            return true;
+                        }
+                        worklist.push_back({inst, aggregate});
+                    } else if(auto *store = llvm::dyn_cast<llvm::StoreInst>(inst)) {
+                        // An array variable holds the copy, everything that is loaded from the variable is checked too
+                        auto *alloca = llvm::dyn_cast<llvm::AllocaInst>(store->getPointerOperand());
+                        if(!alloca) {
+                            return true;
+                        }
+                        worklist.push_back({alloca, header});
+                    } else {
+                        return true;
+                    }
+                } else {
+                    if(llvm::isa<llvm::LoadInst>(inst)) {
+                        worklist.push_back({inst, aggregate});
+                    } else if(!llvm::isa<llvm::StoreInst>(inst) || llvm::cast<llvm::StoreInst>(inst)->getValueOperand() == cur.first) {
+                        return true;
+                    }
+                }
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Points the constant array literals of the function just generated that are only ever read at their read only global, instead of copying them
+     */
+    void constArrLits() {
+        // The outermost literals come last, once they are replaced the rows that were copied into them are unused
+        for(auto lit = const_arr_lits.rbegin(); lit != const_arr_lits.rend(); lit++) {
+            if(arrLitWritten(lit->data, lit->init)) {
+                continue;
+            }
+
+            for(auto *inst : lit->init) {
+                inst->eraseFromParent();
+            }
+
+            auto *buffer = llvm::cast<llvm::Instruction>(lit->data->getOperand(0));
+            std::vector<llvm::WeakTrackingVH> users;
+            for(auto *user : lit->data->users()) {
+                users.push_back(user);
+            }
+
+            lit->data->replaceAllUsesWith(lit->global_data);
+            lit->data->eraseFromParent();
+
+            // The casts and geps that filled the copy are left unused
+            for(auto &user : users) {
+                if(user) {
+                    llvm::RecursivelyDeleteTriviallyDeadInstructions(user);
+                }
+            }
+
+            if(buffer->use_empty()) {
+                arr_lit_mallocs.erase(std::remove_if(arr_lit_mallocs.begin(), arr_lit_mallocs.end(), [&](const std::pair<llvm::CallInst *, uint64_t> &m) { return m.first == buffer; }), arr_lit_mallocs.end());
+                buffer->eraseFromParent();
+            }
+        }
+
+        const_arr_lits.clear();
+    }
+
+    /**
+     * @brief Moves the buffers of array literals that never leave their function into its stack frame. It runs once every
+     * function has been generated, so it can see what the functions an array is passed to do with it.
+     * When one of these arrays grows, the realloc is given null instead so it mallocs, and the stack buffer is copied over
+     */
+    void stackAllocArrLits() {
+        const uint64_t max_stack_bytes = 4096;
+        auto &DL = TheModule->getDataLayout();
+
+        for(auto &lit : arr_lit_mallocs) {
+            auto *buffer = lit.first;
+            uint64_t count = lit.second;
+
+            auto *cast = buffer->hasOneUse() ? llvm::dyn_cast<llvm::BitCastInst>(*buffer->user_begin()) : nullptr;
+            if(!cast) {
+                continue;
+            }
+
+            auto *elem_type = cast->getType()->getPointerElementType();
+            auto *size = buffer->getArgOperand(0);
+            if(count * DL.getTypeAllocSize(elem_type) > max_stack_bytes) {
+                continue;
+            }
+
+            std::vector<llvm::CallInst *> reallocs, calls;
+            if(arrBufferEscapes(buffer, reallocs, calls)) {
+                continue;
+            }
+
+            // A tail call may reuse the frame the buffer is in
+            for(auto *call : calls) {
+                call->setTailCallKind(llvm::CallInst::TCK_None);
+            }
+
+            auto *TheFunction = buffer->getFunction();
+            llvm::IRBuilder<> TmpB(&TheFunction->getEntryBlock(), TheFunction->getEntryBlock().begin());
+            auto *stack_buf = TmpB.CreateAlloca(llvm::ArrayType::get(elem_type, count), 0, "arrbuf");
+            stack_buf->setAlignment(std::max(llvm::Align(8), TheModule->getDataLayout().getABITypeAlign(elem_type)));
+            auto *stack_ptr = TmpB.CreateBitCast(stack_buf, buffer->getType());
+
+            for(auto *grow : reallocs) {
+                llvm::IRBuilder<> B(grow);
+                auto *old_data = grow->getArgOperand(0);
+                auto *on_stack = B.CreateICmpEQ(old_data, stack_ptr);
+                grow->setArgOperand(0, B.CreateSelect(on_stack, llvm::ConstantPointerNull::get(Builder.getInt8PtrTy()), old_data));
+
+                B.SetInsertPoint(grow->getNextNode());
+                B.CreateMemCpy(grow, llvm::MaybeAlign(8), old_data, llvm::MaybeAlign(8), B.CreateSelect(on_stack, size, B.getInt64(0)));
+            }
+
+            buffer->replaceAllUsesWith(stack_ptr);
+            buffer->eraseFromParent();
+        }
+
+        arr_lit_mallocs.clear();
+    }
+
+    /**
+     * @brief Checks if an array keeps the fields of its objects in columns
+     * 
+     * @param arr_type 
+     * @return true 
+     * @return false 
+     */
+    bool isSoaArr(llvm::Type *arr_type) {
+        return isArrType(arr_type) && soa_types.count(arr_type->getStructElementType(0)->getPointerElementType());
+    }
+
+    /**
+     * @brief Gets the amount of bytes one object takes up across all of the columns
+     * 
+     * @param soa_ty 
+     * @return llvm::Constant* 
+     */
+    llvm::Constant *soaRowSize(llvm::StructType *soa_ty) {
+        llvm::Constant *size = llvm::ConstantInt::get(llvm::Type::getInt64Ty(TheContext), 0);
+        for(auto *field : soa_ty->elements()) {
+            size = llvm::ConstantExpr::getAdd(size, llvm::ConstantExpr::getSizeOf(field));
+        }
+
+        return size;
+    }
+
+    /**
+     * @brief Gets a pointer to the start of a column. The columns follow each other in the buffer, in the order of the fields,
+     * which is sorted by alignment so every column starts aligned
+     * 
+     * @param data the buffer of the array
+     * @param len the length of the array
+     * @param field 
+     * @return llvm::Value* 
+     */
+    llvm::Value *soaColumn(llvm::Value *data, llvm::Value *len, int field) {
+        auto soa_ty = llvm::cast<llvm::StructType>(data->getType()->getPointerElementType());
+
+        llvm::Constant *offset = llvm::ConstantInt::get(llvm::Type::getInt64Ty(TheContext), 0);
+        for(int i = 0; i < field; i++) {
+            offset = llvm::ConstantExpr::getAdd(offset, llvm::ConstantExpr::getSizeOf(soa_ty->getElementType(i)));
+        }
+
+        auto column = Builder.CreateInBoundsGEP(Builder.CreateBitCast(data, Builder.getInt8PtrTy()), Builder.CreateMul(len, offset));
+        return Builder.CreateBitCast(column, llvm::PointerType::getUnqual(soa_ty->getElementType(field)), "column");
+    }
+
+    /**
+     * @brief Copies an object out of the columns of an array
+     * 
+     * @param arr_val the {T*, i64} of the array
+     * @param index 
+     * @param dest a pointer to the object that gets the fields
+     * @param geps gets the pointers to the fields of dest that were stored to
+     */
+    void soaGather(llvm::Value *arr_val, llvm::Value *index, llvm::Value *dest, std::set<llvm::Value *> *geps = nullptr) {
+        auto data = Builder.CreateExtractValue(arr_val, 0);
+        auto len = Builder.CreateExtractValue(arr_val, 1);
+
+        for(int i = 0; i < llvm::cast<llvm::StructType>(data->getType()->getPointerElementType())->getNumElements(); i++) {
+            auto field = Builder.CreateGEP(dest, getGEPIndex(i));
+            Builder.CreateStore(Builder.CreateLoad(Builder.CreateInBoundsGEP(soaColumn(data, len, i), index)), field);
+
+            if(geps) {
+                geps->insert(field);
+            }
+        }
+    }
+
+    /**
+     * @brief Copies the given fields of an object into the columns of an array
+     * 
+     * @param arr_val the {T*, i64} of the array
+     * @param index 
+     * @param src a pointer to the object
+     * @param fields the fields to copy, or all of them if empty
+     */
+    void soaScatter(llvm::Value *arr_val, llvm::Value *index, llvm::Value *src, std::set<int> fields = {}) {
+        auto data = Builder.CreateExtractValue(arr_val, 0);
+        auto len = Builder.CreateExtractValue(arr_val, 1);
+
+        for(int i = 0; i < llvm::cast<llvm::StructType>(data->getType()->getPointerElementType())->getNumElements(); i++) {
+            if(fields.empty() || fields.count(i)) {
+                Builder.CreateStore(Builder.CreateLoad(Builder.CreateGEP(src, getGEPIndex(i))), Builder.CreateInBoundsGEP(soaColumn(data, len, i), index));
+            }
+        }
+    }
+
+    /**
+     * @brief Converts an array of objects into the column layout when it is stored in a struct of arrays array
+     * 
+     * @param arr_val the {T*, i64} of the array
+     * @param type the type of the array it will be stored in
+     * @return llvm::Value* 
+     */
+    llvm::Value *toArrLayout(llvm::Value *arr_val, llvm::Type *type) {
+        if(arr_val->getType() == type || !isSoaArr(type) || !isArrType(arr_val->getType())) {
+            return arr_val;
+        }
+
+        auto *TheFunction = Builder.GetInsertBlock()->getParent();
+        auto soa_ptr_ty = llvm::cast<llvm::StructType>(type)->getElementType(0);
+        auto soa_ty = llvm::cast<llvm::StructType>(soa_ptr_ty->getPointerElementType());
+
+        auto data = Builder.CreateExtractValue(arr_val, 0);
+        auto len = Builder.CreateExtractValue(arr_val, 1);
+        auto new_data = Builder.CreateBitCast(mallocArrData(Builder.getInt8Ty(), Builder.CreateMul(len, soaRowSize(soa_ty))), soa_ptr_ty);
+
+        llvm::Value *soa_val = llvm::UndefValue::get(type);
+        soa_val = Builder.CreateInsertValue(soa_val, new_data, 0);
+        soa_val = Builder.CreateInsertValue(soa_val, len, 1);
+
+        auto *PreheaderBB = Builder.GetInsertBlock();
+        auto *CopyBB      = llvm::BasicBlock::Create(TheContext, "soacopy", TheFunction);
+        auto *AfterBB     = llvm::BasicBlock::Create(TheContext, "aftersoacopy", TheFunction);
+        Builder.CreateCondBr(Builder.CreateICmpNE(len, getArrElementIndex(0)), CopyBB, AfterBB);
+
+        Builder.SetInsertPoint(CopyBB);
+        auto *index = Builder.CreatePHI(Builder.getInt64Ty(), 2, "i");
+        index->addIncoming(getArrElementIndex(0), PreheaderBB);
+
+        soaScatter(soa_val, index, Builder.CreateInBoundsGEP(data, index));
+
+        auto next = Builder.CreateAdd(index, getArrElementIndex(1));
+        index->addIncoming(next, Builder.GetInsertBlock());
+        Builder.CreateCondBr(Builder.CreateICmpNE(next, len), CopyBB, AfterBB);
+
+        Builder.SetInsertPoint(AfterBB);
+        return soa_val;
+    }
+
+    /**
+     * @brief Grows the buffer of an array to hold new_len elements, the new elements are zeroed
+     * 
+     * @param arr a pointer to the {T*, i64} of the array
+     * @param new_len 
+     */
+    void growArr(llvm::Value *arr, llvm::Value *new_len) {
+        llvm::Value *arr_val = Builder.CreateLoad(arr);
+        auto data = Builder.CreateExtractValue(arr_val, 0);
+        auto len = Builder.CreateExtractValue(arr_val, 1);
+
+        // Every column moves when the length changes, so they are copied into a new buffer
+        if(isSoaArr(arr_val->getType())) {
+            auto soa_ty = llvm::cast<llvm::StructType>(data->getType()->getPointerElementType());
+            auto size = Builder.CreateMul(new_len, soaRowSize(soa_ty));
+            auto new_data = Builder.CreateBitCast(mallocArrData(Builder.getInt8Ty(), size), data->getType());
+            Builder.CreateMemSet(new_data, Builder.getInt8(0), size, llvm::MaybeAlign(8));
+
+            for(int i = 0; i < soa_ty->getNumElements(); i++) {
+                auto field_size = llvm::ConstantExpr::getSizeOf(soa_ty->getElementType(i));
+                Builder.CreateMemCpy(soaColumn(new_data, new_len, i), llvm::MaybeAlign(1), soaColumn(data, len, i), llvm::MaybeAlign(1), Builder.CreateMul(len, field_size));
+            }
+
+            llvm::CallInst::CreateFree(Builder.CreateBitCast(data, Builder.getInt8PtrTy()), Builder.GetInsertBlock());
+
+            arr_val = Builder.CreateInsertValue(arr_val, new_data, 0);
+            arr_val = Builder.CreateInsertValue(arr_val, new_len, 1);
+            Builder.CreateStore(arr_val, arr);
+            return;
+        }
+        auto elem_type = data->getType()->getPointerElementType();
+        auto elem_size = llvm::ConstantExpr::getSizeOf(elem_type);
+
+        auto raw = Builder.CreateCall(TheModule->getFunction("realloc"), {Builder.CreateBitCast(data, Builder.getInt8PtrTy()), Builder.CreateMul(new_len, elem_size)});
+        auto new_data = Builder.CreateBitCast(raw, data->getType());
+
+        Builder.CreateMemSet(Builder.CreateGEP(new_data, len), Builder.getInt8(0), Builder.CreateMul(Builder.CreateSub(new_len, len), elem_size), llvm::MaybeAlign(8));
+
+        arr_val = Builder.CreateInsertValue(arr_val, new_data, 0);
+        arr_val = Builder.CreateInsertValue(arr_val, new_len, 1);
+        Builder.CreateStore(arr_val, arr);
+    }
+
+    /**
+     * @brief Gets a pointer to an element of an array
+     * 
+     * @param arr a pointer to the {T*, i64} of the array
+     * @param index 
+     * @return llvm::Value* 
+     */
+    llvm::Value *getElementAtIndex(llvm::Value *arr, int index) {
+        auto arr_val = Builder.CreateLoad(arr);
+
+        // Objects in columns are copied out into a temporary
+        if(isSoaArr(arr_val->getType())) {
+            auto *TheFunction = Builder.GetInsertBlock()->getParent();
+            auto obj_type = allocatedObjects[soa_types[arr_val->getType()->getStructElementType(0)->getPointerElementType()]].struct_ty;
+
+            llvm::IRBuilder<> TmpB(&TheFunction->getEntryBlock(), TheFunction->getEntryBlock().begin());
+            auto temp = TmpB.CreateAlloca(obj_type, 0, "soaelem");
+            soaGather(arr_val, getArrElementIndex(index), temp);
+
+            return temp;
+        }
+
+        auto data = Builder.CreateExtractValue(arr_val, 0);
+        return Builder.CreateGEP(data, getArrElementIndex(index));
+    }
+
+    /**
+     * @brief Stores a value in an array, the array is grown first if the index is past its end
+     * 
+     * @param arr a pointer to the {T*, i64} of the array
+     * @param index 
+     * @param set 
+     */
+    void setElementAtIndex(llvm::Value *arr, int index, llvm::Value *set) {
+        auto len = Builder.CreateExtractValue(Builder.CreateLoad(arr), 1);
+
+        auto *TheFunction = Builder.GetInsertBlock()->getParent();
+        auto *GrowBB = llvm::BasicBlock::Create(TheContext, "arrgrow", TheFunction);
+        auto *SetBB  = llvm::BasicBlock::Create(TheContext, "arrset", TheFunction);
+
+        Builder.CreateCondBr(Builder.CreateICmpUGE(getArrElementIndex(index), len), GrowBB, SetBB);
+
+        Builder.SetInsertPoint(GrowBB);
+        growArr(arr, getArrElementIndex(index + 1));
+        Builder.CreateBr(SetBB);
+
+        Builder.SetInsertPoint(SetBB);
+
+        auto arr_val = Builder.CreateLoad(arr);
+        if(isSoaArr(arr_val->getType())) {
+            auto *TheFunction = Builder.GetInsertBlock()->getParent();
+            llvm::IRBuilder<> TmpB(&TheFunction->getEntryBlock(), TheFunction->getEntryBlock().begin());
+            auto set_val = loadIfAggregatePtr(set);
+            auto temp = TmpB.CreateAlloca(set_val->getType(), 0, "soaelem");
+
+            Builder.CreateStore(set_val, temp);
+            soaScatter(arr_val, getArrElementIndex(index), temp);
+            return;
+        }
+
+        Builder.CreateStore(loadIfAggregatePtr(set), getElementAtIndex(arr, index));
+    }
+
+    /**
+     * @brief Gets the cold block of an object, allocating it zeroed the first time it is used
+     * 
+     * @param obj a pointer to the object
+     * @param obj_type 
+     * @return llvm::Value* 
+     */
+    llvm::Value *getColdBlock(llvm::Value *obj, class_type &obj_type) {
+        auto *TheFunction = Builder.GetInsertBlock()->getParent();
+        auto slot = Builder.CreateGEP(obj, getGEPIndex(obj_type.cold_index));
+        auto cold = Builder.CreateLoad(slot);
+
+        auto *EntryBB = Builder.GetInsertBlock();
+        auto *AllocBB = llvm::BasicBlock::Create(TheContext, "coldalloc", TheFunction);
+        auto *ReadyBB = llvm::BasicBlock::Create(TheContext, "coldready", TheFunction);
+        Builder.CreateCondBr(Builder.CreateIsNull(cold), AllocBB, ReadyBB);
+
+        Builder.SetInsertPoint(AllocBB);
+        auto block = mallocArrData(obj_type.cold_ty, getArrElementIndex(1));
+        Builder.CreateMemSet(block, Builder.getInt8(0), llvm::ConstantExpr::getSizeOf(obj_type.cold_ty), llvm::MaybeAlign(8));
+        Builder.CreateStore(block, slot);
+        Builder.CreateBr(ReadyBB);
+
+        Builder.SetInsertPoint(ReadyBB);
+        auto phi = Builder.CreatePHI(cold->getType(), 2, "cold");
+        phi->addIncoming(cold, EntryBB);
+        phi->addIncoming(block, AllocBB);
+
+        return phi;
+    }
+
+    /**
+     * @brief Gets a pointer to a field of an object, following the pointer to the cold block for @cold fields
+     * 
+     * @param obj a pointer to the object
+     * @param type_name 
+     * @param field 
+     * @return llvm::Value* 
+     */
+    llvm::Value *getFieldPtr(llvm::Value *obj, std::string type_name, std::string field) {
+        auto &obj_type = allocatedObjects[type_name];
+
+        if(obj_type.cold_name_map.count(field)) {
+            return Builder.CreateGEP(getColdBlock(obj, obj_type), getGEPIndex(obj_type.cold_name_map[field]));
+        }
+
+        return Builder.CreateGEP(obj, getGEPIndex(obj_type.type_name_map[field]));
+    }
+
+    /**
+     * @brief Checks if copying an object needs to copy a cold block, including the cold blocks of objects inside of it
+     * 
+     * @param t 
+     * @return true 
+     * @return false 
+     */
+    bool hasColdBlock(llvm::Type *t) {
+        auto struct_type = llvm::dyn_cast<llvm::StructType>(t);
+        if(!struct_type || struct_type->isLiteral()) {
+            return false;
+        }
+
+        for(auto &obj : allocatedObjects) {
+            if(obj.second.struct_ty == t && obj.second.cold_ty) {
+                return true;
+            }
+        }
+
+        for(auto *elem : struct_type->elements()) {
+            if(hasColdBlock(elem)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Gives a copied object its own cold blocks, so changing a cold field of the copy doesn't change the original
+     * 
+     * @param val the loaded object
+     * @return llvm::Value* 
+     */
+    llvm::Value *copyColdBlocks(llvm::Value *val) {
+        if(!hasColdBlock(val->getType())) {
+            return val;
+        }
+
+        auto struct_type = llvm::cast<llvm::StructType>(val->getType());
+        for(unsigned i = 0; i < struct_type->getNumElements(); i++) {
+            if(hasColdBlock(struct_type->getElementType(i))) {
+                val = Builder.CreateInsertValue(val, copyColdBlocks(Builder.CreateExtractValue(val, i)), i);
+            }
+        }
+
+        auto &obj_type = allocatedObjects[getTypeName(struct_type)];
+        if(!obj_type.cold_ty) {
+            return val;
+        }
+
+        auto *TheFunction = Builder.GetInsertBlock()->getParent();
+        auto cold = Builder.CreateExtractValue(val, obj_type.cold_index);
+
+        auto *EntryBB  = Builder.GetInsertBlock();
+        auto *CopyBB   = llvm::BasicBlock::Create(TheContext, "coldcopy", TheFunction);
+        auto *CopiedBB = llvm::BasicBlock::Create(TheContext, "coldcopied", TheFunction);
+        Builder.CreateCondBr(Builder.CreateIsNull(cold), CopiedBB, CopyBB);
+
+        Builder.SetInsertPoint(CopyBB);
+        auto block = mallocArrData(obj_type.cold_ty, getArrElementIndex(1));
+        Builder.CreateMemCpy(block, llvm::MaybeAlign(8), cold, llvm::MaybeAlign(8), llvm::ConstantExpr::getSizeOf(obj_type.cold_ty));
+        Builder.CreateBr(CopiedBB);
+
+        Builder.SetInsertPoint(CopiedBB);
+        auto phi = Builder.CreatePHI(cold->getType(), 2, "cold");
+        phi->addIncoming(cold, EntryBB);
+        phi->addIncoming(block, CopyBB);
+
+        return Builder.CreateInsertValue(val, phi, obj_type.cold_index);
+    }
+
+    /**
+     * @brief Prints the size, alignment and padding of every object, for --layout-report
+     * 
+     */
+    void printLayoutReport() {
+        auto &DL = TheModule->getDataLayout();
+
+        auto printStruct = [&](std::string name, llvm::StructType *st, std::map<std::string, int> names, int cold_index) {
+            auto *layout = DL.getStructLayout(st);
+            uint64_t used = 0;
+
+            std::vector<std::string> field_names(st->getNumElements());
+            for(auto &n : names) {
+                field_names[n.second] = n.first;
+            }
+            if(cold_index >= 0) {
+                field_names[cold_index] = "(cold block)";
+            }
+
+            for(unsigned i = 0; i < st->getNumElements(); i++) {
+                used += DL.getTypeAllocSize(st->getElementType(i));
+            }
+
+            std::cout << name << ": size " << layout->getSizeInBytes() << ", align " << layout->getAlignment().value() << ", padding " << layout->getSizeInBytes() - used << std::endl;
+            for(unsigned i = 0; i < st->getNumElements(); i++) {
+                std::cout << "    " << field_names[i] << ": offset " << layout->getElementOffset(i) << ", size " << DL.getTypeAllocSize(st->getElementType(i)) << std::endl;
+            }
+        };
+
+        for(auto &name : object_order) {
+            auto &obj = allocatedObjects[name];
+            printStruct(name, llvm::cast<llvm::StructType>(obj.struct_ty), obj.type_name_map, obj.cold_index);
+
+            if(obj.cold_ty) {
+                printStruct(name + ".cold", obj.cold_ty, obj.cold_name_map, -1);
+            }
+        }
+    }
+
+    llvm::Value *ObjectAccAST::irgen() {
+        if(!lhs_buf && !prev_llvm_value && !prev_exp_ast && !rhs_buf) {
+            lhs_buf = LHS.get();
+            rhs_buf = RHS.get();
+            auto rb_buf = rhs_buf;
+            auto lb_buf = lhs_buf;
+
+            if(!strcmp(lhs_buf->getType(), "id")) {
+                auto lhs_to_id = dynamic_cast<IdHolder*>(lhs_buf);
+                prev_llvm_value = NamedValues[lhs_to_id->getId()].val;
+            } else if(!strcmp(lhs_buf->getType(), "call")) {
+                prev_llvm_value = lhs_buf->irgen();
+            } else if(!strcmp(lhs_buf->getType(), "array_acc")) {
+                prev_llvm_value = lhs_buf->irgen();
+                elem_acc_buf = dynamic_cast<ArrayAccAST*>(lhs_buf);
+                elem_buf = prev_llvm_value;
+            }
+
+            if(!prev_llvm_value) {
+                resetObjRecVars();
+                return nullptr;
+            }
+
+            lhs_buf = lb_buf;
+            rhs_buf = rb_buf;
+            
+            prev_exp_ast = lhs_buf;
+            lhs_buf = rhs_buf;
+
+            return this->irgen();
+        } else if(!strcmp(lhs_buf->getType(), "id")) {
+            // Convert the current lhs (rhs) to and IdHolder ast
+            auto lhs_to_id = dynamic_cast<IdHolder*>(lhs_buf);
+
+            // Find out the typename of the previous object to get its type name map
+            std::string prev_type_name = getTypeName(prev_llvm_value->getType());
+            
+            if(prev_type_name.empty()) {
+                return nullptr;
+            }
+
+            // Create a GEP to get the value out of the previous object
+            auto return_gep = getFieldPtr(prev_llvm_value, prev_type_name, lhs_to_id->getId());
+            is_unsigned = allocatedObjects[prev_type_name].field_types[lhs_to_id->getId()] == "u8";
+
+            resetObjRecVars();
+
+            // A fixed size array field is handed out as a pointer to it, like an array variable
+            if(return_gep->getType()->getPointerElementType()->isArrayTy()) {
+                return return_gep;
+            }
 
-            resetObjRecVars();
             // Reset the object vars for the next object access
             return Builder.CreateLoad(return_gep);
         // 
@@ -700,456 +2375,3044 @@ namespace ASTS {
             auto prev_lhs_to_id = dynamic_cast<IdHolder*>(prev_exp_ast);
             auto lhs_to_var = dynamic_cast<VariableExpAST*>(lhs_buf);
 
-            std::string prev_type_name = getTypeName(prev_llvm_value->getType());  
-            int acc_num = allocatedObjects[prev_type_name].type_name_map[lhs_to_var->getName()];
+            std::string prev_type_name = getTypeName(prev_llvm_value->getType());  
+            auto return_gep = getFieldPtr(prev_llvm_value, prev_type_name, lhs_to_var->getName());
+            auto elem_acc = elem_acc_buf;
+            auto elem = elem_buf;
+            
+            resetObjRecVars();
+
+            // A fixed size array field is filled in place
+            if(return_gep->getType()->getPointerElementType()->isArrayTy()) {
+                initFixedArr(return_gep, lhs_to_var->getVAST(), lhs_to_var->getName());
+
+                if(elem_acc) {
+                    elem_acc->writeBack(elem);
+                }
+
+                return nullptr;
+            }
+
+            auto var_val = lhs_to_var->getVAST()->irgen();
+            if(!var_val) {
+                return nullptr;
+            }
+            var_val = castValue(loadIfAggregatePtr(var_val), return_gep->getType()->getPointerElementType());
+
+            // Compound assignments (ex: a.x += 1) apply their operator to the current value of the field
+            std::string op = lhs_to_var->getVarType();
+            if(op.size() == 2 && op.back() == '=') {
+                auto cur_val = Builder.CreateLoad(return_gep);
+
+                if(isNumType(cur_val->getType()) && var_val->getType() == cur_val->getType()) {
+                    var_val = numArith(op.substr(0, 1), cur_val, var_val, allocatedObjects[prev_type_name].field_types[lhs_to_var->getName()] == "u8");
+                } else if(op == "+=" && cur_val->getType() == Builder.getInt8PtrTy() && var_val->getType() == Builder.getInt8PtrTy()) {
+                    var_val = Builder.CreateCall(TheModule->getFunction("addstr"), {cur_val, var_val}, "calltmp");
+                } else {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m invalid operands to " + op + " on field " + lhs_to_var->getName());
+                    return nullptr;
+                }
+            }
+
+            Builder.CreateStore(var_val, return_gep);
+
+            if(elem_acc) {
+                elem_acc->writeBack(elem);
+            }
+
+            return nullptr;
+        } else if(!strcmp(lhs_buf->getType(), "object_acc")) {
+            auto prev_lhs_to_id = dynamic_cast<IdHolder*>(prev_exp_ast);
+            auto lhs_to_objacc = dynamic_cast<ObjectAccAST*>(lhs_buf);
+
+            prev_exp_ast = lhs_buf;
+            lhs_buf = lhs_to_objacc->GetLHS();
+
+            if(!strcmp(lhs_buf->getType(), "id")) {
+                auto lhs_lhs_to_id = dynamic_cast<IdHolder*>(lhs_to_objacc->GetLHS());
+
+                std::string prev_type_name = getTypeName(prev_llvm_value->getType());            
+                auto return_gep = getFieldPtr(prev_llvm_value, prev_type_name, lhs_lhs_to_id->getId());
+
+                prev_llvm_value = return_gep;
+            } else if(!strcmp(lhs_buf->getType(), "call")) {
+                auto lhs_to_call = dynamic_cast<CallExpAST*>(lhs_to_objacc->GetLHS());
+                lhs_to_call->argsv_extra.push_back(prev_llvm_value);
+                lhs_to_call->setCallee(getTypeName(prev_llvm_value->getType()) + "." + lhs_to_call->getCallee());
+                
+                prev_llvm_value = lhs_to_call->irgen();
+            }
+            
+            
+            lhs_buf = lhs_to_objacc->GetRHS();
+            prev_exp_ast    = lhs_to_objacc->GetLHS();
+            
+            return this->irgen();
+        } else if(!strcmp(lhs_buf->getType(), "call")) {
+            auto lhs_to_call = dynamic_cast<CallExpAST*>(lhs_buf);
+
+            lhs_to_call->argsv_extra.push_back(prev_llvm_value);
+            lhs_to_call->setCallee(getTypeName(prev_llvm_value->getType()) + "." + lhs_to_call->getCallee());
+            auto elem_acc = elem_acc_buf;
+            auto elem = elem_buf;
+            resetObjRecVars();
+
+            auto call = lhs_to_call->irgen();
+
+            // A method can change the object it was called on
+            if(elem_acc) {
+                elem_acc->writeBack(elem);
+            }
+            return call;
+        } else {
+            return nullptr;
+        }
+    }
+
+    /**
+     * @brief Fields are laid out by alignment so there is as little padding as possible, and fields with the same alignment
+     * are ordered by how often the program accesses them. @cold fields are moved to a block that is only allocated when used
+     * 
+     * @return llvm::Value* 
+     */
+    llvm::Value *ObjExpAST::irgen() {
+        struct field_layout {
+            std::string name;
+            llvm::Type *type;
+            int uses;
+        };
+
+        auto &DL = TheModule->getDataLayout();
+        std::vector<field_layout> hot, cold;
+
+        for(auto type : object_attributes) {
+            llvm::Type *field_type;
+            if(type.second.first == 0) {
+                field_type = getNumType(type.second.second);
+            } else if(type.second.first == 1) {
+                field_type = llvm::Type::getInt8PtrTy(TheContext);
+            } else if(type.second.first == bool_ty) {
+                field_type = llvm::Type::getInt1Ty(TheContext);
+            } else if(type.second.first == array_ty) {
+                field_type = getFixedArrType(type.second.second);
+            } else {
+                field_type = allocatedObjects[type.second.second].struct_ty;
+            }
+
+            (cold_fields.count(type.first) ? cold : hot).push_back({type.first, field_type, field_uses[type.first]});
+        }
+
+        llvm::StructType *coldStruct = nullptr;
+        if(!cold.empty()) {
+            coldStruct = llvm::StructType::create(TheContext, object_name + ".cold");
+            hot.push_back({"", llvm::PointerType::getUnqual(coldStruct), 0});
+        }
+
+        auto by_layout = [&](const field_layout &a, const field_layout &b) {
+            if(DL.getABITypeAlign(a.type) != DL.getABITypeAlign(b.type)) {
+                return DL.getABITypeAlign(a.type) > DL.getABITypeAlign(b.type);
+            }
+            return a.uses > b.uses;
+        };
+        std::stable_sort(hot.begin(), hot.end(), by_layout);
+        std::stable_sort(cold.begin(), cold.end(), by_layout);
+
+        std::vector<llvm::Type*> types;
+        std::map<std::string, int> tname_map;
+        int cold_index = -1;
+        for(int i = 0; i < hot.size(); i++) {
+            if(hot[i].name.empty()) {
+                cold_index = i;
+            } else {
+                tname_map[hot[i].name] = i;
+            }
+            types.push_back(hot[i].type);
+        }
+
+        std::vector<llvm::Type*> cold_types;
+        std::map<std::string, int> cold_map;
+        for(int i = 0; i < cold.size(); i++) {
+            cold_map[cold[i].name] = i;
+            cold_types.push_back(cold[i].type);
+        }
+
+        if(coldStruct) {
+            coldStruct->setBody(cold_types);
+        }
+        
+        auto newStruct = llvm::StructType::create(TheContext, object_name);
+        newStruct->setBody(types);
+
+        allocatedObjects[object_name] = {newStruct, llvm::PointerType::getUnqual(newStruct), tname_map, cold_map, coldStruct, cold_index};
+        for(auto &type : object_attributes) {
+            allocatedObjects[object_name].field_types[type.first] = type.second.second;
+        }
+        object_order.push_back(object_name);
+
+        // Arrays of Type.soa keep every field in its own column. The struct only marks the array, it is never stored
+        auto soaStruct = llvm::StructType::create(TheContext, types, object_name + ".soa");
+        soa_types[soaStruct] = object_name;
+        allocatedObjects[object_name + ".soa"] = {soaStruct, llvm::PointerType::getUnqual(soaStruct), {}};
+
+        for(auto &attr : attributes) {
+            if(attr.name == "soa") {
+                allocatedObjects[object_name].soa_ty = soaStruct;
+            }
+        }
+        
+        for(auto &func : functions) {
+            func->getProto()->appendArg({"this", {2, object_name}});
+            func->irgen();
+        }
+
+        return nullptr;
+    }
+    
+    /**
+     * @brief Checks if a value can point into the stack frame of the function it's in. Slices carry their pointer inside
+     * a {T*, i64}, so the values they're built from and the values stored into a slice variable are followed too
+     * 
+     * @param val 
+     * @param seen the values already followed
+     * @return true 
+     * @return false 
+     */
+    bool pointsIntoFrame(llvm::Value *val, std::set<llvm::Value *> &seen) {
+        if(!seen.insert(val).second) {
+            return false;
+        }
+
+        if(llvm::isa<llvm::GetElementPtrInst>(val) || llvm::isa<llvm::CastInst>(val)) {
+            return pointsIntoFrame(llvm::cast<llvm::Instruction>(val)->getOperand(0), seen);
+        } else if(auto insert = llvm::dyn_cast<llvm::InsertValueInst>(val)) {
+            return pointsIntoFrame(insert->getAggregateOperand(), seen) || pointsIntoFrame(insert->getInsertedValueOperand(), seen);
+        } else if(auto extract = llvm::dyn_cast<llvm::ExtractValueInst>(val)) {
+            return pointsIntoFrame(extract->getAggregateOperand(), seen);
+        }
+
+        // A slice loaded from a variable holds whatever was stored into the variable
+        if(auto load = llvm::dyn_cast<llvm::LoadInst>(val)) {
+            auto base = load->getPointerOperand()->stripPointerCasts();
+            if(!load->getType()->isAggregateType() || !llvm::isa<llvm::AllocaInst>(base)) {
+                return false;
+            }
+
+            std::vector<llvm::Value *> addrs = {base};
+            while(!addrs.empty()) {
+                auto addr = addrs.back();
+                addrs.pop_back();
+
+                for(auto user : addr->users()) {
+                    if(auto store = llvm::dyn_cast<llvm::StoreInst>(user)) {
+                        if(store->getValueOperand() == addr || pointsIntoFrame(store->getValueOperand(), seen)) {
+                            return true;
+                        }
+                    } else if(llvm::isa<llvm::GetElementPtrInst>(user) || llvm::isa<llvm::CastInst>(user)) {
+                        addrs.push_back(user);
+                    } else if(!llvm::isa<llvm::LoadInst>(user)) {
+                        // Anything else could write to the variable
+                        return true;
+                    }
+                }
+            }
+
+            return false;
+        }
+
+        // A phi or select points into the frame if any of the values it picks from does
+        if(auto phi = llvm::dyn_cast<llvm::PHINode>(val)) {
+            for(auto &incoming : phi->incoming_values()) {
+                if(pointsIntoFrame(incoming.get(), seen)) {
+                    return true;
+                }
+            }
+            return false;
+        } else if(auto select = llvm::dyn_cast<llvm::SelectInst>(val)) {
+            return pointsIntoFrame(select->getTrueValue(), seen) || pointsIntoFrame(select->getFalseValue(), seen);
+        }
+
+        return llvm::isa<llvm::AllocaInst>(val);
+    }
+
+    /**
+     * @brief Checks that a call can be marked as a tail call, which means the callee never sees the stack frame of the caller
+     * 
+     * @param call 
+     * @return std::string why the call can't be a tail call, or an empty string if it can
+     */
+    std::string tailCallBlocker(llvm::CallInst *call) {
+        for(auto &arg : call->args()) {
+            std::set<llvm::Value *> seen;
+            if(pointsIntoFrame(arg.get(), seen)) {
+                return "an argument points into the stack frame of the caller";
+            }
+        }
+
+        return "";
+    }
+
+    llvm::Value *ReturnExpAST::irgen() {
+        auto *TheFunction = Builder.GetInsertBlock()->getParent();
+        auto ret_call = dynamic_cast<CallExpAST*>(Ret_value.get());
+
+        // A returned object can be written straight into the memory the caller gave us, which keeps the call in tail position
+        if(ret_call && TheFunction->hasStructRetAttr()) {
+            auto CalleeF = TheModule->getFunction(ret_call->getCallee());
+            if(CalleeF && CalleeF->hasStructRetAttr() && CalleeF->getParamStructRetType(0) == TheFunction->getParamStructRetType(0)) {
+                ret_call->sret_dest = TheFunction->getArg(0);
+            }
+        }
+
+        if(ret_call) {
+            ret_call->last_call = nullptr;
+        }
+
+        auto ret_val = Ret_value->irgen();
+
+        if(!ret_val) {
+            return nullptr;
+        }
+
+        llvm::CallInst *call = ret_call ? ret_call->last_call : nullptr;
+        bool direct = false;
+        llvm::Value *ret = nullptr;
+
+        // Objects are copied into the caller's memory
+        if(TheFunction->hasStructRetAttr()) {
+            direct = call && ret_val == TheFunction->getArg(0);
+            if(!direct) {
+                Builder.CreateStore(loadIfAggregatePtr(ret_val), TheFunction->getArg(0));
+            }
+        } else {
+            ret = castValue(ret_val, TheFunction->getReturnType());
+            direct = call && ret == call;
+
+            // The stack frame is gone once the function returns, so a pointer or slice into it can't be handed back
+            std::set<llvm::Value *> seen;
+            if((ret->getType()->isPointerTy() || isArrType(ret->getType())) && pointsIntoFrame(ret, seen)) {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m " + std::string(TheFunction->getName()) + " returns a slice of its own stack frame, which is gone once it returns");
+                return nullptr;
+            }
+        }
+
+        std::string blocker = call ? tailCallBlocker(call) : "the returned value is not a call";
+        if(blocker.empty() && !direct) {
+            blocker = "the result of the call is converted before it is returned";
+        } else if(blocker.empty() && call->getFunctionType() != TheFunction->getFunctionType()) {
+            blocker = "the function called doesn't take and return the same types as " + std::string(TheFunction->getName());
+        } else if(blocker.empty() && call->getCallingConv() != TheFunction->getCallingConv()) {
+            blocker = "the function called uses a different calling convention than " + std::string(TheFunction->getName());
+        }
+
+        if(must_tail && !blocker.empty()) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m @tailcall return in " + std::string(TheFunction->getName()) + " can't be a tail call: " + blocker);
+        }
+
+        // musttail needs the same prototype on both sides, a plain tail call only needs the stack frame to be unused
+        if(call && blocker.empty() && must_tail) {
+            call->setTailCallKind(llvm::CallInst::TCK_MustTail);
+        } else if(call && tailCallBlocker(call).empty()) {
+            call->setTailCallKind(llvm::CallInst::TCK_Tail);
+        }
+
+        if(TheFunction->hasStructRetAttr()) {
+            return Builder.CreateRetVoid();
+        }
+
+        return Builder.CreateRet(ret);
+    }
+
+    /**
+     * @brief Attaches loop hints to the branch back to the start of the loop as llvm.loop metadata.
+     * @independent puts every memory access of the loop into an access group, which tells llvm that iterations never depend on each other
+     * 
+     * @param latch the branch that jumps back to the header
+     * @param header the first block of the loop
+     * @param hints 
+     */
+    void addLoopHints(llvm::Instruction *latch, llvm::BasicBlock *header, std::vector<attribute> &hints) {
+        if(hints.empty()) {
+            return;
+        }
+
+        auto *TheFunction = header->getParent();
+        std::string fn_name = std::string(TheFunction->getName());
+
+        // The blocks of the loop are the ones that reach the latch without going through the header
+        std::set<llvm::BasicBlock *> loop_blocks = {header};
+        std::vector<llvm::BasicBlock *> worklist = {latch->getParent()};
+        while(!worklist.empty()) {
+            auto *BB = worklist.back();
+            worklist.pop_back();
+
+            if(loop_blocks.insert(BB).second) {
+                for(auto *pred : llvm::predecessors(BB)) {
+                    worklist.push_back(pred);
+                }
+            }
+        }
+
+        // A call that writes memory keeps the loop from being vectorized, llvm would drop the hint without saying why, so --loop-remarks says it
+        std::string blocker = "";
+        for(auto *BB : loop_blocks) {
+            for(auto &I : *BB) {
+                auto *call = llvm::dyn_cast<llvm::CallInst>(&I);
+                if(call && !call->onlyReadsMemory() && !llvm::isa<llvm::MemIntrinsic>(call)) {
+                    blocker = call->getCalledFunction() ? std::string(call->getCalledFunction()->getName()) : "a function pointer";
+                }
+            }
+        }
+
+        std::vector<llvm::Metadata *> ops = {nullptr};
+        auto hint = [&](std::string name, llvm::Constant *val) {
+            ops.push_back(llvm::MDNode::get(TheContext, {llvm::MDString::get(TheContext, name), llvm::ConstantAsMetadata::get(val)}));
+        };
+
+        for(auto &attr : hints) {
+            if(attr.name != "unroll" && !blocker.empty() && loop_remarks) {
+                std::cerr << ErrorHandler::cur_file_path + " \033[0;35mremark:\033[0;0m @" + attr.name + " on a loop in " + fn_name + " can't be honored: the loop calls " + blocker + ", which writes memory" << std::endl;
+            }
+
+            if(attr.name == "unroll") {
+                int count = std::stoi(attr.args[0]);
+                if(count == 1) {
+                    ops.push_back(llvm::MDNode::get(TheContext, {llvm::MDString::get(TheContext, "llvm.loop.unroll.disable")}));
+                } else {
+                    hint("llvm.loop.unroll.count", Builder.getInt32(count));
+                }
+            } else if(attr.name == "vectorize") {
+                int width = std::stoi(attr.args[0]);
+                hint("llvm.loop.vectorize.width", Builder.getInt32(width));
+                hint("llvm.loop.vectorize.enable", Builder.getInt1(width > 1));
+            } else if(attr.name == "interleave") {
+                hint("llvm.loop.interleave.count", Builder.getInt32(std::stoi(attr.args[0])));
+            } else if(attr.name == "independent") {
+                auto *group = llvm::MDNode::getDistinct(TheContext, {});
+                ops.push_back(llvm::MDNode::get(TheContext, {llvm::MDString::get(TheContext, "llvm.loop.parallel_accesses"), group}));
+
+                for(auto *BB : loop_blocks) {
+                    for(auto &I : *BB) {
+                        if(!I.mayReadOrWriteMemory()) {
+                            continue;
+                        }
+
+                        // An access in nested loops belongs to the group of every loop around it
+                        std::vector<llvm::Metadata *> groups = {group};
+                        if(auto *cur = I.getMetadata(llvm::LLVMContext::MD_access_group)) {
+                            if(cur->getNumOperands() == 0) {
+                                groups.push_back(cur);
+                            } else {
+                                groups.insert(groups.end(), cur->op_begin(), cur->op_end());
+                            }
+                        }
+
+                        I.setMetadata(llvm::LLVMContext::MD_access_group, groups.size() == 1 ? group : llvm::MDNode::get(TheContext, groups));
+                    }
+                }
+            }
+        }
+
+        // The first operand of a loop id points to itself
+        auto *loop_id = llvm::MDNode::getDistinct(TheContext, ops);
+        loop_id->replaceOperandWith(0, loop_id);
+        latch->setMetadata(llvm::LLVMContext::MD_loop, loop_id);
+    }
+
+    llvm::Value *LoopExpAST::irgen() {
+        if(Cur_BB) {
+            auto *TheFunction = Builder.GetInsertBlock()->getParent();
+            auto *PreheaderBB = Builder.GetInsertBlock();
+            auto *LoopBB      = llvm::BasicBlock::Create(TheContext, "loop", TheFunction);
+
+            Builder.CreateBr(LoopBB);
+            Builder.SetInsertPoint(LoopBB);
+
+            for(int i = 0; i < body.size(); i++) {
+                debugLoc(body.at(i).get());
+                body.at(i)->irgen();
+            }
+
+            auto *AfterBB = llvm::BasicBlock::Create(TheContext, "afterloop", TheFunction);
+
+            // A return already ended the block, so the loop never goes around
+            if(!Builder.GetInsertBlock()->getTerminator()) {
+                debugLoc(this);
+                auto EndCond = toCondition(condition->irgen());
+                addLoopHints(Builder.CreateCondBr(EndCond, LoopBB, AfterBB), LoopBB, hints);
+            }
+            Builder.SetInsertPoint(AfterBB);
+
+            for(int i = 0; i < cont.size(); i++) {
+               debugLoc(cont.at(i).get());
+               cont.at(i)->irgen();
+            }
+        } else {
+            global_expressions.push_back(this);
+        }
+
+        return nullptr;
+    }
+
+    /**
+     * @brief Checks if the body of a for loop could change the buffer or the length of the array it walks, by growing it or by
+     * storing another array in its place. Calls can only do that to arrays that aren't local variables
+     * 
+     * @param BodyBB the first block of the body
+     * @param CondBB the block the loop goes back to
+     * @param AfterBB 
+     * @param header a pointer to the {T*, i64} of the array
+     * @return true 
+     * @return false 
+     */
+    bool forBodyChangesArr(llvm::BasicBlock *BodyBB, llvm::BasicBlock *CondBB, llvm::BasicBlock *AfterBB, llvm::Value *header) {
+        std::set<llvm::BasicBlock *> visited = {CondBB, AfterBB};
+        std::vector<llvm::BasicBlock *> worklist = {BodyBB};
+        auto *arr_type = header->getType()->getPointerElementType();
+
+        while(!worklist.empty()) {
+            auto *BB = worklist.back();
+            worklist.pop_back();
+
+            if(!visited.insert(BB).second) {
+                continue;
+            }
+
+            for(auto &I : *BB) {
+                auto *store = llvm::dyn_cast<llvm::StoreInst>(&I);
+                auto *call = llvm::dyn_cast<llvm::CallInst>(&I);
+
+                if(store && store->getValueOperand()->getType() == arr_type) {
+                    return true;
+                } else if(call && !llvm::isa<llvm::AllocaInst>(header) && !call->onlyReadsMemory() && !llvm::isa<llvm::IntrinsicInst>(call)) {
+                    return true;
+                }
+            }
+
+            for(auto *succ : llvm::successors(BB)) {
+                worklist.push_back(succ);
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Points everything that uses a reload of the array walked by a for loop at the array loaded before the loop,
+     * when the body can't change it, so llvm sees a loop over one buffer
+     * 
+     * @param reloads the loads of the array in the loop
+     * @param coll the array loaded before the loop
+     */
+    void hoistArrReloads(std::vector<llvm::LoadInst *> &reloads, llvm::Value *coll) {
+        for(auto *reload : reloads) {
+            reload->replaceAllUsesWith(coll);
+            reload->eraseFromParent();
+        }
+    }
+
+    /**
+     * @brief Walks a pointer from the start to the end of a string or a fixed size array. Arrays are walked with an index, and
+     * the array is loaded again every time around, so a body that grows it or gives the variable another array doesn't leave
+     * the loop reading a freed buffer. The reloads are dropped again when the body can't change the array.
+     * Array elements are bound by reference, so assigning to the element name writes into the array and objects are never copied
+     * 
+     * @return llvm::Value* 
+     */
+    llvm::Value *ForExpAST::irgen() {
+        if(Cur_BB) {
+            auto *TheFunction = Builder.GetInsertBlock()->getParent();
+
+            auto coll = collection->irgen();
+            ASTS::resetObjRecVars();
+
+            if(!coll) {
+                return nullptr;
+            }
+
+            llvm::Value *begin = nullptr;
+            llvm::Value *end = nullptr;
+            llvm::Value *header = nullptr;
+            bool is_str = coll->getType() == llvm::Type::getInt8PtrTy(TheContext);
+
+            if(is_str) {
+                begin = coll;
+                end = Builder.CreateInBoundsGEP(begin, Builder.CreateCall(TheModule->getFunction("strlen"), {coll}, "forlen"), "forend");
+            } else if(coll->getType()->isPointerTy() && coll->getType()->getPointerElementType()->isArrayTy()) {
+                // A fixed size array is walked in place from its first element to one past its last
+                begin = Builder.CreateInBoundsGEP(coll, {Builder.getInt64(0), Builder.getInt64(0)}, "fordata");
+                end = Builder.CreateInBoundsGEP(coll, {Builder.getInt64(0), Builder.getInt64(coll->getType()->getPointerElementType()->getArrayNumElements())}, "forend");
+            } else {
+                // The array is walked through the variable or field that holds it, so changes made by the body are seen
+                if(coll->getType()->isPointerTy()) {
+                    header = coll;
+                }
+                coll = loadIfAggregatePtr(coll);
+
+                if(!isArrType(coll->getType())) {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m can only iterate over arrays and strings: for " + elem_name + " in ...");
+                    return nullptr;
+                }
+
+                if(isSoaArr(coll->getType())) {
+                    soaLoop(coll, header);
+                    return nullptr;
+                }
+            }
+
+            auto *PreheaderBB = Builder.GetInsertBlock();
+            auto *CondBB      = llvm::BasicBlock::Create(TheContext, "forcond", TheFunction);
+            auto *BodyBB      = llvm::BasicBlock::Create(TheContext, "forbody", TheFunction);
+            auto *AfterBB     = llvm::BasicBlock::Create(TheContext, "afterfor", TheFunction);
+
+            Builder.CreateBr(CondBB);
+            Builder.SetInsertPoint(CondBB);
+
+            llvm::PHINode *index = nullptr;
+            llvm::Value *Cur = nullptr;
+            std::vector<llvm::LoadInst *> reloads;
+            if(begin) {
+                auto *walk = Builder.CreatePHI(begin->getType(), 2, elem_name);
+                walk->addIncoming(begin, PreheaderBB);
+                Builder.CreateCondBr(Builder.CreateICmpNE(walk, end), BodyBB, AfterBB);
+                Cur = walk;
+            } else {
+                index = Builder.CreatePHI(Builder.getInt64Ty(), 2, "i");
+                index->addIncoming(getArrElementIndex(0), PreheaderBB);
+
+                llvm::Value *arr = coll;
+                if(header) {
+                    reloads.push_back(Builder.CreateLoad(header, "forarr"));
+                    arr = reloads.back();
+                }
+                auto data = Builder.CreateExtractValue(arr, 0, "fordata");
+                Builder.CreateCondBr(Builder.CreateICmpULT(index, Builder.CreateExtractValue(arr, 1, "forlen")), BodyBB, AfterBB);
+
+                Builder.SetInsertPoint(BodyBB);
+                Cur = Builder.CreateInBoundsGEP(data, index, elem_name);
+            }
+
+            Builder.SetInsertPoint(BodyBB);
+
+            // Bind the element name for the body, shadowing any variable with the same name
+            bool shadows = NamedValues.find(elem_name) != NamedValues.end();
+            auto shadowed = NamedValues[elem_name];
+
+            if(is_str) {
+                // Strings hand out each byte as a number
+                llvm::IRBuilder<> TmpB(&TheFunction->getEntryBlock(), TheFunction->getEntryBlock().begin());
+                auto byte_alloca = TmpB.CreateAlloca(llvm::Type::getDoubleTy(TheContext), 0, elem_name);
+                Builder.CreateStore(Builder.CreateUIToFP(Builder.CreateLoad(Cur), llvm::Type::getDoubleTy(TheContext)), byte_alloca);
+
+                NamedValues[elem_name] = {byte_alloca, llvm::Type::getDoubleTy(TheContext), false};
+            } else {
+                // The elements of an array variable keep its declared type, ex: the elements of a u8[] are u8s
+                std::string elem_type = "";
+                if(auto ref = dynamic_cast<VariableRefExpAST*>(collection.get())) {
+                    elem_type = NamedValues[ref->getVarName()].peko_type;
+                    elem_type = elem_type.substr(0, elem_type.rfind(" "));
+                } else if(auto slice = dynamic_cast<SliceAST*>(collection.get())) {
+                    elem_type = slice->peko_type.substr(0, slice->peko_type.rfind(" "));
+                }
+
+                NamedValues[elem_name] = {Cur, Cur->getType()->getPointerElementType(), false, elem_type};
+            }
+
+            for(int i = 0; i < body.size(); i++) {
+                debugLoc(body.at(i).get());
+                body.at(i)->irgen();
+                ASTS::resetObjRecVars();
+            }
+
+            if(shadows) {
+                NamedValues[elem_name] = shadowed;
+            } else {
+                NamedValues.erase(elem_name);
+            }
+
+            // A return already ended the block, so the loop never goes around
+            if(!Builder.GetInsertBlock()->getTerminator()) {
+                debugLoc(this);
+                if(index) {
+                    index->addIncoming(Builder.CreateAdd(index, getArrElementIndex(1), "next"), Builder.GetInsertBlock());
+                } else {
+                    llvm::cast<llvm::PHINode>(Cur)->addIncoming(Builder.CreateInBoundsGEP(Cur, getArrElementIndex(1), "fornext"), Builder.GetInsertBlock());
+                }
+                addLoopHints(Builder.CreateBr(CondBB), CondBB, hints);
+            }
+
+            if(header && !forBodyChangesArr(BodyBB, CondBB, AfterBB, header)) {
+                hoistArrReloads(reloads, coll);
+            } else if(header) {
+                // The element is found again from the array as it is now every time the body uses it, an earlier pointer
+                // could be into the buffer the body just let go of
+                std::vector<llvm::Instruction *> uses;
+                for(auto *user : Cur->users()) {
+                    if(llvm::isa<llvm::Instruction>(user) && !llvm::isa<llvm::PHINode>(user)) {
+                        uses.push_back(llvm::cast<llvm::Instruction>(user));
+                    }
+                }
+
+                for(auto *use : uses) {
+                    llvm::IRBuilder<> B(use);
+                    auto data = B.CreateExtractValue(B.CreateLoad(header, "forarr"), 0, "fordata");
+                    use->replaceUsesOfWith(Cur, B.CreateInBoundsGEP(data, index, elem_name));
+                }
+            }
+
+            Builder.SetInsertPoint(AfterBB);
+
+            for(int i = 0; i < cont.size(); i++) {
+               debugLoc(cont.at(i).get());
+               cont.at(i)->irgen();
+            }
+        } else {
+            global_expressions.push_back(this);
+        }
+
+        return nullptr;
+    }
+    
+    /**
+     * @brief The compile time twin of hashstr in the stdlib, both have to give the same hash for a string
+     * 
+     * @param str 
+     * @param seed 
+     * @return uint64_t 
+     */
+    uint64_t hashStr(const std::string &str, uint64_t seed) {
+        uint64_t hash = 14695981039346656037ULL ^ seed;
+        for(unsigned char c : str) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        return hash ^ (hash >> 32);
+    }
+
+    /**
+     * @brief Numbers are matched with a switch on the integer value, so llvm can turn dense cases into a jump table.
+     * Values outside of the case range or with a fraction go straight to the default block
+     * 
+     * @return llvm::Value* 
+     */
+    llvm::Value *MatchExpAST::numberSwitch(llvm::Value *val, std::vector<llvm::BasicBlock*> case_blocks, llvm::BasicBlock *default_block) {
+        auto *TheFunction = Builder.GetInsertBlock()->getParent();
+
+        std::map<int64_t, int> case_of_value;
+        int64_t min = INT64_MAX, max = INT64_MIN;
+
+        for(int i = 0; i < cases.size(); i++) {
+            for(auto &v : cases.at(i).values) {
+                auto *num = dynamic_cast<NumberExpAST*>(v.get());
+                if(!num) {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m a match on a number can only have number cases");
+                    return nullptr;
+                }
+
+                double d = num->getVal();
+                if(d != (double)(int64_t)d) {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m match cases on numbers must be whole numbers: " + std::to_string(d));
+                    return nullptr;
+                }
+
+                if(case_of_value.count((int64_t)d)) {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m duplicate match case: " + std::to_string((int64_t)d));
+                    return nullptr;
+                }
+
+                case_of_value[(int64_t)d] = i;
+                min = std::min(min, (int64_t)d);
+                max = std::max(max, (int64_t)d);
+            }
+        }
+
+        if(case_of_value.empty()) {
+            Builder.CreateBr(default_block);
+            return val;
+        }
+
+        // fptosi is only defined for values in range, so check the range before converting
+        auto *CheckBB  = llvm::BasicBlock::Create(TheContext, "matchint", TheFunction);
+        auto *SwitchBB = llvm::BasicBlock::Create(TheContext, "matchswitch", TheFunction);
+
+        auto in_range = Builder.CreateAnd(
+            Builder.CreateFCmpOGE(val, llvm::ConstantFP::get(TheContext, llvm::APFloat((double)min))),
+            Builder.CreateFCmpOLE(val, llvm::ConstantFP::get(TheContext, llvm::APFloat((double)max))), "matchinrange");
+        Builder.CreateCondBr(in_range, CheckBB, default_block);
+
+        Builder.SetInsertPoint(CheckBB);
+        auto int_val = Builder.CreateFPToSI(val, Builder.getInt64Ty(), "matchval");
+        auto whole = Builder.CreateFCmpOEQ(Builder.CreateSIToFP(int_val, Builder.getDoubleTy()), val, "matchwhole");
+        Builder.CreateCondBr(whole, SwitchBB, default_block);
+
+        Builder.SetInsertPoint(SwitchBB);
+        auto *sw = Builder.CreateSwitch(int_val, default_block, case_of_value.size());
+        for(auto &cv : case_of_value) {
+            sw->addCase(Builder.getInt64(cv.first), case_blocks.at(cv.second));
+        }
+
+        return val;
+    }
+
+    /**
+     * @brief Strings are matched by hashing the value once and switching on the hash slot. The seed and table size are picked
+     * at compile time so every case string has its own slot, leaving a single strcmp to confirm the match
+     * 
+     * @return llvm::Value* 
+     */
+    llvm::Value *MatchExpAST::stringSwitch(llvm::Value *val, std::vector<llvm::BasicBlock*> case_blocks, llvm::BasicBlock *default_block) {
+        auto *TheFunction = Builder.GetInsertBlock()->getParent();
+
+        std::vector<std::pair<std::string, int>> strs;
+        std::set<std::string> seen;
+
+        for(int i = 0; i < cases.size(); i++) {
+            for(auto &v : cases.at(i).values) {
+                auto *str = dynamic_cast<StringExpAST*>(v.get());
+                if(!str) {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m a match on a string can only have string cases");
+                    return nullptr;
+                }
+
+                if(!seen.insert(str->getVal()).second) {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m duplicate match case: \"" + str->getVal() + "\"");
+                    return nullptr;
+                }
+
+                strs.push_back({str->getVal(), i});
+            }
+        }
+
+        if(strs.empty()) {
+            Builder.CreateBr(default_block);
+            return val;
+        }
+
+        // Search for a seed that gives every case its own slot, growing the table when no seed works
+        uint64_t table_size = 1;
+        while(table_size < strs.size()) {
+            table_size <<= 1;
+        }
+
+        uint64_t seed = 0;
+        for(bool found = false; !found; ) {
+            for(seed = 0; seed < 256 && !found; seed++) {
+                std::set<uint64_t> slots;
+                found = true;
+
+                for(auto &s : strs) {
+                    if(!slots.insert(hashStr(s.first, seed) & (table_size-1)).second) {
+                        found = false;
+                        break;
+                    }
+                }
+            }
+
+            if(found) {
+                seed--;
+            } else {
+                table_size <<= 1;
+            }
+        }
+
+        auto hash = Builder.CreateCall(TheModule->getFunction("hashstr"), {val, Builder.getInt64(seed)}, "matchhash");
+        auto slot = Builder.CreateAnd(hash, Builder.getInt64(table_size-1), "matchslot");
+
+        auto *sw = Builder.CreateSwitch(slot, default_block, strs.size());
+        for(auto &s : strs) {
+            auto *CmpBB = llvm::BasicBlock::Create(TheContext, "matchcmp", TheFunction);
+            sw->addCase(Builder.getInt64(hashStr(s.first, seed) & (table_size-1)), CmpBB);
+
+            Builder.SetInsertPoint(CmpBB);
+            auto cmp = Builder.CreateCall(TheModule->getFunction("strcmp"), {val, Builder.CreateGlobalStringPtr(s.first)}, "matchcmp");
+            Builder.CreateCondBr(Builder.CreateICmpEQ(cmp, Builder.getInt32(0)), case_blocks.at(s.second), default_block);
+        }
+
+        return val;
+    }
+
+    /**
+     * @brief Generates the dispatch for the subject's type, then every case body once, all falling through to the code after the match
+     * 
+     * @return llvm::Value* 
+     */
+    llvm::Value *MatchExpAST::irgen() {
+        if(Cur_BB) {
+            auto *TheFunction = Builder.GetInsertBlock()->getParent();
+
+            auto val = subject->irgen();
+            ASTS::resetObjRecVars();
+
+            if(!val) {
+                return nullptr;
+            }
+
+            std::vector<llvm::BasicBlock*> case_blocks;
+            for(int i = 0; i < cases.size(); i++) {
+                case_blocks.push_back(llvm::BasicBlock::Create(TheContext, "matchcase", TheFunction));
+            }
+
+            auto *MergeBB   = llvm::BasicBlock::Create(TheContext, "aftermatch", TheFunction);
+            auto *DefaultBB = els.empty() ? MergeBB : llvm::BasicBlock::Create(TheContext, "matchdefault", TheFunction);
+
+            if(isNumType(val->getType())) {
+                // Every sized number fits in a double exactly, so the cases are checked on one
+                val = numberSwitch(convertNum(val, Builder.getDoubleTy(), subject->is_unsigned, false), case_blocks, DefaultBB);
+            } else if(val->getType() == llvm::Type::getInt8PtrTy(TheContext)) {
+                val = stringSwitch(val, case_blocks, DefaultBB);
+            } else {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m can only match numbers and strings");
+                val = nullptr;
+            }
+
+            if(!val) {
+                return nullptr;
+            }
+
+            for(int i = 0; i < cases.size(); i++) {
+                Builder.SetInsertPoint(case_blocks.at(i));
+
+                for(auto &exp : cases.at(i).body) {
+                    debugLoc(exp.get());
+                    exp->irgen();
+                    ASTS::resetObjRecVars();
+                }
+
+                if(!Builder.GetInsertBlock()->getTerminator()) {
+                    Builder.CreateBr(MergeBB);
+                }
+            }
+
+            if(!els.empty()) {
+                Builder.SetInsertPoint(DefaultBB);
+
+                for(auto &exp : els) {
+                    debugLoc(exp.get());
+                    exp->irgen();
+                    ASTS::resetObjRecVars();
+                }
+
+                if(!Builder.GetInsertBlock()->getTerminator()) {
+                    Builder.CreateBr(MergeBB);
+                }
+            }
+
+            Builder.SetInsertPoint(MergeBB);
+
+            for(int i = 0; i < cont.size(); i++) {
+               debugLoc(cont.at(i).get());
+               cont.at(i)->irgen();
+            }
+        } else {
+            global_expressions.push_back(this);
+        }
+
+        return nullptr;
+    }
+
+    /**
+     * @brief Loops over an array that keeps its objects in columns. Each object is copied into a temporary for the body,
+     * and only the fields the body can change are copied back, so the loop reads and writes the columns it uses and nothing else
+     * 
+     * @param coll the {T*, i64} of the array
+     */
+    void ForExpAST::soaLoop(llvm::Value *coll, llvm::Value *header) {
+        auto *TheFunction = Builder.GetInsertBlock()->getParent();
+        auto obj_type = allocatedObjects[soa_types[coll->getType()->getStructElementType(0)->getPointerElementType()]].struct_ty;
+
+        llvm::IRBuilder<> TmpB(&TheFunction->getEntryBlock(), TheFunction->getEntryBlock().begin());
+        auto elem = TmpB.CreateAlloca(obj_type, 0, elem_name);
+
+        auto *PreheaderBB = Builder.GetInsertBlock();
+        auto *CondBB      = llvm::BasicBlock::Create(TheContext, "forcond", TheFunction);
+        auto *BodyBB      = llvm::BasicBlock::Create(TheContext, "forbody", TheFunction);
+        auto *AfterBB     = llvm::BasicBlock::Create(TheContext, "afterfor", TheFunction);
+
+        Builder.CreateBr(CondBB);
+        Builder.SetInsertPoint(CondBB);
+
+        auto *index = Builder.CreatePHI(Builder.getInt64Ty(), 2, "i");
+        index->addIncoming(getArrElementIndex(0), PreheaderBB);
+
+        // Like other arrays the columns are found again every time around, growing the array moves them into a new buffer
+        std::vector<llvm::LoadInst *> reloads;
+        llvm::Value *arr = coll;
+        if(header) {
+            reloads.push_back(Builder.CreateLoad(header, "forarr"));
+            arr = reloads.back();
+        }
+        Builder.CreateCondBr(Builder.CreateICmpULT(index, Builder.CreateExtractValue(arr, 1, "forlen")), BodyBB, AfterBB);
+
+        Builder.SetInsertPoint(BodyBB);
+
+        std::set<llvm::Value *> gather_geps;
+        soaGather(arr, index, elem, &gather_geps);
+
+        bool shadows = NamedValues.find(elem_name) != NamedValues.end();
+        auto shadowed = NamedValues[elem_name];
+        NamedValues[elem_name] = {elem, obj_type, false};
+
+        for(int i = 0; i < body.size(); i++) {
+            debugLoc(body.at(i).get());
+            body.at(i)->irgen();
+            ASTS::resetObjRecVars();
+        }
+
+        if(shadows) {
+            NamedValues[elem_name] = shadowed;
+        } else {
+            NamedValues.erase(elem_name);
+        }
+
+        // Find the fields the body wrote to, anything besides reading a field could change it
+        std::set<int> written;
+        bool all_written = false;
+        for(auto *user : elem->users()) {
+            auto *gep = llvm::dyn_cast<llvm::GetElementPtrInst>(user);
+
+            if(gather_geps.count(user)) {
+                continue;
+            } else if(gep && gep->getNumIndices() == 2 && llvm::isa<llvm::ConstantInt>(gep->getOperand(2))) {
+                for(auto *field_user : gep->users()) {
+                    if(!llvm::isa<llvm::LoadInst>(field_user)) {
+                        written.insert(llvm::cast<llvm::ConstantInt>(gep->getOperand(2))->getZExtValue());
+                    }
+                }
+            } else if(!llvm::isa<llvm::LoadInst>(user)) {
+                all_written = true;
+            }
+        }
+
+        // A return already ended the block, so the loop never goes around
+        if(!Builder.GetInsertBlock()->getTerminator()) {
+            debugLoc(this);
+            if(all_written || !written.empty()) {
+                if(header) {
+                    reloads.push_back(Builder.CreateLoad(header, "forarr"));
+                }
+                soaScatter(header ? reloads.back() : coll, index, elem, all_written ? std::set<int>() : written);
+            }
+
+            index->addIncoming(Builder.CreateAdd(index, getArrElementIndex(1), "next"), Builder.GetInsertBlock());
+            addLoopHints(Builder.CreateBr(CondBB), CondBB, hints);
+        }
+
+        if(header && !forBodyChangesArr(BodyBB, CondBB, AfterBB, header)) {
+            hoistArrReloads(reloads, coll);
+        }
+
+        Builder.SetInsertPoint(AfterBB);
+
+        for(int i = 0; i < cont.size(); i++) {
+           debugLoc(cont.at(i).get());
+           cont.at(i)->irgen();
+        }
+    }
+
+    llvm::BasicBlock *CurrentInsertPoint = nullptr;
+    llvm::BasicBlock *createIfBranch(std::vector<llvm::BasicBlock*> eif_blocks, llvm::BasicBlock *e_block, llvm::BasicBlock *cont_block, int *x, std::vector<std::unique_ptr<IfExpAST>> eif) {
+        if(*x <= (int)eif_blocks.size()-1) {
+            llvm::Function *TheFunction = Builder.GetInsertBlock()->getParent();
+            llvm::BasicBlock *newbb = llvm::BasicBlock::Create(TheContext, "condbb", TheFunction);
+            
+            auto CurInsPointBuf = CurrentInsertPoint;
+            
+            Builder.SetInsertPoint(newbb);
+            int cur_eif = *x;
+            *x += 1;
+
+            // The condition can create its own blocks (ex: and/or), so the branch goes where the condition ended
+            auto cond = toCondition(eif.at(cur_eif)->getCondition()->irgen());
+            CurrentInsertPoint = Builder.GetInsertBlock();
+
+            auto *next = createIfBranch(eif_blocks, e_block, cont_block, x, std::move(eif));
+            Builder.SetInsertPoint(CurrentInsertPoint);
+            Builder.CreateCondBr(cond, eif_blocks.at(cur_eif), next);
+            
+            CurrentInsertPoint = CurInsPointBuf;
+            Builder.SetInsertPoint(CurrentInsertPoint);
+            return newbb;
+        } else if(e_block) {
+            return e_block;
+        } else {
+            return cont_block;
+        }
+    }
+
+    llvm::BasicBlock *ContBB = nullptr;
+    llvm::Value *IfExpAST::irgen() {
+        if(Cur_BB) {
+            auto cond_gened = toCondition(condition->irgen());
+            CurrentInsertPoint = Builder.GetInsertBlock();
+            auto CurInsPointBuf = CurrentInsertPoint;
+            
+            llvm::Function *TheFunction = Builder.GetInsertBlock()->getParent();
+            llvm::BasicBlock *IfBodyBB = llvm::BasicBlock::Create(TheContext, "body", TheFunction);
+            llvm::BasicBlock *MergeBB = llvm::BasicBlock::Create(TheContext, "ifcont", TheFunction);
+            
+            llvm::BasicBlock *ElseBB = nullptr;
+            if(els.size() > 0) {
+                ElseBB = llvm::BasicBlock::Create(TheContext, "else", TheFunction);
+                Builder.SetInsertPoint(ElseBB);
+                for(auto &ast : els) {
+                    debugLoc(ast.get());
+                    ast->irgen();
+                    ASTS::resetObjRecVars();
+                }
+
+                // A return already ended the block
+                if(!Builder.GetInsertBlock()->getTerminator()) {
+                    Builder.CreateBr(MergeBB);
+                }
+                Builder.SetInsertPoint(CurrentInsertPoint);
+            }
+
+            Builder.SetInsertPoint(IfBodyBB);
+            
+            for(int i = 0; i < body.size(); i++) {
+                debugLoc(body.at(i).get());
+                body.at(i)->irgen();
+            }
+
+            if(!Builder.GetInsertBlock()->getTerminator()) {
+                Builder.CreateBr(MergeBB);
+            }
+
+            //IfBodyBB = Builder.GetInsertBlock();
+
+            std::vector<llvm::BasicBlock *> elseif_blocks = {};
+
+            for(auto &eif : els_if) {
+                auto newbb = llvm::BasicBlock::Create(TheContext, "elseif", TheFunction);
+                Builder.SetInsertPoint(newbb);
+                for(auto &ex : eif->body) {
+                    debugLoc(ex.get());
+                    ex->irgen();
+                    ASTS::resetObjRecVars();
+                }
+
+                if(!Builder.GetInsertBlock()->getTerminator()) {
+                    Builder.CreateBr(MergeBB);
+                }
+                elseif_blocks.push_back(newbb);
+            }
+
+            Builder.SetInsertPoint(MergeBB);
+            for(int i = 0; i < then.size(); i++) {
+                debugLoc(then.at(i).get());
+                then.at(i)->irgen();
+            }
+
+            // The code after the if statement can create its own blocks (ex: loops), so keep inserting where it ended
+            auto *EndBB = Builder.GetInsertBlock();
+
+            CurrentInsertPoint = CurInsPointBuf;
+
+            Builder.SetInsertPoint(CurrentInsertPoint);
+
+            int x = 0;
+            debugLoc(this);
+            Builder.CreateCondBr(cond_gened, IfBodyBB, createIfBranch(elseif_blocks, ElseBB, MergeBB, &x, std::move(els_if)));
+            
+            Builder.SetInsertPoint(EndBB);
+        } else {
+            global_expressions.push_back(this);
+        }
+
+        return nullptr;
+    }
+
+    // Gives a value ref to a number
+    llvm::Value *NumberExpAST::irgen() {
+        return llvm::ConstantFP::get(TheContext, llvm::APFloat(value));
+    }
+
+    // Gives a value ref to a bool
+    llvm::Value *BoolExpAST::irgen() {
+        return llvm::ConstantInt::get(llvm::Type::getInt1Ty(TheContext), value);
+    }
+
+    // Gives a value ref to a string
+    llvm::Value *StringExpAST::irgen() {
+        return Builder.CreateGlobalStringPtr(llvm::StringRef(value));
+    }
+
+    // Returns the reference to a variable
+    /**
+     * @brief Calls the function that sets up a global the first time it's used, for globals whose value is only known when the program runs
+     *
+     * @param name
+     */
+    void initGlobalOnUse(const std::string &name) {
+        if(!lazy_globals.count(name) || !NamedValues[name].global || !Builder.GetInsertBlock()) {
+            return;
+        }
+
+        auto *InitF = lazy_globals[name];
+        auto *TheFunction = Builder.GetInsertBlock()->getParent();
+
+        // The global is marked as ready before its value is worked out, so it can use itself
+        if(TheFunction == InitF) {
+            return;
+        }
+
+        // Threads can race to the first use, so the flag is read atomically. Acquire pairs with the release stores that set it
+        auto ready = Builder.CreateLoad(TheModule->getNamedGlobal(name + ".ready"), name + ".ready");
+        ready->setAtomic(llvm::AtomicOrdering::Acquire);
+        ready->setAlignment(llvm::Align(1));
+        auto *InitBB  = llvm::BasicBlock::Create(TheContext, name + ".init", TheFunction);
+        auto *ReadyBB = llvm::BasicBlock::Create(TheContext, name + ".ready", TheFunction);
+
+        Builder.CreateCondBr(Builder.CreateIsNotNull(ready), ReadyBB, InitBB);
+
+        Builder.SetInsertPoint(InitBB);
+        Builder.CreateCall(InitF);
+        Builder.CreateBr(ReadyBB);
+
+        Builder.SetInsertPoint(ReadyBB);
+    }
+
+    /**
+     * @brief Marks a global that's set up on first use as ready, so assigning it a value skips its initializer
+     *
+     * @param name
+     */
+    void markGlobalReady(const std::string &name) {
+        if(!lazy_globals.count(name) || !NamedValues[name].global || !Builder.GetInsertBlock()) {
+            return;
+        }
+
+        auto mark = Builder.CreateStore(Builder.getInt8(1), TheModule->getNamedGlobal(name + ".ready"));
+        mark->setAtomic(llvm::AtomicOrdering::Release);
+        mark->setAlignment(llvm::Align(1));
+    }
+
+    llvm::Value *VariableRefExpAST::irgen() {
+        // Look this variable up in the function.
+        initGlobalOnUse(var_name);
+        auto var = NamedValues[var_name];
+        if (!var.val) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m undefined variable reference: " + var_name);
+            return nullptr;
+        }
+            
+        is_unsigned = var.peko_type == "u8";
+
+        if(var.is_value) {
+            return var.val;
+        }
+            
+        if(var.global == true && var.type == llvm::Type::getInt8PtrTy(TheContext)) {                
+            return Builder.CreateLoad(TheModule->getNamedGlobal(var_name));
+        } else if(var.type == llvm::Type::getInt8PtrTy(TheContext) || isNumType(var.type) || var.type == llvm::Type::getInt1Ty(TheContext) || var.type->isVectorTy()) {
+            return Builder.CreateLoad(var.val);
+        } else {
+            return var.val;
+        }
+    
+        return nullptr;
+    }
+
+    // A value worked out while compiling
+    struct const_value {
+        int type = -1; // number_ty, string_ty or bool_ty
+        double num = 0;
+        std::string str;
+        bool b = false;
+    };
+
+    // The variables of a const fn being run by the compiler
+    struct const_frame {
+        std::map<std::string, const_value> vars;
+        bool returned = false;
+        const_value ret;
+    };
+
+    std::map<std::string, const_value> const_globals; // the values of const globals, so constant expressions can use them
+
+    const int CONST_STEP_LIMIT = 1000000; // how many expressions a const fn call can run before it's left to run with the program
+    const int CONST_DEPTH_LIMIT = 256; // how deep const fns can call each other while compiling
+    int const_steps = 0;
+    std::set<ExpAST*> const_unknown; // the expressions outside const fns already found to have no known value, so folding each enclosing expression doesn't work them out again
+    int const_depth = 0;
+
+    bool constEval(ExpAST *exp, const_frame *frame, const_value &out);
+
+    /**
+     * @brief Checks if a const value is true, numbers are true when they aren't 0 like in conditions
+     * 
+     * @param val 
+     * @return true 
+     * @return false 
+     */
+    bool constTruthy(const const_value &val) {
+        return val.type == bool_ty ? val.b : val.num != 0;
+    }
+
+    /**
+     * @brief Runs the statements of a const fn, stopping at a return
+     * 
+     * @param body 
+     * @param frame 
+     * @return true if every statement could be run while compiling
+     * @return false 
+     */
+    bool constExec(std::vector<std::unique_ptr<ExpAST>> &body, const_frame &frame) {
+        const_value val;
+
+        for(auto &stmt : body) {
+            if(frame.returned) {
+                return true;
+            }
+
+            if(auto ret = dynamic_cast<ReturnExpAST*>(stmt.get())) {
+                if(ret->Ret_value && !constEval(ret->Ret_value.get(), &frame, frame.ret)) {
+                    return false;
+                }
+
+                frame.returned = true;
+            } else if(auto var = dynamic_cast<VariableExpAST*>(stmt.get())) {
+                bool redec = var->getVarKind() == -1;
+                if(redec && !frame.vars.count(var->getName())) {
+                    return false;
+                }
+
+                // Only the types the compiler keeps exactly like the program would, ex: an i32 divides differently
+                if(!redec && var->getVarType() != "number" && var->getVarType() != "string" && var->getVarType() != "bool") {
+                    return false;
+                }
+
+                if(var->getVAST()) {
+                    if(!constEval(var->getVAST(), &frame, val)) {
+                        return false;
+                    }
+                } else {
+                    val = const_value();
+                    val.type = var->getVarKind();
+                }
+
+                int type = redec ? frame.vars[var->getName()].type : var->getVarKind();
+                if(val.type != type) {
+                    return false;
+                }
+
+                frame.vars[var->getName()] = val;
+            } else if(auto ifexp = dynamic_cast<IfExpAST*>(stmt.get())) {
+                if(!constEval(ifexp->getCondition(), &frame, val)) {
+                    return false;
+                }
+
+                auto *branch = &ifexp->getElse();
+                if(constTruthy(val)) {
+                    branch = &ifexp->getIfBody();
+                } else {
+                    for(auto &eif : ifexp->getElseIfs()) {
+                        if(!constEval(eif->getCondition(), &frame, val)) {
+                            return false;
+                        }
+
+                        if(constTruthy(val)) {
+                            branch = &eif->getIfBody();
+                            break;
+                        }
+                    }
+                }
+
+                if(!constExec(*branch, frame) || !constExec(ifexp->getThen(), frame)) {
+                    return false;
+                }
+            } else if(auto loop = dynamic_cast<LoopExpAST*>(stmt.get())) {
+                while(!frame.returned) {
+                    if(!constEval(loop->getCondition(), &frame, val)) {
+                        return false;
+                    }
+
+                    if(!constTruthy(val)) {
+                        break;
+                    }
+
+                    if(!constExec(loop->getLoopBody(), frame)) {
+                        return false;
+                    }
+                }
+
+                if(!constExec(loop->getCont(), frame)) {
+                    return false;
+                }
+            } else if(!constEval(stmt.get(), &frame, val)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Runs a const fn while compiling
+     * 
+     * @param callee 
+     * @param args the values of the arguments
+     * @param out 
+     * @return true if the call finished within the step budget
+     * @return false 
+     */
+    bool constCall(const std::string &callee, std::vector<const_value> &args, const_value &out) {
+        if(!const_fns.count(callee) || const_depth >= CONST_DEPTH_LIMIT) {
+            return false;
+        }
+
+        auto fn = const_fns[callee];
+        auto fn_args = fn->getProto()->getArgs();
+        auto ret_type = fn->getProto()->fn_type;
+        if(fn_args.size() != args.size() || (ret_type.second != "number" && ret_type.second != "string" && ret_type.second != "bool")) {
+            return false;
+        }
+
+        const_frame frame;
+        for(int i = 0; i < args.size(); i++) {
+            if(fn_args[i].second.second != "number" && fn_args[i].second.second != "string" && fn_args[i].second.second != "bool") {
+                return false;
+            }
+
+            if(args[i].type != fn_args[i].second.first) {
+                return false;
+            }
+
+            frame.vars[fn_args[i].first] = args[i];
+        }
+
+        const_depth++;
+        bool ran = constExec(fn->getStatements(), frame);
+        const_depth--;
+
+        if(!ran || !frame.returned || frame.ret.type != ret_type.first) {
+            return false;
+        }
+
+        out = frame.ret;
+        return true;
+    }
+
+    /**
+     * @brief Gets how many arguments a math builtin takes, min and max of one argument are reductions instead
+     *
+     * @param callee
+     * @return int 0 if callee isn't a math builtin
+     */
+    int mathArity(const std::string &callee) {
+        if(callee == "fma") {
+            return 3;
+        } else if(callee == "pow" || callee == "min" || callee == "max") {
+            return 2;
+        } else if(callee == "sqrt" || callee == "abs" || callee == "exp" || callee == "log" || callee == "sin" || callee == "cos"
+                || callee == "floor" || callee == "ceil" || callee == "round" || callee == "trunc") {
+            return 1;
+        }
+
+        return 0;
+    }
+
+    /**
+     * @brief Works out a math builtin on constant numbers, the same way llvm folds the intrinsic it becomes
+     *
+     * @param callee
+     * @param args
+     * @param out
+     * @return true
+     * @return false if callee isn't a math builtin or an argument isn't a number
+     */
+    bool constMath(const std::string &callee, std::vector<const_value> &args, const_value &out) {
+        if(function_protos.count(callee) || mathArity(callee) != args.size()) {
+            return false;
+        }
+
+        for(auto &arg : args) {
+            if(arg.type != number_ty) {
+                return false;
+            }
+        }
+
+        double x = args[0].num;
+        out.type = number_ty;
+        if(callee == "sqrt") {
+            out.num = std::sqrt(x);
+        } else if(callee == "abs") {
+            out.num = std::fabs(x);
+        } else if(callee == "exp") {
+            out.num = std::exp(x);
+        } else if(callee == "log") {
+            out.num = std::log(x);
+        } else if(callee == "sin") {
+            out.num = std::sin(x);
+        } else if(callee == "cos") {
+            out.num = std::cos(x);
+        } else if(callee == "floor") {
+            out.num = std::floor(x);
+        } else if(callee == "ceil") {
+            out.num = std::ceil(x);
+        } else if(callee == "round") {
+            out.num = std::round(x);
+        } else if(callee == "trunc") {
+            out.num = std::trunc(x);
+        } else if(callee == "pow") {
+            out.num = std::pow(x, args[1].num);
+        } else if(callee == "min") {
+            out.num = std::fmin(x, args[1].num);
+        } else if(callee == "max") {
+            out.num = std::fmax(x, args[1].num);
+        } else {
+            out.num = std::fma(x, args[1].num, args[2].num);
+        }
+
+        return true;
+    }
+
+    /**
+     * @brief Works out the value of an expression while compiling, for literals, the operators on them and calls to const fns
+     * 
+     * @param exp 
+     * @param frame the variables of the const fn being run, nullptr outside of one
+     * @param out 
+     * @return true if the value is known
+     * @return false 
+     */
+    bool constEvalExp(ExpAST *exp, const_frame *frame, const_value &out) {
+        if(!exp || const_steps++ > CONST_STEP_LIMIT) {
+            return false;
+        }
+
+        out = const_value();
+        if(auto num = dynamic_cast<NumberExpAST*>(exp)) {
+            out.type = number_ty;
+            out.num = num->getVal();
+        } else if(auto str = dynamic_cast<StringExpAST*>(exp)) {
+            out.type = string_ty;
+            out.str = str->getVal();
+        } else if(auto boolean = dynamic_cast<BoolExpAST*>(exp)) {
+            out.type = bool_ty;
+            out.b = boolean->getVal();
+        } else if(auto ref = dynamic_cast<VariableRefExpAST*>(exp)) {
+            std::string name = ref->getVarName();
+            if(frame && frame->vars.count(name)) {
+                out = frame->vars[name];
+            } else if(const_globals.count(name) && (frame || (NamedValues.count(name) && NamedValues[name].global))) {
+                out = const_globals[name];
+            } else {
+                return false;
+            }
+        } else if(auto unary = dynamic_cast<UnaryExpAST*>(exp)) {
+            const_value val;
+            if(unary->op != "not" || !constEval(unary->operand.get(), frame, val)) {
+                return false;
+            }
+
+            out.type = bool_ty;
+            out.b = !constTruthy(val);
+        } else if(auto call = dynamic_cast<CallExpAST*>(exp)) {
+            std::vector<const_value> args(call->args.size());
+            for(int i = 0; i < call->args.size(); i++) {
+                if(!constEval(call->args[i].get(), frame, args[i])) {
+                    return false;
+                }
+            }
+
+            if(call->getCallee() == "len" && !function_protos.count("len") && args.size() == 1 && args[0].type == string_ty) {
+                out.type = number_ty;
+                out.num = args[0].str.size();
+                return true;
+            }
+
+            if(constMath(call->getCallee(), args, out)) {
+                return true;
+            }
+
+            return constCall(call->getCallee(), args, out);
+        } else if(auto bin = dynamic_cast<BinaryExpAST*>(exp)) {
+            const_value L, R;
+            if(!constEval(bin->LHS.get(), frame, L)) {
+                return false;
+            }
+
+            // and / or only look at the right side when it can change the result
+            if(bin->op == "and" || bin->op == "or") {
+                out.type = bool_ty;
+                if(constTruthy(L) == (bin->op == "or")) {
+                    out.b = bin->op == "or";
+                    return true;
+                }
+
+                if(!constEval(bin->RHS.get(), frame, R)) {
+                    return false;
+                }
+
+                out.b = constTruthy(R);
+                return true;
+            }
+
+            if(!constEval(bin->RHS.get(), frame, R)) {
+                return false;
+            }
+
+            std::string op = bin->op;
+
+            // Bools are used as the numbers 0 and 1 when they aren't compared with each other
+            if(L.type == bool_ty && R.type == bool_ty && (op == "==" || op == "!=")) {
+                out.type = bool_ty;
+                out.b = (L.b == R.b) == (op == "==");
+                return true;
+            }
+
+            for(auto side : {&L, &R}) {
+                if(side->type == bool_ty) {
+                    side->type = number_ty;
+                    side->num = side->b;
+                }
+            }
+
+            if(L.type == string_ty && R.type == string_ty) {
+                if(op == "+") {
+                    out.type = string_ty;
+                    out.str = L.str + R.str;
+                } else if(op == "==" || op == "!=") {
+                    out.type = bool_ty;
+                    out.b = (L.str == R.str) == (op == "==");
+                } else {
+                    return false;
+                }
+            } else if(L.type == string_ty && R.type == number_ty && op == "*") {
+                // Like mulstr, the string is repeated once for every whole number below the count, only whole counts that
+                // give a sensibly sized string are worked out and every repeat is charged to the step budget
+                if(R.num != std::floor(R.num) || R.num > 65536) {
+                    return false;
+                }
+
+                out.type = string_ty;
+                for(int i = 0; i < (int)R.num; i++) {
+                    out.str += L.str;
+                    if(out.str.size() > 65536 || const_steps++ > CONST_STEP_LIMIT) {
+                        return false;
+                    }
+                }
+            } else if(L.type == number_ty && R.type == number_ty) {
+                out.type = number_ty;
+                if(op == "+") {
+                    out.num = L.num + R.num;
+                } else if(op == "-") {
+                    out.num = L.num - R.num;
+                } else if(op == "*") {
+                    out.num = L.num * R.num;
+                } else if(op == "/") {
+                    out.num = L.num / R.num;
+                } else if(op == "%") {
+                    // The same as modnum, which only works on whole numbers
+                    if(floor(L.num) != ceil(L.num) || floor(R.num) != ceil(R.num)) {
+                        out.num = 1.0;
+                    } else if(std::fabs(L.num) >= 2147483648.0 || std::fabs(R.num) >= 2147483648.0 || (int)R.num == 0) {
+                        return false;
+                    } else {
+                        out.num = (int)L.num % (int)R.num;
+                    }
+                } else {
+                    // Comparisons are unordered like the fcmps the program would use, so a NaN compares as true
+                    bool unordered = std::isnan(L.num) || std::isnan(R.num);
+                    out.type = bool_ty;
+
+                    if(op == "<") {
+                        out.b = unordered || L.num < R.num;
+                    } else if(op == ">") {
+                        out.b = unordered || L.num > R.num;
+                    } else if(op == "<=") {
+                        out.b = unordered || L.num <= R.num;
+                    } else if(op == ">=") {
+                        out.b = unordered || L.num >= R.num;
+                    } else if(op == "==") {
+                        out.b = unordered || L.num == R.num;
+                    } else if(op == "!=") {
+                        out.b = unordered || L.num != R.num;
+                    } else {
+                        return false;
+                    }
+                }
+            } else {
+                return false;
+            }
+        } else {
+            return false;
+        }
+
+        return true;
+    }
+
+    bool constEval(ExpAST *exp, const_frame *frame, const_value &out) {
+        // Outside of const fns every expression only has one value, so one that can't be worked out is remembered and
+        // isn't worked through again when the expressions around it and then its own parts are folded
+        if(!frame && const_unknown.count(exp)) {
+            return false;
+        }
+
+        if(constEvalExp(exp, frame, out)) {
+            return true;
+        }
+
+        if(!frame && exp) {
+            const_unknown.insert(exp);
+        }
+        return false;
+    }
+
+    /**
+     * @brief Tries to work out an expression while compiling, giving the llvm constant of its value
+     * 
+     * @param exp 
+     * @return llvm::Value* nullptr when the value isn't known until the program runs
+     */
+    llvm::Value *constFold(ExpAST *exp) {
+        const_value val;
+        const_steps = 0;
+
+        if(!constEval(exp, nullptr, val)) {
+            return nullptr;
+        }
+
+        if(val.type == number_ty) {
+            return llvm::ConstantFP::get(TheContext, llvm::APFloat(val.num));
+        } else if(val.type == bool_ty) {
+            return Builder.getInt1(val.b);
+        } else {
+            return Builder.CreateGlobalStringPtr(val.str);
+        }
+    }
+
+    /**
+     * @brief Generates "and" and "or" so the right hand side is only evaluated when it can change the result
+     * 
+     * @return llvm::Value* an i1 phi of the result
+     */
+    llvm::Value *BinaryExpAST::shortCircuitGen() {
+        llvm::Value *L = LHS->irgen();
+        ASTS::resetObjRecVars();
+
+        if(!L)
+            return nullptr;
+
+        L = toCondition(L);
+
+        auto *TheFunction = Builder.GetInsertBlock()->getParent();
+        auto *LHSEndBB = Builder.GetInsertBlock();
+        auto *RHSBB    = llvm::BasicBlock::Create(TheContext, op + "rhs", TheFunction);
+        auto *MergeBB  = llvm::BasicBlock::Create(TheContext, op + "cont", TheFunction);
+
+        // "and" is false as soon as the left side is false and "or" is true as soon as the left side is true
+        if(op == "and")
+            Builder.CreateCondBr(L, RHSBB, MergeBB);
+        else
+            Builder.CreateCondBr(L, MergeBB, RHSBB);
+
+        Builder.SetInsertPoint(RHSBB);
+        llvm::Value *R = RHS->irgen();
+        ASTS::resetObjRecVars();
+
+        if(!R)
+            return nullptr;
+
+        R = toCondition(R);
+        auto *RHSEndBB = Builder.GetInsertBlock();
+        Builder.CreateBr(MergeBB);
+
+        Builder.SetInsertPoint(MergeBB);
+        auto *result = Builder.CreatePHI(llvm::Type::getInt1Ty(TheContext), 2, op + "tmp");
+        result->addIncoming(llvm::ConstantInt::get(llvm::Type::getInt1Ty(TheContext), op == "or"), LHSEndBB);
+        result->addIncoming(R, RHSEndBB);
+
+        return result;
+    }
+
+    // Parse a Binary expression
+    llvm::Value *BinaryExpAST::irgen() {
+        // Math on whole arrays can show up anywhere a value can, ex: return a + b; or f(a * 2.0), and makes a new array
+        if(isArrayExp(this)) {
+            return fuseArrayExp(this, nullptr);
+        }
+
+        // Literals and calls to const fns are worked out while compiling, ex: "foo" + "bar" doesn't call addstr
+        if(auto folded = constFold(this)) {
+            is_unsigned = false;
+            return folded;
+        }
+
+        if(op == "and" || op == "or")
+            return shortCircuitGen();
+
+        // Retrieve the llvm::Value of the left hand and right hand sides
+        llvm::Value *L = LHS->irgen();
+        ASTS::resetObjRecVars();
+
+        llvm::Value *R = RHS->irgen();
+        ASTS::resetObjRecVars();
+
+        // If either of the sides return null, than this expression tree is invalid
+        if (!L || !R)
+            return nullptr;
+
+        auto *str_ty  = llvm::Type::getInt8PtrTy(TheContext);
+        auto *bool_ty = llvm::Type::getInt1Ty(TheContext);
+        auto *num_ty  = llvm::Type::getDoubleTy(TheContext);
+
+        // Two bools can be compared directly
+        if(L->getType() == bool_ty && R->getType() == bool_ty) {
+            if(op == "==")
+                return Builder.CreateICmpEQ(L, R, "eqtmp");
+            else if(op == "!=")
+                return Builder.CreateICmpNE(L, R, "netmp");
+        }
+
+        // A strview is compared by its bytes with a string or another strview
+        llvm::Value *l_ptr, *l_len, *r_ptr, *r_len;
+        if((op == "==" || op == "!=") && (isStrView(L) || isStrView(R)) && getTextParts(L, l_ptr, l_len) && getTextParts(R, r_ptr, r_len)) {
+            auto cmp = Builder.CreateCall(TheModule->getFunction("cmpview"), {l_ptr, l_len, r_ptr, r_len}, "cmpviewtmp");
+            auto zero = llvm::ConstantInt::get(llvm::Type::getInt32Ty(TheContext), 0);
+
+            if(op == "==")
+                return Builder.CreateICmpEQ(cmp, zero, "eqtmp");
+            else
+                return Builder.CreateICmpNE(cmp, zero, "netmp");
+        }
+
+        // Two strings are compared by their contents
+        if(L->getType() == str_ty && R->getType() == str_ty && (op == "==" || op == "!=")) {
+            auto cmp = Builder.CreateCall(TheModule->getFunction("strcmp"), {L, R}, "strcmptmp");
+            auto zero = llvm::ConstantInt::get(llvm::Type::getInt32Ty(TheContext), 0);
+            
+            if(op == "==")
+                return Builder.CreateICmpEQ(cmp, zero, "eqtmp");
+            else
+                return Builder.CreateICmpNE(cmp, zero, "netmp");
+        }
+
+        // A vec works on all of its lanes at once, and a number with it is used in every lane
+        if(L->getType()->isVectorTy() || R->getType()->isVectorTy()) {
+            auto vec_type = L->getType()->isVectorTy() ? L->getType() : R->getType();
+            if(op != "+" && op != "-" && op != "*" && op != "/") {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m vecs can only be used with +, -, * and /, compare their lanes instead, ex: v[0] " + op + " w[0]");
+                return nullptr;
+            }
+
+            return numArith(op, castValue(L, vec_type), castValue(R, vec_type), false);
+        }
+
+        // Otherwise bools are used as the numbers 0 and 1, and a number literal takes the type of the other side, ex: x * 2 stays a f32
+        if(isNumType(R->getType()) && (L->getType() == bool_ty || llvm::isa<llvm::ConstantFP>(L))) {
+            L = castValue(L, R->getType());
+        } else if(L->getType() == bool_ty) {
+            L = castValue(L, num_ty);
+        }
+
+        if(isNumType(L->getType()))
+            R = castValue(R, L->getType());
+
+        is_unsigned = LHS->is_unsigned || RHS->is_unsigned;
+        bool is_int = L->getType()->isIntegerTy() && L->getType() != bool_ty;
+
+        // Generate the proper IR for the instruction
+        if(op == "+" && L->getType() == str_ty && R->getType() == str_ty) {
+            return Builder.CreateCall(TheModule->getFunction("addstr"), (std::vector<llvm::Value *>){L, R}, "calltmp");
+        } else if(op == "*" && L->getType() == str_ty && R->getType() == num_ty) {
+            return Builder.CreateCall(TheModule->getFunction("mulstr"), (std::vector<llvm::Value *>){L, R}, "calltmp");
+        } else if(op == "+" || op == "-" || op == "*" || op == "/" || op == "%") {
+            return numArith(op, L, R, is_unsigned);
+        }
+
+        // Comparisons give a bool, when there are no NaNs the ordered float comparisons are used since llvm turns those into min, max and selects
+        bool cmp_unsigned = is_unsigned;
+        bool ordered = Builder.getFastMathFlags().noNaNs();
+        is_unsigned = false;
+
+        if(op == "<") {
+            return is_int ? Builder.CreateICmp(cmp_unsigned ? llvm::CmpInst::ICMP_ULT : llvm::CmpInst::ICMP_SLT, L, R, "cmptmp") : Builder.CreateFCmp(ordered ? llvm::CmpInst::FCMP_OLT : llvm::CmpInst::FCMP_ULT, L, R, "cmptmp");
+        } else if(op == ">") {
+            return is_int ? Builder.CreateICmp(cmp_unsigned ? llvm::CmpInst::ICMP_UGT : llvm::CmpInst::ICMP_SGT, L, R, "cmptmp") : Builder.CreateFCmp(ordered ? llvm::CmpInst::FCMP_OGT : llvm::CmpInst::FCMP_UGT, L, R, "cmptmp");
+        } else if(op == "<=") {
+            return is_int ? Builder.CreateICmp(cmp_unsigned ? llvm::CmpInst::ICMP_ULE : llvm::CmpInst::ICMP_SLE, L, R, "cmptmp") : Builder.CreateFCmp(ordered ? llvm::CmpInst::FCMP_OLE : llvm::CmpInst::FCMP_ULE, L, R, "cmptmp");
+        } else if(op == ">=") {
+            return is_int ? Builder.CreateICmp(cmp_unsigned ? llvm::CmpInst::ICMP_UGE : llvm::CmpInst::ICMP_SGE, L, R, "cmptmp") : Builder.CreateFCmp(ordered ? llvm::CmpInst::FCMP_OGE : llvm::CmpInst::FCMP_UGE, L, R, "cmptmp");
+        } else if(op == "==") {
+            return is_int ? Builder.CreateICmpEQ(L, R, "eqtmp") : Builder.CreateFCmp(ordered ? llvm::CmpInst::FCMP_OEQ : llvm::CmpInst::FCMP_UEQ, L, R, "eqtmp");
+        } else if(op == "!=") {
+            return is_int ? Builder.CreateICmpNE(L, R, "netmp") : Builder.CreateFCmp(ordered ? llvm::CmpInst::FCMP_ONE : llvm::CmpInst::FCMP_UNE, L, R, "netmp");
+        } else {
+            return nullptr;
+        }
+    }
+
+    // Parse a Unary expression
+    llvm::Value *UnaryExpAST::irgen() {
+        if(auto folded = constFold(this)) {
+            return folded;
+        }
+
+        llvm::Value *V = operand->irgen();
+        ASTS::resetObjRecVars();
+
+        if(!V)
+            return nullptr;
+
+        if(op == "not") {
+            return Builder.CreateNot(toCondition(V), "nottmp");
+        } else {
+            return nullptr;
+        }
+    }
+
+    /**
+     * @brief Generates the builtins for strings, strviews and arrays: len(x), find(text, part) and split(text, separator).
+     * find gives -1 when part isn't found, and split gives a strview[] whose strviews point into text
+     * 
+     * @param callee 
+     * @param args 
+     * @return llvm::Value* 
+     */
+    llvm::Value *textBuiltin(const std::string &callee, std::vector<std::unique_ptr<ExpAST>> &args) {
+        if(args.size() != (callee == "len" ? 1 : 2)) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m " + callee + "(...) takes " + (callee == "len" ? "1 argument" : "2 arguments") + ", but was given " + std::to_string(args.size()));
+            return nullptr;
+        }
+
+        std::vector<llvm::Value *> vals;
+        for(auto &arg : args) {
+            auto val = arg->irgen();
+            if(!val) {
+                return nullptr;
+            }
+
+            vals.push_back(val);
+        }
+
+        if(callee == "len") {
+            auto val = vals[0];
+            llvm::Value *len = nullptr;
+
+            if(val->getType() == llvm::Type::getInt8PtrTy(TheContext)) {
+                len = Builder.CreateCall(TheModule->getFunction("strlen"), {val}, "strlen");
+            } else if(val->getType()->isPointerTy() && val->getType()->getPointerElementType()->isArrayTy()) {
+                len = Builder.getInt64(val->getType()->getPointerElementType()->getArrayNumElements());
+            } else if(isArrType(val->getType()) || (val->getType()->isPointerTy() && isArrType(val->getType()->getPointerElementType()))) {
+                len = Builder.CreateExtractValue(loadIfAggregatePtr(val), 1, "len");
+            } else {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m len(...) takes a string, a strview or an array");
+                return nullptr;
+            }
+
+            return Builder.CreateUIToFP(len, Builder.getDoubleTy(), "lentmp");
+        }
+
+        llvm::Value *text_ptr, *text_len, *part_ptr, *part_len;
+        if(!getTextParts(vals[0], text_ptr, text_len) || !getTextParts(vals[1], part_ptr, part_len)) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m " + callee + "(...) takes two strings or strviews");
+            return nullptr;
+        }
+
+        if(callee == "find") {
+            auto pos = Builder.CreateCall(TheModule->getFunction("findview"), {text_ptr, text_len, part_ptr, part_len}, "findtmp");
+            return Builder.CreateSIToFP(pos, Builder.getDoubleTy(), "findnum");
+        }
+
+        // The views are written into one buffer, none of the text is copied
+        auto *TheFunction = Builder.GetInsertBlock()->getParent();
+        llvm::IRBuilder<> TmpB(&TheFunction->getEntryBlock(), TheFunction->getEntryBlock().begin());
+        auto count = TmpB.CreateAlloca(Builder.getInt64Ty(), 0, "splitcount");
+
+        auto views = Builder.CreateCall(TheModule->getFunction("splitview"), {text_ptr, text_len, part_ptr, part_len, count}, "splittmp");
+
+        llvm::Value *arr = llvm::UndefValue::get(getArrType(views->getType()->getPointerElementType(), 1));
+        arr = Builder.CreateInsertValue(arr, views, 0);
+        arr = Builder.CreateInsertValue(arr, Builder.CreateLoad(count), 1);
+        return arr;
+    }
+
+    /**
+     * @brief Generates a loop that counts from start up to end in steps of step
+     * 
+     * @param start 
+     * @param end 
+     * @param step 
+     * @param init the starting values of what the loop carries, ex: a running total
+     * @param body generates the body from the index and the carried values, and gives their next values
+     * @return std::vector<llvm::Value *> the carried values after the loop
+     */
+    std::vector<llvm::Value *> countedLoop(llvm::Value *start, llvm::Value *end, uint64_t step, std::vector<llvm::Value *> init, const std::function<std::vector<llvm::Value *>(llvm::Value *, std::vector<llvm::Value *> &)> &body) {
+        auto *TheFunction = Builder.GetInsertBlock()->getParent();
+        auto *PreheaderBB = Builder.GetInsertBlock();
+        auto *CondBB  = llvm::BasicBlock::Create(TheContext, "simdcond", TheFunction);
+        auto *BodyBB  = llvm::BasicBlock::Create(TheContext, "simdbody", TheFunction);
+        auto *AfterBB = llvm::BasicBlock::Create(TheContext, "simdend", TheFunction);
+
+        Builder.CreateBr(CondBB);
+        Builder.SetInsertPoint(CondBB);
+
+        auto *index = Builder.CreatePHI(Builder.getInt64Ty(), 2, "i");
+        index->addIncoming(start, PreheaderBB);
+
+        std::vector<llvm::PHINode *> phis;
+        for(auto val : init) {
+            phis.push_back(Builder.CreatePHI(val->getType(), 2));
+            phis.back()->addIncoming(val, PreheaderBB);
+        }
 
-            auto return_gep = Builder.CreateGEP(prev_llvm_value, getGEPIndex(acc_num));
-            
-            resetObjRecVars();
-            auto var_val = lhs_to_var->getVAST()->irgen();
-            if(!getTypeName(var_val->getType()).empty()) {
-                var_val = Builder.CreateLoad(var_val);
-            }
-            Builder.CreateStore(var_val, return_gep);
+        Builder.CreateCondBr(Builder.CreateICmpULT(index, end), BodyBB, AfterBB);
+        Builder.SetInsertPoint(BodyBB);
 
-            return nullptr;
-        } else if(!strcmp(lhs_buf->getType(), "object_acc")) {
-            auto prev_lhs_to_id = dynamic_cast<IdHolder*>(prev_exp_ast);
-            auto lhs_to_objacc = dynamic_cast<ObjectAccAST*>(lhs_buf);
+        std::vector<llvm::Value *> carried(phis.begin(), phis.end());
+        auto next = body(index, carried);
 
-            prev_exp_ast = lhs_buf;
-            lhs_buf = lhs_to_objacc->GetLHS();
+        index->addIncoming(Builder.CreateAdd(index, Builder.getInt64(step), "inext"), Builder.GetInsertBlock());
+        for(int i = 0; i < phis.size(); i++) {
+            phis[i]->addIncoming(next[i], Builder.GetInsertBlock());
+        }
 
-            if(!strcmp(lhs_buf->getType(), "id")) {
-                auto lhs_lhs_to_id = dynamic_cast<IdHolder*>(lhs_to_objacc->GetLHS());
+        Builder.CreateBr(CondBB);
+        Builder.SetInsertPoint(AfterBB);
 
-                std::string prev_type_name = getTypeName(prev_llvm_value->getType());            
-                int acc_num = allocatedObjects[prev_type_name].type_name_map[lhs_lhs_to_id->getId()];
+        return carried;
+    }
 
-                auto return_gep = Builder.CreateGEP(prev_llvm_value, getGEPIndex(acc_num));
+    /**
+     * @brief How many elements the vector loops work on at once, enough to fill a 256 bit register
+     * 
+     * @param elem_type 
+     * @return unsigned 
+     */
+    unsigned simdLanes(llvm::Type *elem_type) {
+        return std::max(2u, 256u / (unsigned)elem_type->getPrimitiveSizeInBits());
+    }
 
-                prev_llvm_value = return_gep;
-            } else if(!strcmp(lhs_buf->getType(), "call")) {
-                auto lhs_to_call = dynamic_cast<CallExpAST*>(lhs_to_objacc->GetLHS());
-                lhs_to_call->argsv_extra.push_back(prev_llvm_value);
-                lhs_to_call->setCallee(getTypeName(prev_llvm_value->getType()) + "." + lhs_to_call->getCallee());
-                
-                prev_llvm_value = lhs_to_call->irgen();
-            }
-            
-            
-            lhs_buf = lhs_to_objacc->GetRHS();
-            prev_exp_ast    = lhs_to_objacc->GetLHS();
-            
-            return this->irgen();
-        } else if(!strcmp(lhs_buf->getType(), "call")) {
-            auto lhs_to_call = dynamic_cast<CallExpAST*>(lhs_buf);
+    /**
+     * @brief Loads lanes elements starting at index as one vector
+     * 
+     * @param data 
+     * @param index 
+     * @param lanes 
+     * @return llvm::Value* 
+     */
+    llvm::Value *loadLanes(llvm::Value *data, llvm::Value *index, unsigned lanes) {
+        auto elem_type = data->getType()->getPointerElementType();
+        auto vec_type = llvm::FixedVectorType::get(elem_type, lanes);
+        auto ptr = Builder.CreateBitCast(Builder.CreateInBoundsGEP(data, index), vec_type->getPointerTo());
 
-            lhs_to_call->argsv_extra.push_back(prev_llvm_value);
-            lhs_to_call->setCallee(getTypeName(prev_llvm_value->getType()) + "." + lhs_to_call->getCallee());
-            auto call = lhs_to_call->irgen();
-            resetObjRecVars();
-            return call;
+        return Builder.CreateAlignedLoad(vec_type, ptr, TheModule->getDataLayout().getABITypeAlign(elem_type));
+    }
+
+    /**
+     * @brief Stores a vector into lanes elements starting at index
+     * 
+     * @param vec 
+     * @param data 
+     * @param index 
+     */
+    void storeLanes(llvm::Value *vec, llvm::Value *data, llvm::Value *index) {
+        auto elem_type = data->getType()->getPointerElementType();
+        auto ptr = Builder.CreateBitCast(Builder.CreateInBoundsGEP(data, index), vec->getType()->getPointerTo());
+
+        Builder.CreateAlignedStore(vec, ptr, TheModule->getDataLayout().getABITypeAlign(elem_type));
+    }
+
+    /**
+     * @brief Gets the elements and length of an array, slice or one dimensional fixed size array of numbers
+     * 
+     * @param val what irgen gave for the array
+     * @param data 
+     * @param len 
+     * @return true 
+     * @return false if val isn't an array of numbers
+     */
+    bool getNumArrParts(llvm::Value *val, llvm::Value *&data, llvm::Value *&len) {
+        if(val->getType()->isPointerTy() && val->getType()->getPointerElementType()->isArrayTy()) {
+            auto arr_type = val->getType()->getPointerElementType();
+            data = Builder.CreateInBoundsGEP(val, {Builder.getInt64(0), Builder.getInt64(0)});
+            len = Builder.getInt64(arr_type->getArrayNumElements());
         } else {
-            return nullptr;
+            if(val->getType()->isPointerTy() && isArrType(val->getType()->getPointerElementType())) {
+                val = Builder.CreateLoad(val);
+            }
+
+            if(!isArrType(val->getType()) || isSoaArr(val->getType())) {
+                return false;
+            }
+
+            data = Builder.CreateExtractValue(val, 0);
+            len = Builder.CreateExtractValue(val, 1);
         }
+
+        return isNumType(data->getType()->getPointerElementType());
     }
 
-    llvm::Value *ObjExpAST::irgen() {
-        std::vector<llvm::Type*> types;
-        std::map<std::string, int> tname_map;
-        int type_num = 0;
-        for(auto type : object_attributes) {
-            tname_map[type.first] = type_num;
-            if(type.second.first == 0) {
-                types.push_back(llvm::Type::getDoubleTy(TheContext));
-            } else if(type.second.first == 1) {
-                types.push_back(llvm::Type::getInt8PtrTy(TheContext));
-            } else {
-                types.push_back(allocatedObjects[type.second.second].struct_ty);
+    /**
+     * @brief Checks what an expression is in element-wise array math
+     * 
+     * @param exp 
+     * @return int 1 when it uses whole arrays of numbers, 0 when it is a single value and -1 when it can't be done element-wise
+     */
+    int arrayExpKind(ExpAST *exp) {
+        if(auto bin = dynamic_cast<BinaryExpAST*>(exp)) {
+            int lhs = arrayExpKind(bin->LHS.get());
+            int rhs = arrayExpKind(bin->RHS.get());
+
+            if(lhs < 0 || rhs < 0 || ((lhs || rhs) && bin->op != "+" && bin->op != "-" && bin->op != "*" && bin->op != "/")) {
+                return -1;
             }
-            type_num++;
-        }
-        
-        auto newStruct = llvm::StructType::create(TheContext, object_name);
-        newStruct->setBody(types);
 
-        allocatedObjects[object_name] = {newStruct, llvm::PointerType::getUnqual(newStruct), tname_map};
-        
-        for(auto &func : functions) {
-            func->getProto()->appendArg({"this", {2, object_name}});
-            func->irgen();
+            return std::max(lhs, rhs);
+        } else if(auto ref = dynamic_cast<VariableRefExpAST*>(exp)) {
+            auto var = NamedValues.find(ref->getVarName());
+            auto type = var != NamedValues.end() ? var->second.type : nullptr;
+            if(type && (isArrType(type) || type->isArrayTy())) {
+                auto elem_type = isArrType(type) ? type->getStructElementType(0)->getPointerElementType() : type->getArrayElementType();
+                return isNumType(elem_type) ? 1 : -1;
+            }
+        } else if(auto call = dynamic_cast<CallExpAST*>(exp)) {
+            if(function_protos.count(call->getCallee()) && function_protos[call->getCallee()]->fn_type.first == array_ty) {
+                return -1;
+            }
+        } else if(dynamic_cast<ArrayLitAST*>(exp) || dynamic_cast<SliceAST*>(exp) || dynamic_cast<ArrayAccAST*>(exp)) {
+            return -1;
         }
 
-        return nullptr;
+        return 0;
     }
-    
-    llvm::Value *ReturnExpAST::irgen() {
-        return Builder.CreateRet(Ret_value->irgen());
+
+    /**
+     * @brief Checks if an expression is math on whole arrays, ex: a + b * 2.0
+     * 
+     * @param exp 
+     * @return true 
+     * @return false 
+     */
+    bool isArrayExp(ExpAST *exp) {
+        return dynamic_cast<BinaryExpAST*>(exp) && arrayExpKind(exp) == 1;
     }
 
-    llvm::Value *LoopExpAST::irgen() {
-        if(Cur_BB) {
-            auto *TheFunction = Builder.GetInsertBlock()->getParent();
-            auto *PreheaderBB = Builder.GetInsertBlock();
-            auto *LoopBB      = llvm::BasicBlock::Create(TheContext, "loop", TheFunction);
+    /**
+     * @brief Generates element-wise array math as one loop, which works on a vector of elements at a time and keeps no arrays in between.
+     * The arrays are used up to the length of the shortest one
+     * 
+     * @param exp 
+     * @param fixed_dest the fixed size array the result is written into, or nullptr for a new array
+     * @return llvm::Value* fixed_dest, or the {T*, i64} of the new array
+     */
+    llvm::Value *fuseArrayExp(ExpAST *exp, llvm::Value *fixed_dest) {
+        struct leaf {
+            llvm::Value *data = nullptr; // set for arrays
+            llvm::Value *val = nullptr; // set for single values
+            llvm::Value *lanes = nullptr; // the value in every lane of a vector
+        };
+
+        std::map<ExpAST *, leaf> leaves;
+        llvm::Type *elem_type = nullptr;
+        llvm::Value *len = nullptr;
+        bool is_unsigned = false;
+
+        // The arrays and single values are worked out once, before the loop
+        std::function<bool(ExpAST *)> collect = [&](ExpAST *node) {
+            if(auto bin = dynamic_cast<BinaryExpAST*>(node)) {
+                if(arrayExpKind(node) == 1) {
+                    return collect(bin->LHS.get()) && collect(bin->RHS.get());
+                }
+            }
 
-            Builder.CreateBr(LoopBB);
-            Builder.SetInsertPoint(LoopBB);
+            auto val = node->irgen();
+            if(!val) {
+                return false;
+            }
 
-            for(int i = 0; i < body.size(); i++)
-                body.at(i)->irgen();
+            if(arrayExpKind(node) == 0) {
+                leaves[node].val = val;
+                return true;
+            }
 
-            auto EndCond = condition->irgen();
-            EndCond = Builder.CreateFPToUI(EndCond, llvm::Type::getInt1Ty(TheContext));
+            llvm::Value *data, *arr_len;
+            if(!getNumArrParts(val, data, arr_len)) {
+                return false;
+            }
 
-            auto *LoopEndBB = Builder.GetInsertBlock();
-            auto *AfterBB = llvm::BasicBlock::Create(TheContext, "afterloop", TheFunction);
+            auto ref = dynamic_cast<VariableRefExpAST*>(node);
+            is_unsigned = is_unsigned || NamedValues[ref->getVarName()].peko_type.rfind("u8 ", 0) == 0;
 
-            Builder.CreateCondBr(EndCond, LoopBB, AfterBB);
-            Builder.SetInsertPoint(AfterBB);
+            if(elem_type && elem_type != data->getType()->getPointerElementType()) {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m element-wise math needs arrays of the same number type, but " + ref->getVarName() + " holds " + numTypeName(data->getType()->getPointerElementType(), false) + "s instead of " + numTypeName(elem_type, false) + "s");
+                return false;
+            }
 
-            for(int i = 0; i < cont.size(); i++) {
-               cont.at(i)->irgen();
+            elem_type = data->getType()->getPointerElementType();
+            len = len ? Builder.CreateSelect(Builder.CreateICmpULT(arr_len, len), arr_len, len) : arr_len;
+            leaves[node].data = data;
+            return true;
+        };
+
+        if(!collect(exp)) {
+            return nullptr;
+        }
+
+        llvm::Value *dest_data;
+        if(fixed_dest) {
+            auto arr_type = fixed_dest->getType()->getPointerElementType();
+            if(arr_type->getArrayElementType() != elem_type) {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m the result of element-wise math on " + numTypeName(elem_type, false) + "s can't be stored in an array of another type");
+                return nullptr;
             }
+
+            auto dest_len = Builder.getInt64(arr_type->getArrayNumElements());
+            len = Builder.CreateSelect(Builder.CreateICmpULT(dest_len, len), dest_len, len);
+            dest_data = Builder.CreateInBoundsGEP(fixed_dest, {Builder.getInt64(0), Builder.getInt64(0)});
         } else {
-            global_expressions.push_back(this);
+            dest_data = mallocArrData(elem_type, len);
         }
 
-        return nullptr;
-    }
-    
-    llvm::BasicBlock *CurrentInsertPoint = nullptr;
-    llvm::BasicBlock *createIfBranch(std::vector<llvm::BasicBlock*> eif_blocks, llvm::BasicBlock *e_block, llvm::BasicBlock *cont_block, int *x, std::vector<std::unique_ptr<IfExpAST>> eif) {
-        if(*x == (int)eif_blocks.size()-1) {
-            llvm::Function *TheFunction = Builder.GetInsertBlock()->getParent();
-            llvm::BasicBlock *newbb = llvm::BasicBlock::Create(TheContext, "condbb", TheFunction);
-            
-            auto CurInsPointBuf = CurrentInsertPoint;
-            CurrentInsertPoint = newbb;
-            
-            Builder.SetInsertPoint(newbb);
-            *x += 1;
-            Builder.CreateCondBr(eif.at(*x-1)->getCondition()->irgen(), eif_blocks.at(*x-1), createIfBranch(eif_blocks, e_block, cont_block, x, std::move(eif)));
-            
-            CurrentInsertPoint = CurInsPointBuf;
-            Builder.SetInsertPoint(CurrentInsertPoint);
-            return newbb;
-        } else if(*x <= (int)eif_blocks.size()-2) {
-            llvm::Function *TheFunction = Builder.GetInsertBlock()->getParent();
-            llvm::BasicBlock *newbb = llvm::BasicBlock::Create(TheContext, "condbb", TheFunction);
-            
-            auto CurInsPointBuf = CurrentInsertPoint;
-            CurrentInsertPoint = newbb;
-            
-            Builder.SetInsertPoint(newbb);
-            *x += 1;
-            Builder.CreateCondBr(eif.at(*x-1)->getCondition()->irgen(), eif_blocks.at(*x-1), createIfBranch(eif_blocks, e_block, cont_block, x, std::move(eif)));
-            
-            CurrentInsertPoint = CurInsPointBuf;
-            Builder.SetInsertPoint(CurrentInsertPoint);
-            return newbb;
-        } else if(e_block) {
-            return e_block;
-        } else {
-            return cont_block;
+        unsigned lanes = simdLanes(elem_type);
+        for(auto &l : leaves) {
+            if(l.second.val) {
+                l.second.val = castValue(l.second.val, elem_type);
+                l.second.lanes = Builder.CreateVectorSplat(lanes, l.second.val);
+            }
         }
-    }
 
-    llvm::BasicBlock *ContBB = nullptr;
-    llvm::Value *IfExpAST::irgen() {
-        if(Cur_BB) {
-            auto cond_gened = condition->irgen();
-            CurrentInsertPoint = Builder.GetInsertBlock();
-            auto CurInsPointBuf = CurrentInsertPoint;
-            
-            llvm::Function *TheFunction = Builder.GetInsertBlock()->getParent();
-            llvm::BasicBlock *IfBodyBB = llvm::BasicBlock::Create(TheContext, "body", TheFunction);
-            llvm::BasicBlock *MergeBB = llvm::BasicBlock::Create(TheContext, "ifcont", TheFunction);
-            
-            llvm::BasicBlock *ElseBB = nullptr;
-            if(els.size() > 0) {
-                ElseBB = llvm::BasicBlock::Create(TheContext, "else", TheFunction);
-                Builder.SetInsertPoint(ElseBB);
-                for(auto &ast : els) {
-                    ast->irgen();
-                    ASTS::resetObjRecVars();
+        std::function<llvm::Value *(ExpAST *, llvm::Value *, bool)> element = [&](ExpAST *node, llvm::Value *index, bool vector) -> llvm::Value * {
+            if(leaves.count(node)) {
+                auto &l = leaves[node];
+                if(l.data) {
+                    return vector ? loadLanes(l.data, index, lanes) : Builder.CreateLoad(Builder.CreateInBoundsGEP(l.data, index));
                 }
-                Builder.CreateBr(MergeBB);
-                Builder.SetInsertPoint(CurrentInsertPoint);
+                return vector ? l.lanes : l.val;
             }
 
-            Builder.SetInsertPoint(IfBodyBB);
-            
-            for(int i = 0; i < body.size(); i++)
-                body.at(i)->irgen();
+            auto bin = dynamic_cast<BinaryExpAST*>(node);
+            return numArith(bin->op, element(bin->LHS.get(), index, vector), element(bin->RHS.get(), index, vector), is_unsigned);
+        };
+
+        // Whole vectors first, then the elements left over one at a time
+        auto vec_end = Builder.CreateSub(len, Builder.CreateURem(len, Builder.getInt64(lanes)), "vecend");
+        countedLoop(Builder.getInt64(0), vec_end, lanes, {}, [&](llvm::Value *index, std::vector<llvm::Value *> &) {
+            storeLanes(element(exp, index, true), dest_data, index);
+            return std::vector<llvm::Value *>();
+        });
+        countedLoop(vec_end, len, 1, {}, [&](llvm::Value *index, std::vector<llvm::Value *> &) {
+            Builder.CreateStore(element(exp, index, false), Builder.CreateInBoundsGEP(dest_data, index));
+            return std::vector<llvm::Value *>();
+        });
+
+        if(fixed_dest) {
+            return fixed_dest;
+        }
 
-            Builder.CreateBr(MergeBB);
+        llvm::Value *arr = llvm::UndefValue::get(getArrType(elem_type, 1));
+        arr = Builder.CreateInsertValue(arr, dest_data, 0);
+        return Builder.CreateInsertValue(arr, len, 1);
+    }
 
-            //IfBodyBB = Builder.GetInsertBlock();
+    /**
+     * @brief Combines two values for a reduction, min and max of floats ignore NaNs like llvm's minnum and maxnum
+     * 
+     * @param kind sum, min, max or dot
+     * @param acc 
+     * @param val 
+     * @param is_unsigned 
+     * @return llvm::Value* 
+     */
+    llvm::Value *reduceStep(const std::string &kind, llvm::Value *acc, llvm::Value *val, bool is_unsigned) {
+        bool is_float = acc->getType()->isFPOrFPVectorTy();
 
-            std::vector<llvm::BasicBlock *> elseif_blocks = {};
+        if(kind == "sum" || kind == "dot") {
+            return is_float ? Builder.CreateFAdd(acc, val) : Builder.CreateAdd(acc, val);
+        } else if(is_float) {
+            return Builder.CreateBinaryIntrinsic(kind == "min" ? llvm::Intrinsic::minnum : llvm::Intrinsic::maxnum, acc, val);
+        }
 
-            for(auto &eif : els_if) {
-                auto newbb = llvm::BasicBlock::Create(TheContext, "elseif", TheFunction);
-                Builder.SetInsertPoint(newbb);
-                for(auto &ex : eif->body) {
-                    ex->irgen();
-                    ASTS::resetObjRecVars();
-                }
-                Builder.CreateBr(MergeBB);
-                elseif_blocks.push_back(newbb);
+        auto pred = kind == "min" ? (is_unsigned ? llvm::CmpInst::ICMP_ULT : llvm::CmpInst::ICMP_SLT) : (is_unsigned ? llvm::CmpInst::ICMP_UGT : llvm::CmpInst::ICMP_SGT);
+        return Builder.CreateSelect(Builder.CreateICmp(pred, acc, val), acc, val);
+    }
+
+    /**
+     * @brief Reduces the lanes of a vector to one value
+     * 
+     * @param kind 
+     * @param vec 
+     * @param is_unsigned 
+     * @return llvm::Value* 
+     */
+    llvm::Value *reduceLanes(const std::string &kind, llvm::Value *vec, bool is_unsigned) {
+        unsigned lanes = llvm::cast<llvm::FixedVectorType>(vec->getType())->getNumElements();
+        llvm::Value *acc = Builder.CreateExtractElement(vec, (uint64_t)0);
+
+        for(unsigned i = 1; i < lanes; i++) {
+            acc = reduceStep(kind, acc, Builder.CreateExtractElement(vec, (uint64_t)i), is_unsigned);
+        }
+
+        return acc;
+    }
+
+    /**
+     * @brief Generates the reductions sum(x), min(x), max(x) and dot(a, b) for vecs and arrays of numbers.
+     * Arrays are reduced a vector at a time, so a sum adds the numbers in a different order than a loop over them would.
+     * The sum of an empty array is 0, and its min and max are the largest and smallest number of the type
+     * 
+     * @param callee 
+     * @param args 
+     * @return llvm::Value* 
+     */
+    llvm::Value *reduceBuiltin(const std::string &callee, std::vector<std::unique_ptr<ExpAST>> &args) {
+        if(args.size() != (callee == "dot" ? 2 : 1)) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m " + callee + "(...) takes " + (callee == "dot" ? "2 arguments" : "1 argument") + ", but was given " + std::to_string(args.size()));
+            return nullptr;
+        }
+
+        std::vector<llvm::Value *> vals;
+        bool is_unsigned = false;
+        for(auto &arg : args) {
+            vals.push_back(isArrayExp(arg.get()) ? fuseArrayExp(arg.get(), nullptr) : arg->irgen());
+            if(!vals.back()) {
+                return nullptr;
             }
 
-            Builder.SetInsertPoint(MergeBB);
-            for(int i = 0; i < then.size(); i++) {
-                then.at(i)->irgen();
+            is_unsigned = is_unsigned || arg->is_unsigned;
+            if(auto ref = dynamic_cast<VariableRefExpAST*>(arg.get())) {
+                is_unsigned = is_unsigned || NamedValues[ref->getVarName()].peko_type.rfind("u8 ", 0) == 0;
             }
+        }
 
-            CurrentInsertPoint = CurInsPointBuf;
+        // A vec is reduced across its lanes
+        if(vals[0]->getType()->isVectorTy()) {
+            auto vec = vals[0];
+            if(callee == "dot") {
+                if(vals[1]->getType() != vec->getType()) {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m dot(...) needs two vecs of the same size");
+                    return nullptr;
+                }
+                vec = Builder.CreateFMul(vec, vals[1]);
+            }
 
-            Builder.SetInsertPoint(CurrentInsertPoint);
-            Builder.CreateAlloca(llvm::Type::getInt128Ty(TheContext), nullptr, "adsf");
+            return reduceLanes(callee, vec, false);
+        }
 
-            int x = 0;
-            Builder.CreateCondBr(cond_gened, IfBodyBB, createIfBranch(elseif_blocks, ElseBB, MergeBB, &x, std::move(els_if)));
-            
-            Builder.SetInsertPoint(MergeBB);
+        llvm::Value *data, *len, *other_data = nullptr, *other_len;
+        if(!getNumArrParts(vals[0], data, len) || (callee == "dot" && !getNumArrParts(vals[1], other_data, other_len))) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m " + callee + "(...) works on vecs and arrays of numbers");
+            return nullptr;
+        }
+
+        auto elem_type = data->getType()->getPointerElementType();
+        if(other_data) {
+            if(other_data->getType() != data->getType()) {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m dot(...) needs two arrays of the same number type");
+                return nullptr;
+            }
+            len = Builder.CreateSelect(Builder.CreateICmpULT(other_len, len), other_len, len);
+        }
+
+        // What the reduction starts from, so it doesn't change the result
+        llvm::Value *identity;
+        if(callee == "sum" || callee == "dot") {
+            identity = llvm::Constant::getNullValue(elem_type);
+        } else if(elem_type->isFloatingPointTy()) {
+            identity = llvm::ConstantFP::getInfinity(elem_type, callee == "max");
         } else {
-            global_expressions.push_back(this);
+            unsigned bits = elem_type->getIntegerBitWidth();
+            auto limit = callee == "min" ? (is_unsigned ? llvm::APInt::getMaxValue(bits) : llvm::APInt::getSignedMaxValue(bits)) : (is_unsigned ? llvm::APInt::getMinValue(bits) : llvm::APInt::getSignedMinValue(bits));
+            identity = llvm::ConstantInt::get(elem_type, limit);
         }
 
-        return nullptr;
-    }
+        auto element = [&](llvm::Value *index, bool vector, unsigned lanes) {
+            auto val = vector ? loadLanes(data, index, lanes) : Builder.CreateLoad(Builder.CreateInBoundsGEP(data, index));
+            if(other_data) {
+                auto other = vector ? loadLanes(other_data, index, lanes) : Builder.CreateLoad(Builder.CreateInBoundsGEP(other_data, index));
+                val = elem_type->isFloatingPointTy() ? Builder.CreateFMul(val, other) : Builder.CreateMul(val, other);
+            }
+            return val;
+        };
 
-    // Gives a value ref to a number
-    llvm::Value *NumberExpAST::irgen() {
-        return llvm::ConstantFP::get(TheContext, llvm::APFloat(value));
+        unsigned lanes = simdLanes(elem_type);
+        auto vec_end = Builder.CreateSub(len, Builder.CreateURem(len, Builder.getInt64(lanes)), "vecend");
+        auto acc = countedLoop(Builder.getInt64(0), vec_end, lanes, {Builder.CreateVectorSplat(lanes, identity)}, [&](llvm::Value *index, std::vector<llvm::Value *> &carried) {
+            return std::vector<llvm::Value *>{reduceStep(callee, carried[0], element(index, true, lanes), is_unsigned)};
+        });
+
+        auto result = countedLoop(vec_end, len, 1, {reduceLanes(callee, acc[0], is_unsigned)}, [&](llvm::Value *index, std::vector<llvm::Value *> &carried) {
+            return std::vector<llvm::Value *>{reduceStep(callee, carried[0], element(index, false, 1), is_unsigned)};
+        });
+
+        return result[0];
     }
 
-    // Gives a value ref to a string
-    llvm::Value *StringExpAST::irgen() {
-        return Builder.CreateGlobalStringPtr(llvm::StringRef(value));
-    }
+    /**
+     * @brief Generates the math builtins as llvm intrinsics, so they can be folded, vectorized and scheduled like the operators.
+     * They work on any number type and on vecs a lane at a time, number literals take the type of the other arguments.
+     * abs, min, max, floor, ceil, round and trunc keep integers as integers, the rest work on them as numbers
+     *
+     * @param callee
+     * @param args
+     * @param is_unsigned set if the result is a u8
+     * @return llvm::Value*
+     */
+    llvm::Value *mathBuiltin(const std::string &callee, std::vector<std::unique_ptr<ExpAST>> &args, bool &is_unsigned) {
+        int arity = mathArity(callee);
+        if(args.size() != arity) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m " + callee + "(...) takes " + std::to_string(arity) + (arity == 1 ? " argument" : " arguments") + ", but was given " + std::to_string(args.size()));
+            return nullptr;
+        }
+
+        std::vector<llvm::Value *> vals;
+        llvm::Type *type = nullptr;
+        is_unsigned = false;
+        for(auto &arg : args) {
+            auto val = arg->irgen();
+            if(!val) {
+                return nullptr;
+            }
+
+            if(!isNumType(val->getType()) && !val->getType()->isVectorTy()) {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m " + callee + "(...) works on numbers and vecs");
+                return nullptr;
+            }
+
+            bool literal = llvm::isa<llvm::ConstantFP>(val) && val->getType()->isDoubleTy();
+            if(val->getType()->isVectorTy() || (!type && !literal)) {
+                type = val->getType();
+                is_unsigned = arg->is_unsigned;
+            }
 
-    // Returns the reference to a variable
-    llvm::Value *VariableRefExpAST::irgen() {
-        // Look this variable up in the function.
-        auto var = NamedValues[var_name]; 
-        if (!var.val) {
-            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m undefined variable reference: " + var_name);
-            return nullptr;
+            vals.push_back(val);
         }
-            
-        if(var.global == true && var.type == llvm::Type::getInt8PtrTy(TheContext)) {                
-            return Builder.CreateLoad(TheModule->getNamedGlobal(var_name));
-        } else if(var.type == llvm::Type::getInt8PtrTy(TheContext) || var.type == llvm::Type::getDoubleTy(TheContext)) {
-            return Builder.CreateLoad(var.val);
-        } else {
-            return var.val;
+
+        if(!type) {
+            type = Builder.getDoubleTy();
         }
-    
-        return nullptr;
-    }
 
-    // Parse a Binary expression
-    llvm::Value *BinaryExpAST::irgen() {
-        // Retrieve the llvm::Value of the left hand and right hand sides
-        llvm::Value *L = LHS->irgen();
-        ASTS::resetObjRecVars();
+        for(auto &val : vals) {
+            if(val->getType()->isVectorTy() && val->getType() != type) {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m " + callee + "(...) needs vecs of the same size");
+                return nullptr;
+            }
 
-        llvm::Value *R = RHS->irgen();
-        ASTS::resetObjRecVars();
+            val = castValue(val, type);
+        }
 
-        // If either of the sides return null, than this expression tree is invalid
-        if (!L || !R)
-            return nullptr;
+        // Integers only stay integers where the result is always a whole number
+        bool int_op = callee == "abs" || callee == "min" || callee == "max" || callee == "floor" || callee == "ceil" || callee == "round" || callee == "trunc";
+        if(type->isIntegerTy() && int_op) {
+            if(callee == "min" || callee == "max") {
+                return reduceStep(callee, vals[0], vals[1], is_unsigned);
+            } else if(callee == "abs" && !is_unsigned) {
+                return Builder.CreateBinaryIntrinsic(llvm::Intrinsic::abs, vals[0], Builder.getFalse(), nullptr, "abstmp");
+            }
 
-        // Generate the proper IR for the instruction
-        if(op == "+") {
-            if(L->getType() == llvm::Type::getInt8PtrTy(TheContext) && R->getType() == llvm::Type::getInt8PtrTy(TheContext))
-                return Builder.CreateCall(TheModule->getFunction("addstr"), (std::vector<llvm::Value *>){L, R}, "calltmp");
-            else
-                return Builder.CreateFAdd(L, R, "addtmp");
-        } else if(op == "-") {
-            return Builder.CreateFSub(L, R, "subtmp");
-        } else if(op == "*") {
-            if(L->getType() == llvm::Type::getInt8PtrTy(TheContext) && R->getType() == llvm::Type::getDoubleTy(TheContext))
-                return Builder.CreateCall(TheModule->getFunction("mulstr"), (std::vector<llvm::Value *>){L, R}, "calltmp");
-            else
-                return Builder.CreateFMul(L, R, "multmp");
-        } else if(op == "<") {
-            // Convert bool 0/1 to double 0.0 or 1.0
-            return Builder.CreateFCmpULT(L, R, "cmptmp");
-        } else if(op == ">") {
-            // Convert bool 0/1 to double 0.0 or 1.0
-            return Builder.CreateFCmpUGT(L, R, "cmptmp");
-        } else if(op == "/") {
-           return Builder.CreateFDiv(L, R, "divtmp");
-        } else if(op == "%") {
-           return Builder.CreateCall(TheModule->getFunction("modnum"), (std::vector<llvm::Value *>){L, R}, "calltmp");
-        } else if(op == "==") {
-            if(L->getType() == llvm::Type::getInt8PtrTy(TheContext) && R->getType() == llvm::Type::getInt8PtrTy(TheContext)) {
-                return Builder.CreateFPToUI(Builder.CreateCall(TheModule->getFunction("cmpstr"), {L, R}, "added"), llvm::Type::getInt1Ty(TheContext));
-            } else
-                return Builder.CreateFCmpUEQ(L, R, "eqtmp");
-        } else if(op == "and") {
-            return Builder.CreateAnd(L, R, "andtmp");
-        } else if(op == "or") {
-            return Builder.CreateOr(L, R, "ortmp");
-        } else {
-            return nullptr;
+            return vals[0];
+        } else if(type->isIntegerTy()) {
+            for(auto &val : vals) {
+                val = convertNum(val, Builder.getDoubleTy(), is_unsigned, false);
+            }
+            is_unsigned = false;
+        }
+
+        if(callee == "min" || callee == "max") {
+            return reduceStep(callee, vals[0], vals[1], false);
+        } else if(callee == "pow") {
+            return Builder.CreateBinaryIntrinsic(llvm::Intrinsic::pow, vals[0], vals[1], nullptr, "powtmp");
+        } else if(callee == "fma") {
+            return Builder.CreateIntrinsic(llvm::Intrinsic::fma, {vals[0]->getType()}, vals, nullptr, "fmatmp");
         }
+
+        std::map<std::string, llvm::Intrinsic::ID> unary = {
+            {"sqrt", llvm::Intrinsic::sqrt}, {"abs", llvm::Intrinsic::fabs}, {"exp", llvm::Intrinsic::exp}, {"log", llvm::Intrinsic::log},
+            {"sin", llvm::Intrinsic::sin}, {"cos", llvm::Intrinsic::cos}, {"floor", llvm::Intrinsic::floor}, {"ceil", llvm::Intrinsic::ceil},
+            {"round", llvm::Intrinsic::round}, {"trunc", llvm::Intrinsic::trunc}
+        };
+        return Builder.CreateUnaryIntrinsic(unary[callee], vals[0], nullptr, callee + "tmp");
     }
 
     // Call an expression
     llvm::Value *CallExpAST::irgen() {
         if(Cur_BB && !inVarExp) {
+            // A vec is made from a number for every lane, or one number for all of them, ex: vec4(1, 2, 3, 4)
+            if(auto *vec_type = llvm::dyn_cast_or_null<llvm::FixedVectorType>(getNumType(callee))) {
+                if(args.size() != 1 && args.size() != vec_type->getNumElements()) {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m " + callee + "(...) takes 1 or " + std::to_string(vec_type->getNumElements()) + " numbers, but was given " + std::to_string(args.size()));
+                    return nullptr;
+                }
+
+                llvm::Value *vec = llvm::UndefValue::get(vec_type);
+                for(int i = 0; i < args.size(); i++) {
+                    auto val = args[i]->irgen();
+                    if(!val) {
+                        return nullptr;
+                    }
+
+                    if(args.size() == 1) {
+                        return castValue(val, vec_type);
+                    }
+
+                    vec = Builder.CreateInsertElement(vec, castValue(val, vec_type->getElementType()), (uint64_t)i);
+                }
+
+                return vec;
+            }
+
+            // A number type called like a function converts its argument to it, ex: f32(x)
+            if(auto *num_type = getNumType(callee)) {
+                if(args.size() != 1) {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m " + callee + "(...) converts one value, but was given " + std::to_string(args.size()));
+                    return nullptr;
+                }
+
+                auto val = args[0]->irgen();
+                if(!val) {
+                    return nullptr;
+                }
+
+                is_unsigned = callee == "u8";
+                if(val->getType()->isIntegerTy(1)) {
+                    return castValue(val, num_type);
+                } else if(!isNumType(val->getType())) {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m only numbers and bools can be converted with " + callee + "(...)");
+                    return nullptr;
+                }
+
+                return convertNum(val, num_type, args[0]->is_unsigned, is_unsigned);
+            }
+
+            if((callee == "len" || callee == "find" || callee == "split") && !function_protos.count(callee)) {
+                return textBuiltin(callee, args);
+            }
+
+            if(mathArity(callee) && !(args.size() == 1 && (callee == "min" || callee == "max")) && !function_protos.count(callee)) {
+                if(auto folded = constFold(this)) {
+                    return folded;
+                }
+
+                return mathBuiltin(callee, args, is_unsigned);
+            }
+
+            if((callee == "sum" || callee == "min" || callee == "max" || callee == "dot") && !function_protos.count(callee)) {
+                return reduceBuiltin(callee, args);
+            }
+
+            is_unsigned = function_protos.count(callee) && function_protos[callee]->fn_type.second == "u8";
+
+            // A const fn given constant arguments is run by the compiler, and the call becomes its result
+            if(function_protos.count(callee) && function_protos[callee]->const_fn) {
+                if(auto folded = constFold(this)) {
+                    return folded;
+                }
+            }
+
             // Look up the name in the global module table.
             llvm::Function *CalleeF = TheModule->getFunction(callee);
 
+            // Functions defined later are declared now and get their body when they are reached, methods are declared with their object
+            if (!CalleeF && callee.find(".") == std::string::npos && function_protos.count(callee)) {
+                CalleeF = function_protos[callee]->irgen();
+            }
+
             // If the function doesn't exist, then we return null
             if (!CalleeF) {
                 return nullptr;
             }
             
+            bool sret = CalleeF->hasStructRetAttr();
+
             // If argument sizes don't match
-            if (CalleeF->arg_size() != args.size() && (callee.find(".") == std::string::npos)) {
+            if (CalleeF->arg_size() != args.size() + sret && (callee.find(".") == std::string::npos)) {
                 return nullptr;
             }
 
             // Convert the arguments into llvm::Values
             std::vector<llvm::Value *> ArgsV;
 
+            // A returned object goes into the destination if there is one, or a temporary in the entry block
+            if (sret) {
+                if (!sret_dest) {
+                    auto *TheFunction = Builder.GetInsertBlock()->getParent();
+                    llvm::IRBuilder<> TmpB(&TheFunction->getEntryBlock(), TheFunction->getEntryBlock().begin());
+                    sret_dest = TmpB.CreateAlloca(CalleeF->getParamStructRetType(0), 0, "rettmp");
+                }
+
+                ArgsV.push_back(sret_dest);
+            }
+
             for (int i = 0; i < args.size(); i++) {
                 auto cur_arg_val = args[i]->irgen();
-                
-                ArgsV.push_back(cur_arg_val);
 
-                if (!ArgsV.back()) {
+                if (!cur_arg_val) {
                     return nullptr;
                 }
+
+                // A strview is printed straight from the string it points into
+                llvm::Value *text_ptr, *text_len;
+                if (callee == "printstr" && cur_arg_val->getType() != llvm::Type::getInt8PtrTy(TheContext) && getTextParts(cur_arg_val, text_ptr, text_len)) {
+                    return Builder.CreateCall(TheModule->getFunction("printview"), {text_ptr, text_len}, "calltmp");
+                }
+
+                if (i + sret < CalleeF->getFunctionType()->getNumParams()) {
+                    cur_arg_val = castValue(cur_arg_val, CalleeF->getFunctionType()->getParamType(i + sret));
+                }
+                
+                ArgsV.push_back(cur_arg_val);
             }
 
             for(int i = 0; i < argsv_extra.size(); i++) {
                 ArgsV.push_back(argsv_extra[i]);
             }
 
+            if (sret) {
+                last_call = Builder.CreateCall(CalleeF, ArgsV);
+                last_call->setCallingConv(CalleeF->getCallingConv());
 
+                auto dest = sret_dest;
+                sret_dest = nullptr;
+                return dest;
+            }
+
+            // The call has to use the same calling convention as the function or llvm treats it as unreachable
+            llvm::CallInst *call;
             if(CalleeF->getReturnType() == llvm::Type::getVoidTy(TheContext)) {
-                return Builder.CreateCall(CalleeF, ArgsV);
+                call = Builder.CreateCall(CalleeF, ArgsV);
             } else {
-                return Builder.CreateCall(CalleeF, ArgsV, "calltmp");
+                call = Builder.CreateCall(CalleeF, ArgsV, "calltmp");
             }
+
+            call->setCallingConv(CalleeF->getCallingConv());
+            last_call = call;
+            return call;
         } else {
             global_expressions.push_back(this);
             return nullptr;
         }
     }
     
-    ExpAST *prev_arr_ast = nullptr;
-    llvm::Value *prev_arr_value = nullptr;
-    ExpAST *arr_lhs_buf = nullptr;
-    ExpAST *arr_rhs_buf = nullptr;
-    int arracc_depth = 0;
+    /**
+     * @brief Flattens the chain of ArrayAccASTs on the right of an array access into its indices
+     * 
+     * @param acc the right hand side of the array access
+     * @param indices gets every index that is accessed
+     * @return VariableExpAST* the value being assigned to the last index, or nullptr if the access is a read
+     */
+    VariableExpAST *getArrAccIndices(ExpAST *acc, std::vector<int> &indices) {
+        while(acc) {
+            if(!strcmp(acc->getType(), "number")) {
+                indices.push_back((int)dynamic_cast<NumberExpAST*>(acc)->getVal());
+                return nullptr;
+            } else if(!strcmp(acc->getType(), "variable")) {
+                // An assignment stores its index in the name of the variable
+                auto acc_to_var = dynamic_cast<VariableExpAST*>(acc);
+                indices.push_back(stoi(acc_to_var->getName()));
+                return acc_to_var;
+            } else if(!strcmp(acc->getType(), "array_acc")) {
+                auto acc_to_arr = dynamic_cast<ArrayAccAST*>(acc);
+
+                // The index of an assignment is held by the variable on the right, not the number on the left
+                if(!acc_to_arr->GetRHS() || strcmp(acc_to_arr->GetRHS()->getType(), "variable")) {
+                    indices.push_back((int)dynamic_cast<NumberExpAST*>(acc_to_arr->GetLHS())->getVal());
+                }
+
+                acc = acc_to_arr->GetRHS();
+            } else {
+                return nullptr;
+            }
+        }
 
-    void resetArrRecVars() {
-        prev_arr_ast = nullptr;
-        prev_arr_value = nullptr;
-        arr_lhs_buf = nullptr;
-        arr_rhs_buf = nullptr;
-        arracc_depth = 0;
+        return nullptr;
     }
 
-    std::vector<int> sizes_tmp;
     llvm::Value *ArrayAccAST::irgen() {
-        if(!prev_arr_ast && !prev_arr_value && !arr_lhs_buf && !arr_rhs_buf) {
-            arr_lhs_buf = LHS.get();
-            arr_rhs_buf = RHS.get();
-            if(!strcmp(arr_lhs_buf->getType(), "id")) {
-                auto l_buf_to_id = dynamic_cast<IdHolder*>(arr_lhs_buf);
-                prev_arr_value = NamedValues[l_buf_to_id->getId()].val;
+        if(strcmp(LHS->getType(), "id")) {
+            return nullptr;
+        }
+
+        auto lhs_to_id = dynamic_cast<IdHolder*>(LHS.get());
+        initGlobalOnUse(lhs_to_id->getId());
+        llvm::Value *arr = NamedValues[lhs_to_id->getId()].val;
+
+        if(!arr) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m undefined variable reference: " + lhs_to_id->getId());
+            return nullptr;
+        }
+
+        std::vector<int> indices;
+        auto assign = getArrAccIndices(RHS.get(), indices);
+
+        if(indices.empty()) {
+            return nullptr;
+        }
+
+        // Fixed size arrays are indexed straight into their memory, and the sizes are known so indices are checked now
+        if(NamedValues[lhs_to_id->getId()].type->isArrayTy()) {
+            is_unsigned = NamedValues[lhs_to_id->getId()].peko_type.rfind("u8 ", 0) == 0;
+            last_arr = nullptr;
+
+            std::vector<llvm::Value *> gep_indices = {Builder.getInt64(0)};
+            llvm::Type *elem_type = NamedValues[lhs_to_id->getId()].type;
+            for(auto index : indices) {
+                if(!elem_type->isArrayTy() || index < 0 || index >= elem_type->getArrayNumElements()) {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m index " + std::to_string(index) + " is out of bounds of " + lhs_to_id->getId());
+                    return nullptr;
+                }
+
+                gep_indices.push_back(Builder.getInt64(index));
+                elem_type = elem_type->getArrayElementType();
             }
 
-            prev_arr_ast = arr_lhs_buf;
-            arr_lhs_buf = arr_rhs_buf;
+            auto element = Builder.CreateInBoundsGEP(arr, gep_indices);
 
-            arracc_depth++;
-            return this->irgen();
-        } else if(!strcmp(arr_lhs_buf->getType(), "number")) {
-            auto l_buf_to_number = dynamic_cast<NumberExpAST*>(arr_lhs_buf);
-            
-            auto element = getElementAtIndex(prev_arr_value, (int)l_buf_to_number->getVal());
+            if(assign) {
+                auto val = assign->getVAST()->irgen();
+                if(val) {
+                    Builder.CreateStore(castValue(loadIfAggregatePtr(val), elem_type), element);
+                }
+
+                return nullptr;
+            }
+
+            // Objects and rows are handed out as a pointer, like with growable arrays
+            if(elem_type->isStructTy() || elem_type->isArrayTy()) {
+                return element;
+            }
 
-            
-            resetArrRecVars();
             return Builder.CreateLoad(element);
-        } else if(!strcmp(arr_lhs_buf->getType(), "variable")) {
-            auto l_buf_to_var = dynamic_cast<VariableExpAST*>(arr_lhs_buf);
-
-            if(l_buf_to_var->getVAST()->getType() == "arr_lit") {
-                auto arr = prev_arr_value;
-                auto lbuf_to_arr_lit = dynamic_cast<ArrayLitAST*>(l_buf_to_var->getVAST());
-                auto lbuf_arr = lbuf_to_arr_lit->irgen();
-
-                int arrsize = sizes_tmp[arracc_depth];
-                for(int size = 0; size < lbuf_to_arr_lit->getSize(); size++) {
-                    if(size < arrsize) {
-                        setElementAtIndex(arr, size, lbuf_to_arr_lit->getElement(size)->irgen());
-                    } else {
-                        appElement(arr, lbuf_to_arr_lit->getElement(size)->irgen(), size);
-                    }
+        }
+
+        // A vec is indexed by its lanes, ex: v[2]
+        if(auto vec_type = llvm::dyn_cast<llvm::FixedVectorType>(NamedValues[lhs_to_id->getId()].type)) {
+            if(indices.size() != 1 || indices[0] < 0 || indices[0] >= vec_type->getNumElements()) {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m index " + std::to_string(indices.back()) + " is out of bounds of " + lhs_to_id->getId());
+                return nullptr;
+            }
+
+            auto vec = NamedValues[lhs_to_id->getId()].is_value ? arr : Builder.CreateLoad(arr);
+            if(assign) {
+                auto val = assign->getVAST()->irgen();
+                if(val) {
+                    Builder.CreateStore(Builder.CreateInsertElement(vec, castValue(val, vec_type->getElementType()), (uint64_t)indices[0]), arr);
                 }
-            } else {
-                setElementAtIndex(prev_arr_value, stoi(l_buf_to_var->getName()), l_buf_to_var->getVAST()->irgen());
+
+                return nullptr;
             }
-            resetArrRecVars();
-            return nullptr;
-        } else if(!strcmp(arr_lhs_buf->getType(), "array_acc")) {
-            auto lbuf_to_acc = dynamic_cast<ArrayAccAST*>(arr_lhs_buf);
 
-            arr_lhs_buf = lbuf_to_acc->GetLHS();
-            arr_rhs_buf = lbuf_to_acc->GetRHS();
+            return Builder.CreateExtractElement(vec, (uint64_t)indices[0]);
+        }
+
+        // Walk down to the array that holds the last index
+        for(int i = 0; i < indices.size() - 1; i++) {
+            arr = getElementAtIndex(arr, indices[i]);
+        }
 
+        last_arr = arr;
+        last_index = indices.back();
+        // u8 arrays and slices, strviews included since their type is u8 .., hand out unsigned elements
+        is_unsigned = NamedValues[lhs_to_id->getId()].peko_type.rfind("u8 ", 0) == 0;
 
-            auto lbuf_to_num = dynamic_cast<NumberExpAST*>(arr_lhs_buf);
+        if(assign) {
+            auto val = assign->getVAST()->irgen();
+            if(val) {
+                auto elem_type = arr->getType()->getPointerElementType()->getStructElementType(0)->getPointerElementType();
 
-            if(arr_rhs_buf) {
-                prev_arr_value = getElementAtIndex(prev_arr_value, (int)lbuf_to_num->getVal());
-                prev_arr_ast = arr_lhs_buf;
-                arr_lhs_buf = arr_rhs_buf;
-                arracc_depth++;
-                return this->irgen();
-            } else {
-                resetArrRecVars();
-                return Builder.CreateLoad(getElementAtIndex(prev_arr_value, (int)lbuf_to_num->getVal()));
+                // A slice can't grow, its memory belongs to what it was sliced from
+                if(isSliceName(NamedValues[lhs_to_id->getId()].peko_type)) {
+                    Builder.CreateStore(loadIfAggregatePtr(castValue(val, elem_type)), getElementAtIndex(arr, indices.back()));
+                } else {
+                    setElementAtIndex(arr, indices.back(), castValue(val, elem_type));
+                }
             }
             
+            return nullptr;
+        }
+
+        auto element = getElementAtIndex(arr, indices.back());
+
+        // Objects and rows are handed out as a pointer to the element instead of a copy
+        if(element->getType()->getPointerElementType()->isStructTy()) {
+            return element;
+        }
+        
+        return Builder.CreateLoad(element);
+    }
+
+    /**
+     * @brief Objects in a struct of arrays array are accessed through a copy, so changes to the copy are stored back into the columns
+     * 
+     * @param elem the pointer that was returned by irgen
+     */
+    void ArrayAccAST::writeBack(llvm::Value *elem) {
+        if(last_arr && isSoaArr(last_arr->getType()->getPointerElementType())) {
+            soaScatter(Builder.CreateLoad(last_arr), getArrElementIndex(last_index), elem);
+        }
+    }
+
+    llvm::Value *ArrayLitAST::irgen() {
+        if(elements.empty()) {
+            return nullptr;
+        }
+
+        std::vector<llvm::Value *> elem_vals;
+        for(auto &element : elements) {
+            auto inner = dynamic_cast<ArrayLitAST*>(element.get());
+            if(inner && elem_type && isArrType(elem_type)) {
+                inner->elem_type = elem_type->getStructElementType(0)->getPointerElementType();
+            }
+
+            auto cur_elem = element->irgen();
+            if(!cur_elem) {
+                return nullptr;
+            }
+
+            cur_elem = loadIfAggregatePtr(cur_elem);
+            elem_vals.push_back(elem_type ? castValue(cur_elem, elem_type) : cur_elem);
+        }
+
+        // A literal of constants, or of rows of constants, is kept in a read only global
+        auto elem_type = elem_vals[0]->getType();
+        std::vector<llvm::Constant *> const_elems;
+        for(int i = 0; i < elem_vals.size(); i++) {
+            auto inner = dynamic_cast<ArrayLitAST*>(elements[i].get());
+            auto const_elem = inner ? inner->const_val : llvm::dyn_cast<llvm::Constant>(elem_vals[i]);
+            if(!const_elem || const_elem->getType() != elem_type) {
+                break;
+            }
+
+            const_elems.push_back(const_elem);
+        }
+
+        llvm::GlobalVariable *global = nullptr;
+        const_val = nullptr;
+        if(const_elems.size() == elem_vals.size()) {
+            auto global_type = llvm::ArrayType::get(elem_type, elem_vals.size());
+            global = new llvm::GlobalVariable(*TheModule, global_type, true, llvm::GlobalValue::PrivateLinkage, llvm::ConstantArray::get(global_type, const_elems), "arrlit");
+            global->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+            global->setAlignment(TheModule->getDataLayout().getABITypeAlign(elem_type));
+
+            auto global_data = llvm::ConstantExpr::getInBoundsGetElementPtr(global_type, global, (llvm::ArrayRef<llvm::Constant *>){Builder.getInt64(0), Builder.getInt64(0)});
+            const_val = llvm::ConstantStruct::get(getArrType(elem_type, 1), {global_data, Builder.getInt64(elem_vals.size())});
+        }
+
+        // Allocate the whole buffer at once and then fill it
+        auto data = mallocArrData(elem_type, getArrElementIndex(elem_vals.size()));
+
+        // The buffer is moved to the stack once the function is generated if it never escapes
+        if(auto *buffer = llvm::dyn_cast<llvm::CallInst>(llvm::cast<llvm::Instruction>(data)->getOperand(0))) {
+            arr_lit_mallocs.push_back({buffer, elem_vals.size()});
+        }
+
+        std::vector<llvm::Instruction *> init;
+        if(global && !isArrType(elem_type)) {
+            // The rows of a nested literal each need a buffer of their own, so only flat literals are copied at once
+            auto &DL = TheModule->getDataLayout();
+            init.push_back(Builder.CreateMemCpy(data, DL.getABITypeAlign(elem_type), global, DL.getABITypeAlign(elem_type), DL.getTypeAllocSize(global->getValueType())));
+        } else {
+            for(int i = 0; i < elem_vals.size(); i++) {
+                init.push_back(Builder.CreateStore(elem_vals[i], Builder.CreateGEP(data, getArrElementIndex(i))));
+            }
+        }
+
+        if(global) {
+            const_arr_lits.push_back({llvm::cast<llvm::Instruction>(data), const_val->getAggregateElement(0u), init});
+        }
+
+        llvm::Value *arr = llvm::UndefValue::get(getArrType(elem_type, 1));
+        arr = Builder.CreateInsertValue(arr, data, 0);
+        arr = Builder.CreateInsertValue(arr, getArrElementIndex(elem_vals.size()), 1);
+
+        return arr;
+    }
+
+    /**
+     * @brief Takes a slice of a string or an array, which points into its memory instead of copying it.
+     * Growing the array moves its memory, so slices taken before then are left pointing at the old memory
+     * 
+     * @return llvm::Value* the {T*, i64} of the slice
+     */
+    llvm::Value *SliceAST::irgen() {
+        initGlobalOnUse(var_name);
+        auto var = NamedValues[var_name];
+        if(!var.val) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m undefined variable reference: " + var_name);
+            return nullptr;
+        }
+
+        llvm::Value *data, *len;
+        if(var.type == llvm::Type::getInt8PtrTy(TheContext)) {
+            // A slice of a string is a strview
+            data = var.is_value ? var.val : Builder.CreateLoad(var.val);
+            len = Builder.CreateCall(TheModule->getFunction("strlen"), {data}, "strlen");
+            peko_type = "u8 ..";
+        } else if(var.type->isArrayTy() && !var.type->getArrayElementType()->isArrayTy()) {
+            data = Builder.CreateInBoundsGEP(var.val, {Builder.getInt64(0), Builder.getInt64(0)});
+            len = Builder.getInt64(var.type->getArrayNumElements());
+            peko_type = var.peko_type.substr(0, var.peko_type.rfind(" ")) + " ..";
+        } else if(isArrType(var.type) && !isSoaArr(var.type)) {
+            auto arr_val = Builder.CreateLoad(var.val);
+            data = Builder.CreateExtractValue(arr_val, 0);
+            len = Builder.CreateExtractValue(arr_val, 1);
+            peko_type = var.peko_type.substr(0, var.peko_type.rfind(" ")) + " ..";
+        } else {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m only strings, arrays and one dimensional fixed size arrays can be sliced: " + var_name + "[..]");
+            return nullptr;
+        }
+
+        // The start and end are indices, ex: s[i..j] has the elements from i up to but not including j
+        llvm::Value *bounds[2] = {Builder.getInt64(0), len};
+        ExpAST *bound_exps[2] = {start.get(), end.get()};
+        for(int i = 0; i < 2; i++) {
+            if(!bound_exps[i]) {
+                continue;
+            }
+
+            auto bound = bound_exps[i]->irgen();
+            if(!bound || !isNumType(bound->getType())) {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m the start and end of a slice of " + var_name + " have to be numbers");
+                return nullptr;
+            }
+
+            bounds[i] = convertNum(bound, Builder.getInt64Ty(), bound_exps[i]->is_unsigned, false);
+        }
+
+        // Bounds that are known now are checked now, like the indices of fixed size arrays
+        auto const_start = llvm::dyn_cast<llvm::ConstantInt>(bounds[0]);
+        auto const_end = llvm::dyn_cast<llvm::ConstantInt>(bounds[1]);
+        auto const_len = llvm::dyn_cast<llvm::ConstantInt>(len);
+        if(const_start && const_start->isNegative()) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m the start of a slice of " + var_name + " is below 0");
+            return nullptr;
+        } else if(const_start && const_end && const_start->getSExtValue() > const_end->getSExtValue()) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m the start of a slice of " + var_name + " is after its end");
+            return nullptr;
+        } else if(const_end && const_len && const_end->getSExtValue() > const_len->getSExtValue()) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m the end of a slice of " + var_name + " is past the length of " + var_name);
+            return nullptr;
+        }
+
+        // Bounds that are only known when the program runs are clamped into the collection, so the slice never reaches
+        // outside of it: the start goes between 0 and the length, and the end between the start and the length
+        auto zero = Builder.getInt64(0);
+        bounds[0] = Builder.CreateSelect(Builder.CreateICmpSLT(bounds[0], zero), zero, bounds[0]);
+        bounds[0] = Builder.CreateSelect(Builder.CreateICmpSGT(bounds[0], len), len, bounds[0], "slicestart");
+        bounds[1] = Builder.CreateSelect(Builder.CreateICmpSGT(bounds[1], len), len, bounds[1]);
+        bounds[1] = Builder.CreateSelect(Builder.CreateICmpSLT(bounds[1], bounds[0]), bounds[0], bounds[1], "sliceend");
+
+        llvm::Value *slice = llvm::UndefValue::get(getArrType(data->getType()->getPointerElementType(), 1));
+        slice = Builder.CreateInsertValue(slice, Builder.CreateInBoundsGEP(data, bounds[0]), 0);
+        slice = Builder.CreateInsertValue(slice, Builder.CreateSub(bounds[1], bounds[0], "slicelen"), 1);
 
+        return slice;
+    }
+
+    /**
+     * @brief Returns true if an expression gives a slice, which would be freed or grown in place if a growable array held it
+     * 
+     * @param exp 
+     * @return true 
+     * @return false 
+     */
+    bool isSliceExp(ExpAST *exp) {
+        if(auto ref = dynamic_cast<VariableRefExpAST*>(exp)) {
+            return isSliceName(NamedValues[ref->getVarName()].peko_type);
+        } else if(auto call = dynamic_cast<CallExpAST*>(exp)) {
+            return function_protos.count(call->getCallee()) && isSliceName(function_protos[call->getCallee()]->fn_type.second);
+        }
+
+        return dynamic_cast<SliceAST*>(exp) != nullptr;
+    }
+
+    /**
+     * @brief Works out the starting value of a global while compiling, so it's part of the program instead of being stored when it runs
+     *
+     * @param exp
+     * @param type the llvm type of the global
+     * @return llvm::Constant* nullptr when the value needs code to run, ex: adding two strings calls addstr
+     */
+    llvm::Constant *constGlobalValue(ExpAST *exp, llvm::Type *type) {
+        auto lit = dynamic_cast<ArrayLitAST*>(exp);
+
+        if(type->isArrayTy()) {
+            if(!lit || lit->getSize() > type->getArrayNumElements()) {
+                return nullptr;
+            }
+
+            std::vector<llvm::Constant *> elems;
+            for(int i = 0; i < lit->getSize(); i++) {
+                elems.push_back(constGlobalValue(lit->getElement(i), type->getArrayElementType()));
+                if(!elems.back()) {
+                    return nullptr;
+                }
+            }
+
+            elems.resize(type->getArrayNumElements(), llvm::Constant::getNullValue(type->getArrayElementType()));
+            return llvm::ConstantArray::get(llvm::cast<llvm::ArrayType>(type), elems);
+        }
+
+        // A string is made with the builder, which needs a block, so it's given one in a function that is thrown away
+        auto *SavedBB = Builder.GetInsertBlock();
+        auto *ScratchF = llvm::Function::Create(llvm::FunctionType::get(Builder.getVoidTy(), false), llvm::Function::PrivateLinkage, "constexp", TheModule.get());
+        Builder.SetInsertPoint(llvm::BasicBlock::Create(TheContext, "entry", ScratchF));
+
+        llvm::Value *val = constFold(exp);
+        if(val) {
+            val = castValue(val, type);
+        }
+
+        auto result = llvm::dyn_cast_or_null<llvm::Constant>(val);
+        arr_lit_mallocs.erase(std::remove_if(arr_lit_mallocs.begin(), arr_lit_mallocs.end(), [&](const std::pair<llvm::CallInst *, uint64_t> &m) { return m.first->getFunction() == ScratchF; }), arr_lit_mallocs.end());
+        ScratchF->eraseFromParent();
+
+        if(SavedBB) {
+            Builder.SetInsertPoint(SavedBB);
+        } else {
+            Builder.ClearInsertionPoint();
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Makes the function that sets up a global on first use, for initializers that need code to run
+     *
+     * @param gvar
+     * @param value
+     * @param name
+     */
+    void lazyGlobalInit(llvm::GlobalVariable *gvar, ExpAST *value, const std::string &name) {
+        // An i8 rather than an i1, llvm only has atomic loads and stores for whole bytes
+        auto ready = new llvm::GlobalVariable(*TheModule, Builder.getInt8Ty(), false, llvm::GlobalValue::InternalLinkage, Builder.getInt8(0), name + ".ready");
+        auto *InitF = llvm::Function::Create(llvm::FunctionType::get(Builder.getVoidTy(), false), llvm::Function::InternalLinkage, name + ".init", TheModule.get());
+        InitF->addFnAttr(llvm::Attribute::NoInline);
+        lazy_globals[name] = InitF;
+
+        auto saved_values = NamedValues;
+        auto *SavedBB = Cur_BB;
+        auto *SavedInsertBB = Builder.GetInsertBlock();
+        auto SavedLoc = Builder.getCurrentDebugLocation();
+        bool saved_in_var = inVarExp;
+
+        NamedValues = GlobalNamedValues;
+        Cur_BB = llvm::BasicBlock::Create(TheContext, "entry", InitF);
+        inVarExp = false;
+        Builder.SetInsertPoint(Cur_BB);
+        Builder.SetCurrentDebugLocation(llvm::DebugLoc());
+        Builder.CreateStore(Builder.getInt8(1), ready)->setAtomic(llvm::AtomicOrdering::Release);
 
+        if(gvar->getValueType()->isArrayTy()) {
+            initFixedArr(gvar, value, name);
+        } else if(auto val = value->irgen()) {
+            Builder.CreateStore(castValue(val, gvar->getValueType()), gvar);
         }
-        return nullptr;
-    }
 
-    llvm::Value *ArrayLitAST::irgen() {
-        auto first = elements.at(0)->irgen();
-
-        auto alloc = inst_arr(first->getType(), 1);
+        Builder.CreateRetVoid();
+        constArrLits();
+        llvm::verifyFunction(*InitF);
 
-        sizes_tmp.push_back(0);
+        NamedValues = saved_values;
+        Cur_BB = SavedBB;
+        inVarExp = saved_in_var;
+        Builder.SetCurrentDebugLocation(SavedLoc);
 
-        sizes_tmp[sizes_tmp.size()-1] += 1;
-        std::cout << sizes_tmp[sizes_tmp.size()-1] << std::endl;
-        appElement(alloc, first, sizes_tmp[sizes_tmp.size()-1]);
-        
-        for(int i = 1; i < elements.size(); i++) {
-            auto cur_elem = elements.at(i)->irgen();
-            if(isArrType(cur_elem->getType())) cur_elem = Builder.CreateLoad(cur_elem);
-            sizes_tmp[sizes_tmp.size()-1] += 1;
-            appElement(alloc, cur_elem, sizes_tmp[sizes_tmp.size()-1]);
+        if(SavedInsertBB) {
+            Builder.SetInsertPoint(SavedInsertBB);
+        } else {
+            Builder.ClearInsertionPoint();
         }
-
-        return Builder.CreateLoad(alloc);
     }
 
     // This creates a variable
@@ -1158,25 +5421,72 @@ namespace ASTS {
             inVarExp = true;
         }
         if(var_type.first == -1) {
-            if(Cur_BB) {
-                if(ArraySizes.find(var_name) != ArraySizes.end()) {
-                    var_value->irgen();
-                } else {
-                    llvm::Value *V = var_value->irgen();
+            // Assigning a global that's set up on first use marks it ready once the value is stored, so its initializer never runs.
+            // Reading it on the right hand side still sets it up first. A nested list is stored a row at a time, and a later row
+            // that reads the array would set it up over the rows already stored, so that one sets it up beforehand
+            auto nested_lit = dynamic_cast<ArrayLitAST*>(var_value.get()) && NamedValues[var_name].type && NamedValues[var_name].type->isArrayTy() && NamedValues[var_name].type->getArrayElementType()->isArrayTy();
+            if(nested_lit) {
+                initGlobalOnUse(var_name);
+            }
+
+            if(Cur_BB && NamedValues[var_name].is_value) {
+                // A const declared in a block the assignment isn't in, the parser only catches the ones it can see
+                ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m can't assign to the const " + var_name + " declared in an inner block");
+            } else if(Cur_BB && NamedValues[var_name].type && NamedValues[var_name].type->isArrayTy()) {
+                initFixedArr(NamedValues[var_name].val, var_value.get(), var_name);
+                markGlobalReady(var_name);
+            } else if(Cur_BB) {
+                llvm::Value *V = isArrayExp(var_value.get()) ? fuseArrayExp(var_value.get(), nullptr) : var_value->irgen();
+
+                if(V && isSliceExp(var_value.get()) && NamedValues[var_name].peko_type.size() > 2 && NamedValues[var_name].peko_type.substr(NamedValues[var_name].peko_type.size() - 2) == " +") {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m a slice can't be stored in the growable array " + var_name + ", its memory belongs to what it was sliced from");
+                } else if(V) {
+                    if(NamedValues[var_name].type->isStructTy()) {
+                        V = toArrLayout(castValue(loadIfAggregatePtr(V), NamedValues[var_name].type), NamedValues[var_name].type);
+                    } else {
+                        V = castValue(V, NamedValues[var_name].type);
+                    }
 
                     Builder.CreateStore(V, NamedValues[var_name].val);  
+                    markGlobalReady(var_name);
                 }
-                
             } else {
                 global_vars.push_back((global_llvm_var){var_name, std::move(var_value), NamedValues[var_name].type, true});
             }
         } else {
             if(Cur_BB) {
                 allocatedObjects["string"] = {llvm::Type::getInt8PtrTy(TheContext), llvm::Type::getInt8PtrTy(TheContext), {}};
-                allocatedObjects["number"] = {llvm::Type::getDoubleTy(TheContext), llvm::Type::getDoubleTy(TheContext), {}};
-                if(var_type.first == number_ty || var_type.first == string_ty) {
-                    auto alloc = Builder.CreateAlloca(allocatedObjects[var_type.second].struct_ty, 0, var_name.c_str());
-                    NamedValues[var_name] = {alloc, allocatedObjects[var_type.second].struct_ty, false};
+                allocatedObjects["bool"] = {llvm::Type::getInt1Ty(TheContext), llvm::Type::getInt1Ty(TheContext), {}};
+                for(auto num_name : {"number", "f32", "i32", "i16", "i8", "u8", "vec2", "vec4", "vec8"}) {
+                    allocatedObjects[num_name] = {getNumType(num_name), getNumType(num_name), {}};
+                }
+                allocatedObjects["strview"] = {getArrType(Builder.getInt8Ty(), 1), getArrType(Builder.getInt8Ty(), 1), {}};
+
+                // A const is never stored to again, so the value is used directly instead of going through the stack. Names are bound
+                // for the rest of the function, so a const in a block that hides a variable goes on the stack, the variable is assigned after the block
+                bool hides_local = NamedValues.count(var_name) && NamedValues[var_name].val && !NamedValues[var_name].global;
+                if((var_type.first == number_ty || var_type.first == string_ty || var_type.first == bool_ty) && is_const && !hides_local) {
+                    llvm::Value *V = var_value->irgen();
+                    if(!V) {
+                        inVarExp = true;
+                        return nullptr;
+                    }
+
+                    V = castValue(V, allocatedObjects[var_type.second].struct_ty);
+                    if(llvm::isa<llvm::Instruction>(V) && !V->hasName()) {
+                        V->setName(var_name);
+                    }
+
+                    NamedValues[var_name] = {V, allocatedObjects[var_type.second].struct_ty, false, var_type.second, true};
+                    debugVariable(V, var_name, V->getType(), var_type.second, line);
+                } else if(var_type.first == number_ty || var_type.first == string_ty || var_type.first == bool_ty) {
+                    // Variables go in the entry block, so one declared in a loop doesn't grow the stack every time around.
+                    // That would run out of stack in unoptimized builds, like the instrumented ones for -fprofile-generate
+                    auto *TheFunction = Builder.GetInsertBlock()->getParent();
+                    llvm::IRBuilder<> TmpB(&TheFunction->getEntryBlock(), TheFunction->getEntryBlock().begin());
+                    auto alloc = TmpB.CreateAlloca(allocatedObjects[var_type.second].struct_ty, 0, var_name.c_str());
+                    NamedValues[var_name] = {alloc, allocatedObjects[var_type.second].struct_ty, false, var_type.second};
+                    debugVariable(alloc, var_name, alloc->getAllocatedType(), var_type.second, line);
 
                     llvm::Value *V = var_value->irgen();
 
@@ -1185,54 +5495,78 @@ namespace ASTS {
                         return nullptr;
                     }
 
-                    Builder.CreateStore(V, alloc);                    
+                    Builder.CreateStore(castValue(V, allocatedObjects[var_type.second].struct_ty), alloc);                    
+                } else if(auto fixed = var_type.first == array_ty ? getFixedArrType(var_type.second) : nullptr) {
+                    // Fixed size arrays live in the stack frame, where llvm can split them into registers
+                    auto *TheFunction = Builder.GetInsertBlock()->getParent();
+                    llvm::IRBuilder<> TmpB(&TheFunction->getEntryBlock(), TheFunction->getEntryBlock().begin());
+                    auto alloc = TmpB.CreateAlloca(fixed, 0, var_name.c_str());
+
+                    NamedValues[var_name] = {alloc, fixed, false, var_type.second};
+                    initFixedArr(alloc, var_value.get(), var_name);
                 } else if(var_type.first == array_ty) {
                     std::vector<std::string> splitt;
                     split(var_type.second, " ", splitt);
                     llvm::Type *T = allocatedObjects[splitt.at(0)].struct_ty;
+                    if(allocatedObjects[splitt.at(0)].soa_ty) {
+                        T = allocatedObjects[splitt.at(0)].soa_ty;
+                    }
                     splitt.erase(splitt.begin());
+
+                    if(!isSliceName(var_type.second) && var_value && isSliceExp(var_value.get())) {
+                        ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m a slice can't be stored in the growable array " + var_name + ", its memory belongs to what it was sliced from");
+                        inVarExp = false;
+                        return nullptr;
+                    }
+
                     int depth = 0;
                     for(auto plus : splitt) {
                         depth++;
                     }
                     auto alloc = inst_arr(T, depth);
-                    NamedValues[var_name] = {alloc, alloc->getType(), false};
-                    std::vector<int> sizes;
+                    NamedValues[var_name] = {alloc, getArrType(T, depth), false, var_type.second};
 
-                    for(int i = 0; i < depth; i++) {
-                        sizes.push_back(0);
+                    if(auto lit = dynamic_cast<ArrayLitAST*>(var_value.get())) {
+                        lit->elem_type = depth > 1 ? getArrType(T, depth - 1) : T;
                     }
-                    ArraySizes[var_name] = sizes;
-                    sizes_tmp = sizes;
 
                     if(var_value) {
-                        if(!strcmp(var_value->getType(), "arr_lit")) {
-                            auto v_to_arr_lit = dynamic_cast<ArrayLitAST*>(var_value.get());
-                            
-                            for(int i = 0; i < v_to_arr_lit->getSize(); i++) {
-                                auto cur_elem = v_to_arr_lit->getElement(i)->irgen();
-                                ArraySizes[var_name] = sizes_tmp;
-                                ArraySizes[var_name][0] += 1;
-                                if(isArrType(cur_elem->getType())) {
-                                    cur_elem = Builder.CreateLoad(cur_elem);
-                                }
-
-                                appElement(NamedValues[var_name].val, cur_elem, ArraySizes[var_name][0]);
-                            }
+                        auto V = isArrayExp(var_value.get()) ? fuseArrayExp(var_value.get(), nullptr) : var_value->irgen();
+                        if(V) {
+                            Builder.CreateStore(toArrLayout(castValue(loadIfAggregatePtr(V), getArrType(T, depth)), getArrType(T, depth)), alloc);
                         }
                     }
-                    
-                    for(auto size : sizes) sizes.pop_back();
                 } else {
-                    auto alloc = Builder.CreateAlloca(allocatedObjects[var_type.second].struct_ty, 0, var_name.c_str());
+                    auto *TheFunction = Builder.GetInsertBlock()->getParent();
+                    llvm::IRBuilder<> TmpB(&TheFunction->getEntryBlock(), TheFunction->getEntryBlock().begin());
+                    auto alloc = TmpB.CreateAlloca(allocatedObjects[var_type.second].struct_ty, 0, var_name.c_str());
                     NamedValues[var_name] = {alloc, allocatedObjects[var_type.second].struct_ty, false};
+                    debugVariable(alloc, var_name, alloc->getAllocatedType(), var_type.second, line);
+
+                    // An object starts out zeroed, the fields nothing set read as 0 and there is no cold block until a @cold field is used
+                    Builder.CreateStore(llvm::Constant::getNullValue(alloc->getAllocatedType()), alloc);
+
                     llvm::Value *V;
-                    if(var_value && !strcmp(var_value->getType(), "call")) {
-                        auto val_to_call = dynamic_cast<CallExpAST*>(var_value.get());
+                    auto val_to_call = dynamic_cast<CallExpAST*>(var_value.get());
+                    if(val_to_call && TheModule->getFunction(val_to_call->getCallee() + "._init")) {
                         val_to_call->setCallee(val_to_call->getCallee() + "._init");
                         val_to_call->argsv_extra.push_back(alloc);
                         val_to_call->irgen();
-                        V = alloc;
+                    } else if(val_to_call && allocatedObjects.count(val_to_call->getCallee()) && !TheModule->getFunction(val_to_call->getCallee())) {
+                        // An object without an _init is made by calling it without arguments, and keeps its zeroed fields
+                        if(!val_to_call->args.empty()) {
+                            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m " + val_to_call->getCallee() + " has no _init, so it's made without arguments");
+                        }
+                    } else if(val_to_call) {
+                        // A function returning an object writes it straight into the variable
+                        val_to_call->sret_dest = alloc;
+                        V = val_to_call->irgen();
+                        val_to_call->sret_dest = nullptr;
+                    } else if(var_value) {
+                        V = var_value->irgen();
+                        if(V && V->getType() == alloc->getType()) {
+                            Builder.CreateStore(loadIfAggregatePtr(V), alloc);
+                        }
                     }
 
                     V = alloc;
@@ -1245,9 +5579,13 @@ namespace ASTS {
                 llvm::Type *gType;
                 
                 if(var_type.first == number_ty) {
-                    gType = llvm::Type::getDoubleTy(TheContext);
+                    gType = getNumType(var_type.second);
                 } else if(var_type.first == string_ty) {
                     gType = llvm::Type::getInt8PtrTy(TheContext);
+                } else if(var_type.first == bool_ty) {
+                    gType = llvm::Type::getInt1Ty(TheContext);
+                } else if(var_type.first == array_ty && getFixedArrType(var_type.second)) {
+                    gType = getFixedArrType(var_type.second);
                 } else {
                     gType = allocatedObjects[var_type.second].struct_ty;
                 }
@@ -1258,14 +5596,33 @@ namespace ASTS {
                 gvar->setDSOLocal(true);
                 gvar->setAlignment(llvm::MaybeAlign(8));
                 if(var_type.first == number_ty)
-                    gvar->setInitializer(llvm::ConstantFP::get(TheContext, llvm::APFloat(0.0)));
+                    gvar->setInitializer(llvm::Constant::getNullValue(gType));
                 else if(var_type.first == string_ty)
                     gvar->setInitializer(llvm::ConstantPointerNull::get(llvm::PointerType::get(Builder.getInt8PtrTy(), 0)));
+                else if(var_type.first == bool_ty)
+                    gvar->setInitializer(llvm::ConstantInt::getFalse(TheContext));
+                else if(gType->isArrayTy())
+                    gvar->setInitializer(llvm::Constant::getNullValue(gType));
                 else
                     gvar->setInitializer(llvm::ConstantAggregateZero::get(llvm::PointerType::get(gType, 0)));
                 
-                GlobalNamedValues[var_name] = {gvar, gType, true};
-                global_vars.push_back({var_name, std::move(var_value), gType, false});
+                GlobalNamedValues[var_name] = {gvar, gType, true, var_type.second};
+
+                // Numbers, strings, bools and fixed arrays start out with their value, or get it the first time they're used
+                if(!isNumType(gType) && gType != Builder.getInt1Ty() && gType != Builder.getInt8PtrTy() && !gType->isArrayTy() && !gType->isVectorTy()) {
+                    global_vars.push_back({var_name, std::move(var_value), gType, false});
+                } else if(auto init = var_value ? constGlobalValue(var_value.get(), gType) : nullptr) {
+                    gvar->setInitializer(init);
+                    gvar->setConstant(is_const);
+
+                    const_value val;
+                    const_steps = 0;
+                    if(is_const && (var_type.second == "number" || var_type.second == "string" || var_type.second == "bool") && constEval(var_value.get(), nullptr, val) && val.type == var_type.first) {
+                        const_globals[var_name] = val;
+                    }
+                } else if(var_value) {
+                    lazyGlobalInit(gvar, var_value.get(), var_name);
+                }
             }
         }
 
@@ -1273,6 +5630,52 @@ namespace ASTS {
         return nullptr;
     }
 
+    /**
+     * @brief Gets the fast math flags of a function, from -ffast-math and its @fastmath attribute.
+     * @fastmath on its own is every flag, or it can name them, ex: @fastmath(reassoc, contract)
+     * 
+     * @param Proto 
+     * @return llvm::FastMathFlags 
+     */
+    llvm::FastMathFlags fastMathFlags(ProtoAST *Proto) {
+        llvm::FastMathFlags FMF;
+        if(fast_math) {
+            FMF.setFast();
+        }
+
+        for(auto &attr : Proto->attributes) {
+            if(attr.name != "fastmath") {
+                continue;
+            }
+
+            if(attr.args.empty()) {
+                FMF.setFast();
+            }
+
+            for(auto &arg : attr.args) {
+                if(arg == "fast") {
+                    FMF.setFast();
+                } else if(arg == "reassoc") {
+                    FMF.setAllowReassoc();
+                } else if(arg == "contract") {
+                    FMF.setAllowContract();
+                } else if(arg == "nnan") {
+                    FMF.setNoNaNs();
+                } else if(arg == "ninf") {
+                    FMF.setNoInfs();
+                } else if(arg == "nsz") {
+                    FMF.setNoSignedZeros();
+                } else if(arg == "arcp") {
+                    FMF.setAllowReciprocal();
+                } else if(arg == "afn") {
+                    FMF.setApproxFunc();
+                }
+            }
+        }
+
+        return FMF;
+    }
+
     llvm::Function *ProtoAST::irgen() {
         // Make the function type
         llvm::FunctionType *FT = nullptr;
@@ -1288,35 +5691,589 @@ namespace ASTS {
             std::vector<llvm::Type *> types;
             for(auto arg : args) {
                 if(arg.second.first == number_ty)
-                    types.push_back(llvm::Type::getDoubleTy(TheContext));
+                    types.push_back(getNumType(arg.second.second));
                 else if(arg.second.first == string_ty)
                     types.push_back(llvm::Type::getInt8PtrTy(TheContext));
+                else if(arg.second.first == bool_ty)
+                    types.push_back(llvm::Type::getInt1Ty(TheContext));
                 else if(arg.second.first == custom_ty)
                     types.push_back(allocatedObjects[arg.second.second].struct_ptr_ty);
+                else if(arg.second.first == array_ty && getFixedArrType(arg.second.second))
+                    types.push_back(llvm::PointerType::getUnqual(getFixedArrType(arg.second.second)));
+                else if(arg.second.first == array_ty && getSliceType(arg.second.second))
+                    types.push_back(getSliceType(arg.second.second));
             } 
 
             // If the functions type is a number
             if(fn_type.first == number_ty) {
-                // We set its type to double
-                FT = llvm::FunctionType::get(llvm::Type::getDoubleTy(TheContext), types, false);
+                // We set its type to the size of the number
+                FT = llvm::FunctionType::get(getNumType(fn_type.second), types, false);
             } else if(fn_type.first == void_ty) {
                 FT = llvm::FunctionType::get(llvm::Type::getVoidTy(TheContext), types, false);
             } else if(fn_type.first == string_ty) {
                 FT = llvm::FunctionType::get(llvm::Type::getInt8PtrTy(TheContext), types, false);
+            } else if(fn_type.first == bool_ty) {
+                FT = llvm::FunctionType::get(llvm::Type::getInt1Ty(TheContext), types, false);
+            } else if(fn_type.first == array_ty && getSliceType(fn_type.second)) {
+                FT = llvm::FunctionType::get(getSliceType(fn_type.second), types, false);
             } else if(fn_type.first == custom_ty) {
-                FT = llvm::FunctionType::get(allocatedObjects[fn_type.second].struct_ptr_ty, types, false);
+                // Objects are written into memory given by the caller, so they don't point into a finished stack frame
+                types.insert(types.begin(), allocatedObjects[fn_type.second].struct_ptr_ty);
+                FT = llvm::FunctionType::get(llvm::Type::getVoidTy(TheContext), types, false);
             }
         }
 
         llvm::Function *F = llvm::Function::Create(FT, llvm::Function::ExternalLinkage, func_name, TheModule.get());
+
+        // Nothing outside the program can call the function, so llvm is free to change its signature, inline it or delete it
+        if(whole_program && func_name != "main" && !exported) {
+            F->setLinkage(llvm::Function::InternalLinkage);
+            F->setCallingConv(llvm::CallingConv::Fast);
+        }
+
         // Set names for all arguments.
         unsigned Idx = 0;
-        for (auto &Arg : F->args())
-            Arg.setName(args[Idx++].first);
+        for (auto &Arg : F->args()) {
+            if(fn_type.first == custom_ty && Arg.getArgNo() == 0 && func_name != "main") {
+                Arg.setName("ret");
+                F->addParamAttr(0, llvm::Attribute::getWithStructRetType(TheContext, allocatedObjects[fn_type.second].struct_ty));
+                F->addParamAttr(0, llvm::Attribute::NoAlias);
+                continue;
+            }
+
+            Arg.setName(args[Idx].first);
+
+            // The object a method is called on always exists, and is at least as big as its hot fields
+            if(args[Idx].first == "this" && args[Idx].second.first == custom_ty) {
+                auto &DL = TheModule->getDataLayout();
+                F->addParamAttr(Arg.getArgNo(), llvm::Attribute::NonNull);
+                F->addDereferenceableParamAttr(Arg.getArgNo(), DL.getTypeAllocSize(allocatedObjects[args[Idx].second.second].struct_ty));
+            }
+
+            // Fixed size arrays are passed as a pointer to the whole array
+            if(auto fixed = args[Idx].second.first == array_ty ? getFixedArrType(args[Idx].second.second) : nullptr) {
+                auto &DL = TheModule->getDataLayout();
+                F->addParamAttr(Arg.getArgNo(), llvm::Attribute::NonNull);
+                F->addDereferenceableParamAttr(Arg.getArgNo(), DL.getTypeAllocSize(fixed));
+            }
+
+            if(noalias_args.count(args[Idx].first)) {
+                F->addParamAttr(Arg.getArgNo(), llvm::Attribute::NoAlias);
+            }
+
+            // The memory behind a const object or array is only read, which is checked once the body is generated
+            if(const_args.count(args[Idx].first) && Arg.getType()->isPointerTy()) {
+                F->addParamAttr(Arg.getArgNo(), llvm::Attribute::ReadOnly);
+            }
+
+            Idx++;
+        }
+
+        if(hasAttribute("inline"))
+            F->addFnAttr(llvm::Attribute::AlwaysInline);
+        if(hasAttribute("noinline"))
+            F->addFnAttr(llvm::Attribute::NoInline);
+        if(hasAttribute("hot"))
+            F->addFnAttr(llvm::Attribute::Hot);
+        if(hasAttribute("cold"))
+            F->addFnAttr(llvm::Attribute::Cold);
+
+        // The backend is told too, so it can make the same assumptions when it picks instructions
+        auto FMF = fastMathFlags(this);
+        if(FMF.noNaNs())
+            F->addFnAttr("no-nans-fp-math", "true");
+        if(FMF.noInfs())
+            F->addFnAttr("no-infs-fp-math", "true");
+        if(FMF.noSignedZeros())
+            F->addFnAttr("no-signed-zeros-fp-math", "true");
+        if(FMF.isFast())
+            F->addFnAttr("unsafe-fp-math", "true");
+
+        // The body is checked once it is generated, this lets calls made before that be treated as pure.
+        // Returning an object writes into the caller's memory, so only the checks apply to those
+        if(hasAttribute("pure") && !hasAttribute("memo")) {
+            F->addFnAttr(llvm::Attribute::NoUnwind);
+            if(!F->hasStructRetAttr()) {
+                F->addFnAttr(llvm::Attribute::ReadOnly);
+            }
+        }
 
         return F;
     }
 
+    /**
+     * @brief Finds the memory a pointer was made from by looking through geps and casts
+     * 
+     * @param ptr 
+     * @return llvm::Value* 
+     */
+    llvm::Value *getPtrBase(llvm::Value *ptr) {
+        while(llvm::isa<llvm::GetElementPtrInst>(ptr) || llvm::isa<llvm::CastInst>(ptr)) {
+            ptr = llvm::cast<llvm::Instruction>(ptr)->getOperand(0);
+        }
+
+        return ptr;
+    }
+
+    /**
+     * @brief Checks that a @pure function only writes to its own stack frame (or the object it returns) and only calls functions that don't write memory.
+     * A function that doesn't read outside of its stack frame either is marked readnone instead of readonly.
+     * Building strings and arrays, and calling @memo functions, only writes memory nobody else can see yet (or the hidden memo tables).
+     * These keep the function pure but it gets no memory attribute, since llvm would think the writes can be dropped
+     * 
+     * @param TheFunction 
+     * @param kind the attribute that asked for the check, for errors
+     */
+    void verifyPure(llvm::Function *TheFunction, std::string kind) {
+        std::string fn_name = std::string(TheFunction->getName());
+        if(kind == "@memo") {
+            fn_name = fn_name.substr(0, fn_name.size() - std::string(".memo").size());
+        }
+
+        bool reads = false;
+        bool hidden_writes = false;
+        std::set<std::string> allocators = {"malloc", "realloc", "addstr", "mulstr"};
+
+        auto isAllocation = [&](llvm::Value *base) {
+            auto *call = llvm::dyn_cast<llvm::CallInst>(base);
+            return call && call->getCalledFunction() && allocators.count(std::string(call->getCalledFunction()->getName()));
+        };
+
+        for(auto &BB : *TheFunction) {
+            for(auto &I : BB) {
+                if(auto *store = llvm::dyn_cast<llvm::StoreInst>(&I)) {
+                    auto base = getPtrBase(store->getPointerOperand());
+                    auto arg = llvm::dyn_cast<llvm::Argument>(base);
+
+                    if(!llvm::isa<llvm::AllocaInst>(base) && !isAllocation(base) && !(arg && arg->hasStructRetAttr())) {
+                        ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m " + kind + " function " + fn_name + " writes to memory outside of the function (a global, an argument or an array)");
+                        return;
+                    }
+                } else if(auto *load = llvm::dyn_cast<llvm::LoadInst>(&I)) {
+                    if(!llvm::isa<llvm::AllocaInst>(getPtrBase(load->getPointerOperand()))) {
+                        reads = true;
+                    }
+                } else if(auto *call = llvm::dyn_cast<llvm::CallInst>(&I)) {
+                    auto callee = call->getCalledFunction();
+
+                    // memcpy and memset into the stack frame are how objects are copied and cleared
+                    if(auto *mem = llvm::dyn_cast<llvm::MemIntrinsic>(call)) {
+                        if(llvm::isa<llvm::AllocaInst>(getPtrBase(mem->getRawDest()))) {
+                            reads = reads || llvm::isa<llvm::MemTransferInst>(mem);
+                            continue;
+                        }
+                    } else if(callee && callee->isIntrinsic() && callee->doesNotAccessMemory()) {
+                        continue;
+                    }
+
+                    std::string callee_name = callee ? std::string(callee->getName()) : "";
+                    // Setting up a global on first use isn't a change the caller can see
+                    std::string global_name = callee_name.substr(0, callee_name.rfind(".init"));
+                    if(callee && lazy_globals.count(global_name) && lazy_globals[global_name] == callee) {
+                        reads = true;
+                        hidden_writes = true;
+                        continue;
+                    }
+
+                    // A const fn is checked on its own, so one can call another or itself
+                    if(function_protos.count(callee_name) && function_protos[callee_name]->const_fn) {
+                        reads = true;
+                        continue;
+                    }
+
+                    if(allocators.count(callee_name) || (function_protos.count(callee_name) && function_protos[callee_name]->hasAttribute("memo"))) {
+                        hidden_writes = true;
+                        reads = true;
+                        continue;
+                    }
+
+                    if(!callee || !callee->onlyReadsMemory()) {
+                        ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m " + kind + " function " + fn_name + " calls " + (callee ? std::string(callee->getName()) : std::string("a function pointer")) + ", which isn't pure");
+                        return;
+                    }
+
+                    reads = reads || !callee->doesNotAccessMemory();
+                }
+            }
+        }
+
+        TheFunction->removeFnAttr(llvm::Attribute::ReadOnly);
+        if(hidden_writes || TheFunction->hasStructRetAttr()) {
+            return;
+        }
+
+        TheFunction->addFnAttr(llvm::Attribute::NoUnwind);
+        TheFunction->addFnAttr(reads ? llvm::Attribute::ReadOnly : llvm::Attribute::ReadNone);
+    }
+
+    /**
+     * @brief Turns value into the 64 bit word a memo table stores, or back when to_word is false
+     * 
+     * @param val 
+     * @param type the peko type of the value
+     * @param to_word 
+     * @return llvm::Value* 
+     */
+    llvm::Value *memoWord(llvm::Value *val, llvm::Type *type, bool to_word) {
+        if(type->isDoubleTy()) {
+            return Builder.CreateBitCast(val, to_word ? Builder.getInt64Ty() : type);
+        } else if(type->isFloatTy()) {
+            return to_word ? Builder.CreateZExt(Builder.CreateBitCast(val, Builder.getInt32Ty()), Builder.getInt64Ty()) : Builder.CreateBitCast(Builder.CreateTrunc(val, Builder.getInt32Ty()), type);
+        } else if(type->isPointerTy()) {
+            return to_word ? Builder.CreatePtrToInt(val, Builder.getInt64Ty()) : Builder.CreateIntToPtr(val, type);
+        }
+
+        return to_word ? Builder.CreateZExt(val, Builder.getInt64Ty()) : Builder.CreateTrunc(val, type);
+    }
+
+    /**
+     * @brief Fills in the body of a @memo function, which looks the arguments up in its table and only calls the real body on a miss.
+     * Recursive calls go through the wrapper too, so every level is remembered
+     * 
+     * @param Wrapper the function callers see
+     * @param Body the function with the peko code
+     * @param Proto 
+     */
+    void buildMemoWrapper(llvm::Function *Wrapper, llvm::Function *Body, ProtoAST *Proto) {
+        std::string fn_name = std::string(Wrapper->getName());
+        int64_t capacity = 1024;
+        int flags = memo_stats ? 2 : 0;
+
+        for(auto &attr : Proto->attributes) {
+            for(auto &arg : attr.name == "memo" ? attr.args : std::vector<std::string>()) {
+                if(arg == "threadsafe") {
+                    flags |= 1;
+                } else {
+                    capacity = std::stoll(arg);
+                }
+            }
+        }
+
+        std::string kinds = "";
+        for(auto &Arg : Wrapper->args()) {
+            if(isNumType(Arg.getType())) {
+                kinds += "n";
+            } else if(Arg.getType() == Builder.getInt8PtrTy()) {
+                kinds += "s";
+            } else if(Arg.getType()->isIntegerTy(1)) {
+                kinds += "b";
+            } else {
+                ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m @memo function " + fn_name + " can only take numbers, strings and bools");
+                return;
+            }
+        }
+
+        auto ret_type = Wrapper->getReturnType();
+        if(!isNumType(ret_type) && ret_type != Builder.getInt8PtrTy() && !ret_type->isIntegerTy(1)) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m @memo function " + fn_name + " has to return a number, string or bool");
+            return;
+        }
+
+        auto *slot = new llvm::GlobalVariable(*TheModule, Builder.getInt8PtrTy(), false, llvm::GlobalValue::InternalLinkage, llvm::ConstantPointerNull::get(Builder.getInt8PtrTy()), fn_name + ".memo_table");
+
+        auto *EntryBB = llvm::BasicBlock::Create(TheContext, "entry", Wrapper);
+        auto *HitBB   = llvm::BasicBlock::Create(TheContext, "memohit", Wrapper);
+        auto *MissBB  = llvm::BasicBlock::Create(TheContext, "memomiss", Wrapper);
+        Builder.SetInsertPoint(EntryBB);
+
+        auto table = Builder.CreateCall(TheModule->getFunction("memo_open"), {slot, Builder.CreateGlobalStringPtr(fn_name), Builder.getInt64(capacity), Builder.CreateGlobalStringPtr(kinds), Builder.getInt32(flags)}, "memotable");
+
+        auto args = Builder.CreateAlloca(Builder.getInt64Ty(), Builder.getInt32(std::max<size_t>(kinds.size(), 1)), "memoargs");
+        std::vector<llvm::Value *> call_args;
+        for(auto &Arg : Wrapper->args()) {
+            Builder.CreateStore(memoWord(&Arg, Arg.getType(), true), Builder.CreateGEP(args, Builder.getInt64(Arg.getArgNo())));
+            call_args.push_back(&Arg);
+        }
+
+        auto result = Builder.CreateAlloca(Builder.getInt64Ty(), nullptr, "memoresult");
+        auto hit = Builder.CreateCall(TheModule->getFunction("memo_lookup"), {table, args, result}, "memohit");
+        Builder.CreateCondBr(Builder.CreateICmpNE(hit, Builder.getInt32(0)), HitBB, MissBB);
+
+        Builder.SetInsertPoint(HitBB);
+        Builder.CreateRet(memoWord(Builder.CreateLoad(result), ret_type, false));
+
+        Builder.SetInsertPoint(MissBB);
+        auto val = Builder.CreateCall(Body, call_args, "memoval");
+        val->setCallingConv(Body->getCallingConv());
+        Builder.CreateCall(TheModule->getFunction("memo_insert"), {table, args, memoWord(val, ret_type, true)});
+        Builder.CreateRet(val);
+
+        llvm::verifyFunction(*Wrapper);
+    }
+
+    /**
+     * @brief Checks if a value of a type can lead to a value of another type, by being it, pointing at it or holding it.
+     * Arrays and slices of objects are {T*, i64} and fixed size arrays [N x T], so they lead to their objects too
+     * 
+     * @param type 
+     * @param target 
+     * @param seen the struct types already looked through, objects can hold each other
+     * @return true 
+     * @return false 
+     */
+    bool typeReaches(llvm::Type *type, llvm::Type *target, std::set<llvm::Type *> &seen) {
+        if(type == target) {
+            return true;
+        } else if(type->isPointerTy()) {
+            return typeReaches(type->getPointerElementType(), target, seen);
+        } else if(type->isArrayTy()) {
+            return typeReaches(type->getArrayElementType(), target, seen);
+        } else if(auto struct_type = llvm::dyn_cast<llvm::StructType>(type)) {
+            if(!seen.insert(type).second) {
+                return false;
+            }
+
+            for(auto elem : struct_type->elements()) {
+                if(typeReaches(elem, target, seen)) {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Marks the this pointer of a method as noalias when nothing else the method can reach may point at the same object.
+     * Methods only see their arguments and globals, so this holds if no other argument and no global can lead to an object of its type.
+     * Only methods with every call in the module are marked, which is what --whole-program gives the ones that aren't exported.
+     * Has to run after the whole program is generated, because globals can be declared after the object
+     * 
+     */
+    void markThisNoAlias() {
+        for(auto &F : *TheModule) {
+            if(F.arg_empty() || F.getArg(F.arg_size() - 1)->getName() != "this" || !F.hasLocalLinkage()) {
+                continue;
+            }
+
+            auto obj_type = F.getArg(F.arg_size() - 1)->getType()->getPointerElementType();
+            bool may_alias = false;
+            for(int i = 0; i < F.arg_size() - 1; i++) {
+                std::set<llvm::Type *> seen;
+                may_alias |= typeReaches(F.getArg(i)->getType(), obj_type, seen);
+            }
+
+            for(auto &G : TheModule->globals()) {
+                std::set<llvm::Type *> seen;
+                may_alias |= typeReaches(G.getValueType(), obj_type, seen);
+            }
+
+            if(!may_alias) {
+                F.addParamAttr(F.arg_size() - 1, llvm::Attribute::NoAlias);
+            }
+        }
+    }
+
+    /**
+     * @brief Checks if the memory behind ptr can be written, anything other than reading it, copying from it or passing it as a readonly argument counts
+     *
+     * @param ptr
+     * @return true
+     * @return false
+     */
+    bool ptrWritten(llvm::Value *ptr) {
+        for(auto &use : ptr->uses()) {
+            auto *user = use.getUser();
+
+            if(llvm::isa<llvm::LoadInst>(user)) {
+                continue;
+            } else if(llvm::isa<llvm::GetElementPtrInst>(user) || llvm::isa<llvm::BitCastInst>(user) || llvm::isa<llvm::ConstantExpr>(user)) {
+                if(ptrWritten(user)) {
+                    return true;
+                }
+                continue;
+            } else if(auto *mem = llvm::dyn_cast<llvm::MemTransferInst>(user)) {
+                if(mem->getRawSource() == ptr && mem->getRawDest() != ptr) {
+                    continue;
+                }
+            } else if(auto *call = llvm::dyn_cast<llvm::CallBase>(user)) {
+                if(call->isArgOperand(&use) && call->onlyReadsMemory(call->getArgOperandNo(&use))) {
+                    continue;
+                }
+            }
+
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Marks the globals that are never changed after they're declared as constant, so llvm can use their value directly
+     */
+    void markConstGlobals() {
+        for(auto &var : GlobalNamedValues) {
+            auto gvar = TheModule->getNamedGlobal(var.first);
+
+            if(gvar && !gvar->isConstant() && !lazy_globals.count(var.first) && !ptrWritten(gvar)) {
+                gvar->setConstant(true);
+            }
+        }
+    }
+
+    /**
+     * @brief Sends the mallocs and reallocs of the generated code through the stdlib's counting versions, so the program
+     * prints how many buffers it allocated when it exits. This shows how many array literals were kept off the heap
+     */
+    void countAllocs() {
+        for(std::string name : {"malloc", "realloc"}) {
+            auto F = TheModule->getFunction(name);
+            if(F) {
+                auto counted = TheModule->getOrInsertFunction("alloc_stats_" + name, F->getFunctionType());
+                F->replaceAllUsesWith(counted.getCallee());
+            }
+        }
+
+        auto main_fn = TheModule->getFunction("main");
+        if(main_fn && !main_fn->isDeclaration()) {
+            llvm::IRBuilder<> B(&main_fn->getEntryBlock(), main_fn->getEntryBlock().getFirstInsertionPt());
+            B.CreateCall(TheModule->getOrInsertFunction("alloc_stats_open", llvm::FunctionType::get(B.getVoidTy(), false)));
+        }
+    }
+
+    /**
+     * @brief Makes a copy of a @multiversion function for every cpu feature it names, and puts a dispatcher under its name that picks the
+     * best copy the cpu can run. The dispatcher is an ifunc where the loader supports them, so the pick is made once when the program loads.
+     * Elsewhere it's a function that picks on its first call and calls through a pointer after that
+     * 
+     * @param F the function with the peko code, it becomes the copy for cpus without any of the features
+     * @param features later features are taken to be faster, ex: avx2, avx512f
+     * @param use_ifunc 
+     */
+    void buildMultiversion(llvm::Function *F, const std::vector<std::string> &features, bool use_ifunc) {
+        std::string name = std::string(F->getName());
+        auto linkage = F->getLinkage();
+        F->setName(name + ".default");
+        F->setLinkage(llvm::Function::InternalLinkage);
+
+        std::vector<llvm::Function *> copies;
+        for(auto &feature : features) {
+            llvm::ValueToValueMapTy VMap;
+            auto copy = llvm::CloneFunction(F, VMap);
+            copy->setName(name + "." + feature);
+            copy->addFnAttr("target-features", (target_features.empty() ? "" : target_features + ",") + "+" + feature);
+            copies.push_back(copy);
+        }
+
+        // The resolver gives the copy for the last feature the cpu has
+        auto resolver = llvm::Function::Create(llvm::FunctionType::get(F->getType(), false), llvm::Function::InternalLinkage, name + ".resolver", TheModule.get());
+        llvm::IRBuilder<> B(llvm::BasicBlock::Create(TheContext, "entry", resolver));
+        llvm::Value *chosen = F;
+        for(int i = 0; i < features.size(); i++) {
+            int id = std::find(multiversion_features.begin(), multiversion_features.end(), features[i]) - multiversion_features.begin();
+            auto has = B.CreateCall(TheModule->getFunction("cpu_supports"), {B.getInt32(id)}, "has" + features[i]);
+            chosen = B.CreateSelect(B.CreateICmpNE(has, B.getInt32(0)), copies[i], chosen);
+        }
+        B.CreateRet(chosen);
+
+        llvm::Constant *dispatcher;
+        if(use_ifunc) {
+            dispatcher = llvm::GlobalIFunc::create(F->getFunctionType(), F->getAddressSpace(), linkage, name, resolver, TheModule.get());
+        } else {
+            // Threads may call it the first time together, so the slot is read and written atomically. They all pick the same copy,
+            // so whichever store lands is fine and no ordering is needed
+            auto &DL = TheModule->getDataLayout();
+            auto slot = new llvm::GlobalVariable(*TheModule, F->getType(), false, llvm::GlobalValue::InternalLinkage, llvm::ConstantPointerNull::get(F->getType()), name + ".impl");
+            slot->setAlignment(DL.getABITypeAlign(F->getType()));
+            auto Dispatch = llvm::Function::Create(F->getFunctionType(), linkage, name, TheModule.get());
+            Dispatch->copyAttributesFrom(F);
+            Dispatch->setLinkage(linkage);
+
+            auto *EntryBB = llvm::BasicBlock::Create(TheContext, "entry", Dispatch);
+            auto *PickBB  = llvm::BasicBlock::Create(TheContext, "pick", Dispatch);
+            auto *CallBB  = llvm::BasicBlock::Create(TheContext, "call", Dispatch);
+
+            B.SetInsertPoint(EntryBB);
+            auto impl = B.CreateLoad(slot, "impl");
+            impl->setAtomic(llvm::AtomicOrdering::Monotonic);
+            impl->setAlignment(DL.getABITypeAlign(F->getType()));
+            B.CreateCondBr(B.CreateIsNull(impl), PickBB, CallBB);
+
+            B.SetInsertPoint(PickBB);
+            auto picked = B.CreateCall(resolver, {}, "picked");
+            auto publish = B.CreateStore(picked, slot);
+            publish->setAtomic(llvm::AtomicOrdering::Monotonic);
+            publish->setAlignment(DL.getABITypeAlign(F->getType()));
+            B.CreateBr(CallBB);
+
+            B.SetInsertPoint(CallBB);
+            auto fn = B.CreatePHI(F->getType(), 2, "fn");
+            fn->addIncoming(impl, EntryBB);
+            fn->addIncoming(picked, PickBB);
+
+            std::vector<llvm::Value *> args;
+            for(auto &Arg : Dispatch->args()) {
+                args.push_back(&Arg);
+            }
+            auto call = B.CreateCall(F->getFunctionType(), fn, args);
+            call->setCallingConv(F->getCallingConv());
+            call->setAttributes(F->getAttributes());
+            call->setTailCall();
+            if(call->getType()->isVoidTy()) {
+                B.CreateRetVoid();
+            } else {
+                B.CreateRet(call);
+            }
+
+            dispatcher = Dispatch;
+        }
+
+        F->replaceUsesWithIf(dispatcher, [&](llvm::Use &U) {
+            auto I = llvm::dyn_cast<llvm::Instruction>(U.getUser());
+            return I && I->getFunction() != resolver;
+        });
+    }
+
+    /**
+     * @brief Points the module at the target before any code is generated, so the field order, sizes and alignments worked
+     * out while generating it match the ones clang builds it with, ex: pointers are 4 bytes on win32
+     * 
+     * @param triple 
+     */
+    void initTarget(const std::string &triple) {
+        llvm::InitializeAllTargetInfos();
+        llvm::InitializeAllTargets();
+        llvm::InitializeAllTargetMCs();
+
+        TheModule->setTargetTriple(triple);
+
+        std::string err;
+        auto target = llvm::TargetRegistry::lookupTarget(triple, err);
+        if(!target) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m can't build for " + triple + ": " + err);
+            return;
+        }
+
+        llvm::TargetOptions options;
+        std::unique_ptr<llvm::TargetMachine> machine(target->createTargetMachine(triple, target_cpu.empty() ? "generic" : target_cpu, target_features, options, llvm::None));
+        TheModule->setDataLayout(machine->createDataLayout());
+    }
+
+    /**
+     * @brief Gives every function the cpu and features picked with -march, -mcpu and -mattr, then makes the copies of the @multiversion functions
+     * 
+     * @param use_ifunc if the target's loader runs ifunc resolvers, which is the case for linux
+     */
+    void setTargetCPU(bool use_ifunc) {
+        for(auto &F : *TheModule) {
+            if(F.isDeclaration()) {
+                continue;
+            }
+
+            if(!target_cpu.empty()) {
+                F.addFnAttr("target-cpu", target_cpu);
+            }
+            if(!target_features.empty()) {
+                F.addFnAttr("target-features", target_features);
+            }
+        }
+
+        for(auto &fn : multiversion_fns) {
+            buildMultiversion(fn.first, fn.second, use_ifunc);
+        }
+        multiversion_fns.clear();
+    }
+
     llvm::Function *FunctionExpAST::irgen() {
         for(int i = 0; i < Body.size(); i++) {
             if(!strcmp(Body.at(i)->getType(), "function")) {
@@ -1334,27 +6291,42 @@ namespace ASTS {
 
         if (!TheFunction)            
             return nullptr;        
+
+        // A @memo function keeps its name for the wrapper that checks the table, the peko code goes in name.memo
+        llvm::Function *MemoWrapper = nullptr;
+        if(Proto->hasAttribute("memo") && Proto->getName() != "main") {
+            std::string name = Proto->getName();
+            MemoWrapper = TheFunction;
+
+            Proto->setName(name + ".memo");
+            TheFunction = Proto->irgen();
+            TheFunction->setLinkage(llvm::Function::InternalLinkage);
+            Proto->setName(name);
+        } else if(Proto->hasAttribute("memo")) {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m main can't be @memo");
+        }
+
+        if(Proto->hasAttribute("multiversion") && Proto->getName() == "main") {
+            ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m main can't be @multiversion");
+        }
    
         // Create a new basic block to start insertion into.
         Cur_BB = llvm::BasicBlock::Create(TheContext, "entry", TheFunction);
         Builder.SetInsertPoint(Cur_BB);
+        debugFunction(TheFunction, Proto.get(), this);
+
+        // The floating point math in the body gets the function's fast math flags, the guard puts the old ones back when it's done
+        llvm::IRBuilderBase::FastMathFlagGuard fmf_guard(Builder);
+        Builder.setFastMathFlags(fastMathFlags(Proto.get()));
         
         if(Proto->getName() == "main") {
+            // Numbers, strings, bools and fixed arrays were given their value when they were declared
+            NamedValues.clear();
+            NamedValues.insert(GlobalNamedValues.begin(), GlobalNamedValues.end());
+
             for(int i = 0; i < global_vars.size(); i++) {
                 if(global_vars.at(i).redec == false) {
-                    if(global_vars.at(i).type == llvm::Type::getDoubleTy(TheContext)) {
-                        auto number_val = global_vars.at(i).value->irgen();
-                        auto store_number = Builder.CreateStore(number_val, TheModule->getNamedGlobal(global_vars.at(i).name));
-
-                        NamedValues[global_vars.at(i).name] = {TheModule->getNamedGlobal(global_vars.at(i).name), llvm::Type::getDoubleTy(TheContext), true};
-                    } else if(global_vars.at(i).type == llvm::Type::getInt8PtrTy(TheContext)) {
-                        auto string_val = global_vars.at(i).value->irgen();
-                        //auto string_all = Builder.CreateGlobalStringPtr("asdf"); // Create the global string
-
-                        auto store_string = Builder.CreateStore(string_val, TheModule->getNamedGlobal(global_vars.at(i).name));
-
-                        NamedValues[global_vars.at(i).name] = {std::move(TheModule->getNamedGlobal(global_vars.at(i).name)), llvm::Type::getInt8PtrTy(TheContext), true};
-                    } else if(global_vars.at(i).type == llvm::Type::getInt32PtrTy(TheContext)) {
+                    if(global_vars.at(i).type == llvm::Type::getInt32PtrTy(TheContext)) {
                         llvm::Function *CalleeF = TheModule->getFunction(global_vars.at(i).name);
                         std::vector<llvm::Value *> ArgsV;
                         for (unsigned i = 0, e = dynamic_cast<CallExpAST *>(global_vars.at(i).value.get())->args.size(); i != e; ++i) {
@@ -1363,18 +6335,21 @@ namespace ASTS {
                                 return nullptr;
                         }
                         
-                        Builder.CreateCall(CalleeF, ArgsV, "calltmp");
+                        Builder.CreateCall(CalleeF, ArgsV, "calltmp")->setCallingConv(CalleeF->getCallingConv());
                     }
                 } else {
+                    initGlobalOnUse(global_vars.at(i).name);
                     Builder.CreateStore(global_vars.at(i).value->irgen(), TheModule->getNamedGlobal(global_vars.at(i).name));
                     NamedValues[global_vars.at(i).name] = {std::move(TheModule->getNamedGlobal(global_vars.at(i).name)), global_vars.at(i).type, true};
                 }
             }
 
             for(int i = 0; i < Body.size(); i++) {
+                debugLoc(Body.at(i).get());
                 Body.at(i)->irgen();
             }
 
+            constArrLits();
             llvm::verifyFunction(*TheFunction);
             llvm::verifyModule(*TheModule);
             
@@ -1382,6 +6357,7 @@ namespace ASTS {
                 Builder.CreateRetVoid();
             }
 
+            Builder.SetCurrentDebugLocation(llvm::DebugLoc());
             Cur_BB = nullptr;
             
             return TheFunction;
@@ -1389,35 +6365,80 @@ namespace ASTS {
             // Record the function arguments in the NamedValues map.
             NamedValues.clear();
             NamedValues.insert(GlobalNamedValues.begin(), GlobalNamedValues.end());
+
+            std::map<std::string, std::string> arg_types;
+            for(auto &arg : Proto->getArgs()) {
+                arg_types[arg.first] = arg.second.second;
+            }
+
             for (auto &Arg : TheFunction->args()) {
                 llvm::IRBuilder<> TmpB(Cur_BB, Cur_BB->begin());
                 if(Arg.getType() == llvm::Type::getInt8PtrTy(TheContext)) {
                     auto alloca = Builder.CreateAlloca(llvm::Type::getInt8PtrTy(TheContext), 0, Arg.getName());
                     Builder.CreateStore(Arg.getValueName()->second, alloca);
+                    debugVariable(alloca, std::string(Arg.getName()), Arg.getType(), "string", line, Arg.getArgNo() + 1);
 
                     NamedValues[std::string(Arg.getName())] = {alloca, llvm::Type::getInt8PtrTy(TheContext), false};    
-                } else if(Arg.getType() == llvm::Type::getDoubleTy(TheContext)) {
+                } else if(isNumType(Arg.getType()) || Arg.getType() == llvm::Type::getInt1Ty(TheContext) || Arg.getType()->isVectorTy()) {
 
-                    auto alloca = Builder.CreateAlloca(llvm::Type::getDoubleTy(TheContext), 0, Arg.getName());
+                    auto alloca = Builder.CreateAlloca(Arg.getType(), 0, Arg.getName());
                     auto store_value = Builder.CreateStore(Arg.getValueName()->second, alloca);
-                    NamedValues[std::string(Arg.getName())] = {alloca, llvm::Type::getDoubleTy(TheContext), false};
+                    debugVariable(alloca, std::string(Arg.getName()), Arg.getType(), arg_types[std::string(Arg.getName())], line, Arg.getArgNo() + 1);
+                    NamedValues[std::string(Arg.getName())] = {alloca, Arg.getType(), false, arg_types[std::string(Arg.getName())]};
+                } else if(Arg.hasStructRetAttr()) {
+                    continue;
+                } else if(isArrType(Arg.getType())) {
+                    // A slice is passed as its pointer and length
+                    auto alloca = Builder.CreateAlloca(Arg.getType(), 0, Arg.getName());
+                    Builder.CreateStore(&Arg, alloca);
+                    NamedValues[std::string(Arg.getName())] = {alloca, Arg.getType(), false, arg_types[std::string(Arg.getName())]};
+                } else if(Arg.getType()->getPointerElementType()->isArrayTy()) {
+                    NamedValues[std::string(Arg.getName())] = {&Arg, Arg.getType()->getPointerElementType(), false, arg_types[std::string(Arg.getName())]};
                 } else {
                     auto t = Arg.getType();
                     std::string tname = getTypeName(t);
 
                     NamedValues[std::string(Arg.getName())] = {Arg.getValueName()->second, allocatedObjects[tname].struct_ty, false};
+                    debugVariable(&Arg, std::string(Arg.getName()), t, tname, line, Arg.getArgNo() + 1);
                 }
             }
 
             for(int i = 0; i < Body.size(); i++) {
+                debugLoc(Body.at(i).get());
                 Body.at(i)->irgen();
             }
 
-            if(Proto->fn_type.first == void_ty) {
+            if(Proto->fn_type.first == void_ty || (Proto->fn_type.first == custom_ty && !Builder.GetInsertBlock()->getTerminator())) {
                 Builder.CreateRetVoid();
             }
+
+            constArrLits();
+            for(auto &Arg : TheFunction->args()) {
+                if(Proto->const_args.count(std::string(Arg.getName())) && Arg.hasAttribute(llvm::Attribute::ReadOnly) && ptrWritten(&Arg)) {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m " + Proto->getName() + " changes its const argument " + std::string(Arg.getName()) + ", or passes it where it can be changed");
+                }
+            }
+
+            if(Proto->hasAttribute("pure") || MemoWrapper || Proto->const_fn) {
+                verifyPure(TheFunction, MemoWrapper ? "@memo" : (Proto->const_fn ? "const" : "@pure"));
+            }
             llvm::verifyFunction(*TheFunction);
 
+            // The copies for each cpu are made once every function is generated and the target is known
+            for(auto &attr : Proto->attributes) {
+                if(attr.name == "multiversion") {
+                    multiversion_fns.push_back({TheFunction, attr.args});
+                }
+            }
+
+            // The wrapper gets debug info too, or the body couldn't be inlined into it with its lines
+            if(MemoWrapper) {
+                debugFunction(MemoWrapper, Proto.get(), this);
+                buildMemoWrapper(MemoWrapper, TheFunction, Proto.get());
+                TheFunction = MemoWrapper;
+            }
+
+            Builder.SetCurrentDebugLocation(llvm::DebugLoc());
             Cur_BB = nullptr;
             return TheFunction;
         } 
@@ -37,14 +37,19 @@ int main(int argc, char *argv[]) {
     while(peko_str.back() == '\n')
         peko_str.pop_back();
     
-    while(peko_str.front() == '\n')
+    // The lines taken off the front are counted, so the tokens keep the lines they have in the file
+    int first_line = 1;
+    while(peko_str.front() == '\n') {
         peko_str.erase(0,1);
+        first_line++;
+    }
 
     //std::string stdlib_adv_classes = "class string {@vars{this.val:string_lit;}fn _init(val:string_lit):void{this.val=val;}fn _retval():string_lit{ret this.val;}}class number {@vars{this.val:number_lit;}fn _init(val:number_lit):void{this.val=val;}fn _retval():number_lit{ret this.val;}}";
     //peko_str.insert(0, stdlib_adv_classes);
 
     // Lex the pekoscript code
-    std::vector<PekoLexingEngine::token> toks = PekoLexingEngine::lex_str(peko_str);
+    PekoLexingEngine::source_files.push_back(argv[1]);
+    std::vector<PekoLexingEngine::token> toks = PekoLexingEngine::lex_str(peko_str, 0, first_line);
     
     std::vector<PekoLexingEngine::token> add_toks;
     for(int i = 0; i < toks.size(); i++) {
@@ -55,7 +60,8 @@ int main(int argc, char *argv[]) {
             mod_buf << mod_file.rdbuf();
 
             std::string mod_str = mod_buf.str();
-            auto mod_toks = PekoLexingEngine::lex_str(mod_str);
+            PekoLexingEngine::source_files.push_back(toks[i].value);
+            auto mod_toks = PekoLexingEngine::lex_str(mod_str, PekoLexingEngine::source_files.size() - 1);
             add_toks.insert(add_toks.end(), mod_toks.begin(), mod_toks.end());
             i -= 2;
             for(int x = 0; x < 3; x++) {
@@ -65,6 +71,10 @@ int main(int argc, char *argv[]) {
     }
      
     toks.insert(std::begin(toks), std::begin(add_toks), std::end(add_toks));
+    toks = PekoParsingEngine::instantiate_generics(toks);
+    if(ErrorHandler::errored) {
+        return 1;
+    }
     PekoParsingEngine::toks = toks;
     
     PekoParsingEngine::PekoParser parser(toks);
@@ -74,8 +84,35 @@ int main(int argc, char *argv[]) {
     auto parsed_tokens = parser.Parse();
 
     if(!ErrorHandler::errored) {
-        for(auto &ast : parsed_tokens) {
-            ast->irgen();
+        ASTS::whole_program = CLIEngine::hasFlag(argc, argv, "--whole-program");
+        ASTS::memo_stats = CLIEngine::hasFlag(argc, argv, "--memo-stats");
+        ASTS::alloc_stats = CLIEngine::hasFlag(argc, argv, "--alloc-stats");
+        ASTS::fast_math = CLIEngine::hasFlag(argc, argv, "-ffast-math");
+        ASTS::loop_remarks = CLIEngine::hasFlag(argc, argv, "--loop-remarks");
+
+        // -march=native targets the cpu compiling the program, -mcpu and -mattr pick one, ex: -mcpu=skylake -mattr=+avx2,+fma
+        std::string march = CLIEngine::getFlagValue(argc, argv, "-march");
+        if(march == "native") {
+            ASTS::target_cpu = std::string(llvm::sys::getHostCPUName());
+
+            llvm::StringMap<bool> host_features;
+            if(llvm::sys::getHostCPUFeatures(host_features)) {
+                for(auto &feature : host_features) {
+                    ASTS::target_features += std::string(ASTS::target_features.empty() ? "" : ",") + (feature.getValue() ? "+" : "-") + std::string(feature.getKey());
+                }
+            }
+        } else if(!march.empty()) {
+            ASTS::target_cpu = march;
+        }
+
+        std::string mcpu = CLIEngine::getFlagValue(argc, argv, "-mcpu");
+        if(!mcpu.empty()) {
+            ASTS::target_cpu = mcpu;
+        }
+
+        std::string mattr = CLIEngine::getFlagValue(argc, argv, "-mattr");
+        if(!mattr.empty()) {
+            ASTS::target_features += (ASTS::target_features.empty() ? "" : ",") + mattr;
         }
 
         std::string args_string = "";
@@ -88,18 +125,6 @@ int main(int argc, char *argv[]) {
         std::vector<PekoLexingEngine::token> args = PekoLexingEngine::lex_str(args_string);
         auto cmdflags = CLIEngine::getCmdFlags(args);
 
-        std::string tmpdir = "/tmp";
-        std::string filename = "peko.ll";
-        
-        /*auto config = CLIEngine::getPekoConfig();
-        std::string clang = config["clang-12"];*/
-        std::string clang = "clang-12";
-        std::string pekopath = CLIEngine::getPekoConfigPath();
-
-        std::string stdlibpath = pekopath + "/stdlib/stdlib.c";
-        std::string osxtoolchain = pekopath + "/ostoolchains/osx";
-        std::string wintoolchain = pekopath + "/ostoolchains/win32";
-        
         std::string target_os = "";
 
         if(cmdflags.find("os") != cmdflags.end()) {
@@ -122,20 +147,117 @@ int main(int argc, char *argv[]) {
             target_os = string;
         }
 
+        // The target is set up before the code is generated, since the object layouts and the sizes given to the optimizer depend on it
+        std::map<std::string, std::string> triples = {{"linux", "x86_64-pc-linux-gnu"}, {"osx", "x86_64-apple-macosx11.3.0-macho"}, {"win32", "i686-pc-windows-msvc19.11.0"}};
+        ASTS::initTarget(triples[target_os]);
+        if(ErrorHandler::errored) {
+            return 1;
+        }
+
+        // -g gives the program dwarf debug info, so debuggers and profilers like perf can show the peko lines, optimized or not
+        bool debug = CLIEngine::hasFlag(argc, argv, "-g");
+        if(debug) {
+            std::string level = CLIEngine::getFlagValue(argc, argv, "-O");
+            ASTS::initDebugInfo(!level.empty() && level != "0");
+        }
+
+        for(auto &ast : parsed_tokens) {
+            ast->irgen();
+        }
+
+        // Errors found while generating the code, like a @tailcall that can't be one, stop the program from being built
+        if(ErrorHandler::errored) {
+            return 1;
+        }
+
+        // Array literals are only moved to the stack once every function is there, to see what the ones they're passed to do with them
+        ASTS::stackAllocArrLits();
+
+        // Callers outside the module wouldn't know this is noalias, so it's only given when they can't call the methods
+        if(ASTS::whole_program) {
+            ASTS::markThisNoAlias();
+        }
+        ASTS::markConstGlobals();
+
+        if(ASTS::alloc_stats) {
+            ASTS::countAllocs();
+        }
+
+        if(CLIEngine::hasFlag(argc, argv, "--layout-report")) {
+            ASTS::printLayoutReport();
+        }
+
+        std::string tmpdir = "/tmp";
+        std::string filename = "peko.ll";
+        
+        /*auto config = CLIEngine::getPekoConfig();
+        std::string clang = config["clang-12"];*/
+        std::string clang = "clang-12";
+        std::string pekopath = CLIEngine::getPekoConfigPath();
+
+        std::string stdlibpath = pekopath + "/stdlib/stdlib.c";
+        std::string osxtoolchain = pekopath + "/ostoolchains/osx";
+        std::string wintoolchain = pekopath + "/ostoolchains/win32";
+
+        // -O=<level> is handed to clang, loop hints are only acted on when optimizing
+        std::string opt_level = "";
+        if(cmdflags.find("O") != cmdflags.end()) {
+            opt_level = " -O" + cmdflags["O"];
+        }
+
+        // Profile guided optimization: -fprofile-generate[=dir] builds a program that writes a profile of how it ran,
+        // and -fprofile-use=file feeds one back to clang for inlining, block layout and splitting out the cold code
+        std::string pgo_flags = "";
+        std::string profile_use = CLIEngine::getFlagValue(argc, argv, "-fprofile-use");
+        if(CLIEngine::hasFlag(argc, argv, "-fprofile-generate")) {
+            pgo_flags = " -fprofile-generate";
+        } else if(!CLIEngine::getFlagValue(argc, argv, "-fprofile-generate").empty()) {
+            pgo_flags = " -fprofile-generate=" + CLIEngine::getFlagValue(argc, argv, "-fprofile-generate");
+        } else if(!profile_use.empty()) {
+            // A raw profile straight from a run is merged first, since clang only reads merged ones
+            if(profile_use.size() > 8 && profile_use.substr(profile_use.size() - 8) == ".profraw") {
+                std::string merged = profile_use.substr(0, profile_use.size() - 8) + ".profdata";
+                // llvm-profdata is taken from the same llvm as clang, ex: clang-12 goes with llvm-profdata-12, since their profile formats have to match
+                std::string profdata = "llvm-profdata" + clang.substr(std::string("clang").size());
+                std::string merge_cmd = profdata + " merge -output=" + merged + " " + profile_use;
+                if(system(merge_cmd.c_str()) != 0) {
+                    ASTS::PrintERR(ErrorHandler::cur_file_path + " \033[0;31merror:\033[0;0m " + profdata + " couldn't merge the profile " + profile_use);
+                    return 1;
+                }
+                profile_use = merged;
+            }
+
+            // The cold blocks are split out when the machine code is laid out. llvm's IR hot/cold splitting is left off, it marks
+            // a function entered only once as cold and minsize, which slows down a hot loop in main
+            pgo_flags = " -fprofile-use=" + profile_use + " -Wno-profile-instr-unprofiled -fsplit-machine-functions";
+        }
+
+        // A profile is only used by the optimizer, so it runs at -O2 unless another level is given
+        if(!pgo_flags.empty() && opt_level.empty()) {
+            opt_level = " -O2";
+        }
+
+        std::string debug_flags = debug ? " -g" : "";
+
+        // Only linux runs ifunc resolvers when the program loads, elsewhere @multiversion functions pick their copy on the first call
+        ASTS::setTargetCPU(target_os == "linux");
+
+        if(debug) {
+            ASTS::DBuilder->finalize();
+        }
+
         if(target_os == "linux") {
-            ASTS::TheModule->setTargetTriple("x86_64-pc-linux-gnu");
             output_peko(tmpdir, filename);
-            std::string cmd = clang +  + " " + tmpdir + "/" + filename + " " + stdlibpath;
+            // The math builtins become calls into libm when they aren't inlined, and loops over them use libmvec's vector versions
+            std::string cmd = clang + opt_level + pgo_flags + debug_flags + " " + tmpdir + "/" + filename + " " + stdlibpath + " -fveclib=libmvec -lm";
             system(cmd.c_str());
         } else if(target_os == "osx") {
-            ASTS::TheModule->setTargetTriple("x86_64-apple-macosx11.3.0-macho");
             output_peko(tmpdir, filename);
-            std::string cmd = clang +  + " " + tmpdir + "/" + filename + " " + stdlibpath + " --target=x86_64-apple-darwin-macho -I " + osxtoolchain + "/MacOSX.sdk/usr/include -isysroot " + osxtoolchain + "/MacOSX.sdk -lto_library -lcrt1.o -fuse-ld=lld " + osxtoolchain + "/libclang_rt.osx.a";
+            std::string cmd = clang + opt_level + pgo_flags + debug_flags + " " + tmpdir + "/" + filename + " " + stdlibpath + " --target=x86_64-apple-darwin-macho -I " + osxtoolchain + "/MacOSX.sdk/usr/include -isysroot " + osxtoolchain + "/MacOSX.sdk -lto_library -lcrt1.o -fuse-ld=lld " + osxtoolchain + "/libclang_rt.osx.a";
             system(cmd.c_str());
         } else if(target_os == "win32") {
-            ASTS::TheModule->setTargetTriple("i686-pc-windows-msvc19.11.0");
             output_peko(tmpdir, filename);
-            std::string cmd = clang +  + " -Wno-deprecated-declarations -Wno-ignored-attributes " + tmpdir + "/" + filename + " " + stdlibpath + " -target i686-pc-win32 -fuse-ld=lld-link -I " + wintoolchain + "/include -L " + wintoolchain + "/lib";
+            std::string cmd = clang + opt_level + pgo_flags + debug_flags + " -Wno-deprecated-declarations -Wno-ignored-attributes " + tmpdir + "/" + filename + " " + stdlibpath + " -target i686-pc-win32 -fuse-ld=lld-link -I " + wintoolchain + "/include -L " + wintoolchain + "/lib";
             system(cmd.c_str());
         }
     }